@@ -37,7 +37,7 @@ struct Vector2Int {
     Vector2Int(int minIndex, int maxIndex) : x(minIndex), y(maxIndex) {}
 };
 
-std::vector<Vector2Int> FindMinMaxValues(const glm::vec3 points[], int numPoints) {
+inline std::vector<Vector2Int> FindMinMaxValues(const glm::vec3 points[], int numPoints) {
 
     Vector2Int minMaxX(0, 0), minMaxY(0, 0), minMaxZ(0, 0);
 
@@ -57,7 +57,7 @@ std::vector<Vector2Int> FindMinMaxValues(const glm::vec3 points[], int numPoints
     return { minMaxX, minMaxY, minMaxZ };
 }
 
-Vector2Int FindMostDistantPoints(const std::vector<Vector2Int>& minMaxPoints, const glm::vec3 points[]) {
+inline Vector2Int FindMostDistantPoints(const std::vector<Vector2Int>& minMaxPoints, const glm::vec3 points[]) {
     glm::vec3 xVec = points[minMaxPoints[0].y] - points[minMaxPoints[0].x];
     float xDistance = glm::dot(xVec, xVec); // squared distance
 
@@ -79,7 +79,7 @@ Vector2Int FindMostDistantPoints(const std::vector<Vector2Int>& minMaxPoints, co
 }
 
 
-Sphere BuildSphereFromPoints(const glm::vec3 points[], int numPoints, entt::entity owner = entt::null) {
+inline Sphere BuildSphereFromPoints(const glm::vec3 points[], int numPoints, entt::entity owner = entt::null) {
     auto minMaxVectors = FindMinMaxValues(points, numPoints);
     Vector2Int mostDistantPoints = FindMostDistantPoints(minMaxVectors, points);
 
@@ -93,7 +93,7 @@ Sphere BuildSphereFromPoints(const glm::vec3 points[], int numPoints, entt::enti
 }
 
 
-AABBBoundingBox BuildAABBFromSphere(const Sphere& s)
+inline AABBBoundingBox BuildAABBFromSphere(const Sphere& s)
 {
     AABBBoundingBox aabb;
     aabb.center = s.center;
@@ -0,0 +1,758 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include "Components.h"
+#include "CollisionSoA.h"
+#include "CollisionQuery.h"
+#include "ThreadPool.hpp"
+#include "ContactCache.h"
+#include "StaticCollisionWorld.h"
+#include "CollisionWorld.h"
+
+// The collision stage and its building blocks. Independent of rendering and input, so that it can
+// also run headless, e.g. in the benchmarks.
+
+inline bool SphereSphereIntersection(const glm::vec3& centerA, float radiusA, const glm::vec3& centerB, float radiusB){
+    float distanceSq = glm::distance2(centerA, centerB);
+    float radiusSum = radiusA + radiusB;
+    return distanceSq <= radiusSum * radiusSum;
+}
+
+inline entt::entity ColliderOwner(const eeng::ColliderSoA& soa, size_t index) {
+    return static_cast<entt::entity>(soa.owner[index]);
+}
+
+inline void PushCollider(
+    eeng::ColliderSoA& soa,
+    entt::entity entity,
+    const TransformComponent& tfm,
+    const SphereColliderComponent* sphere,
+    const AABBColliderComponent* box,
+    bool asleep = false)
+{
+    uint8_t flags = asleep ? eeng::ColliderIsAsleep : 0;
+    float center[3]{}, radius = 0.0f, min[3]{}, max[3]{};
+    // The sphere's layer wins when an entity has both colliders
+    const uint32_t layer = sphere ? sphere->layer : box->layer;
+    const uint32_t mask = sphere ? sphere->mask : box->mask;
+
+    if (sphere) {
+        glm::vec3 worldCenter = tfm.position + sphere->localSphere.center;
+        for (int i = 0; i < 3; ++i) center[i] = worldCenter[i];
+        radius = sphere->localSphere.radius;
+        flags |= eeng::ColliderHasSphere;
+        if (sphere->isTrigger) flags |= eeng::ColliderIsTrigger;
+    }
+    if (box) {
+        glm::vec3 worldCenter = tfm.position + box->aabb.center;
+        for (int i = 0; i < 3; ++i) {
+            min[i] = worldCenter[i] - box->aabb.halfWidths[i];
+            max[i] = worldCenter[i] + box->aabb.halfWidths[i];
+        }
+        flags |= eeng::ColliderHasAABB;
+    }
+    soa.push(entt::to_integral(entity), flags, center, radius, min, max, layer, mask);
+}
+
+// Mirrors world-space sphere and AABB colliders into SoA buffers so that the collision 
+// systems can test one collider against a whole batch at once. Static colliders are written
+// to the front of the buffers only when the static world has been invalidated; after that,
+// only the dynamic tail is rewritten each frame.
+inline void RefreshColliderSoA(entt::registry& registry, eeng::ColliderSoA& soa, StaticCollisionWorld& staticWorld)
+{
+    if (staticWorld.IsDirty()) {
+        soa.clear();
+
+        auto spheres = registry.view<TransformComponent, SphereColliderComponent, StaticColliderTag>();
+        for (auto entity : spheres) {
+            PushCollider(soa, entity,
+                spheres.get<TransformComponent>(entity),
+                &spheres.get<SphereColliderComponent>(entity),
+                registry.try_get<AABBColliderComponent>(entity));
+        }
+        auto boxes = registry.view<TransformComponent, AABBColliderComponent, StaticColliderTag>(entt::exclude<SphereColliderComponent>);
+        for (auto entity : boxes) {
+            PushCollider(soa, entity, boxes.get<TransformComponent>(entity), nullptr, &boxes.get<AABBColliderComponent>(entity));
+        }
+
+        std::vector<PlaneColliderComponent> planes;
+        auto planeView = registry.view<PlaneColliderComponent>();
+        for (auto entity : planeView) {
+            planes.push_back(planeView.get<PlaneColliderComponent>(entity));
+        }
+
+        std::vector<StaticCollisionWorld::StaticMesh> meshes;
+        auto meshView = registry.view<MeshColliderComponent>();
+        for (auto entity : meshView) {
+            const auto& collider = meshView.get<MeshColliderComponent>(entity);
+            if (!collider.bvh || collider.bvh->empty()) continue;
+            StaticCollisionWorld::StaticMesh mesh;
+            mesh.entity = entity;
+            mesh.bvh = collider.bvh;
+            mesh.layer = collider.layer;
+            meshes.push_back(mesh);
+        }
+
+        std::vector<StaticCollisionWorld::StaticHeightfield> heightfields;
+        auto fieldView = registry.view<HeightfieldColliderComponent>();
+        for (auto entity : fieldView) {
+            const auto& collider = fieldView.get<HeightfieldColliderComponent>(entity);
+            if (!collider.heightfield || collider.heightfield->empty()) continue;
+            StaticCollisionWorld::StaticHeightfield field;
+            field.entity = entity;
+            field.heightfield = collider.heightfield;
+            field.layer = collider.layer;
+            heightfields.push_back(field);
+        }
+
+        staticWorld.Build(soa, soa.count, planes, std::move(meshes), std::move(heightfields));
+    }
+    else {
+        soa.shrink(staticWorld.StaticCount());
+    }
+
+    auto spheres = registry.view<TransformComponent, SphereColliderComponent>(entt::exclude<StaticColliderTag>);
+    for (auto entity : spheres) {
+        PushCollider(soa, entity,
+            spheres.get<TransformComponent>(entity),
+            &spheres.get<SphereColliderComponent>(entity),
+            registry.try_get<AABBColliderComponent>(entity),
+            registry.all_of<SleepingTag>(entity));
+    }
+
+    auto boxes = registry.view<TransformComponent, AABBColliderComponent>(entt::exclude<SphereColliderComponent, StaticColliderTag>);
+    for (auto entity : boxes) {
+        PushCollider(soa, entity, boxes.get<TransformComponent>(entity), nullptr, &boxes.get<AABBColliderComponent>(entity),
+            registry.all_of<SleepingTag>(entity));
+    }
+
+    soa.pad();
+}
+
+// Samples the lowest surface of a mesh collider on a grid with the given cell size, by casting rays up from
+// below the mesh. Taking the lowest surface keeps overhanging geometry such as tree crowns out of the terrain.
+// Grid points with no surface above them get the lowest sampled height.
+inline std::shared_ptr<const eeng::Heightfield> BuildHeightfieldFromMesh(const eeng::TriangleMeshBVH& bvh, float cellSize)
+{
+    auto field = std::make_shared<eeng::Heightfield>();
+    if (bvh.empty()) return field;
+
+    float min[3], max[3];
+    bvh.bounds(min, max);
+    const size_t columns = static_cast<size_t>(std::ceil((max[0] - min[0]) / cellSize)) + 1;
+    const size_t rows = static_cast<size_t>(std::ceil((max[2] - min[2]) / cellSize)) + 1;
+    const float height = max[1] - min[1] + 2.0f;
+    const float up[3]{ 0.0f, 1.0f, 0.0f };
+
+    std::vector<float> heights(columns * rows);
+    std::vector<uint8_t> hit(columns * rows, 0);
+    float lowest = max[1];
+    for (size_t j = 0; j < rows; ++j) {
+        for (size_t i = 0; i < columns; ++i) {
+            const float o[3]{ min[0] + i * cellSize, min[1] - 1.0f, min[2] + j * cellSize };
+            eeng::TriangleHit triangleHit;
+            if (!bvh.raycast(o, up, height, triangleHit)) continue;
+            heights[j * columns + i] = o[1] + triangleHit.t;
+            hit[j * columns + i] = 1;
+            lowest = std::min(lowest, o[1] + triangleHit.t);
+        }
+    }
+    for (size_t k = 0; k < heights.size(); ++k)
+        if (!hit[k]) heights[k] = lowest;
+
+    field->build(heights.data(), columns, rows, min[0], min[2], cellSize);
+    return field;
+}
+
+inline bool TestAABBAABB(const AABBBoundingBox& a, const AABBBoundingBox& b)
+{
+    float centerDiff = std::abs(a.center[0] - b.center[0]);
+    float compoundedWidth = a.halfWidths[0] + b.halfWidths[0];
+    if (centerDiff > compoundedWidth)
+        return false;
+
+    centerDiff = std::abs(a.center[1] - b.center[1]);
+    compoundedWidth = a.halfWidths[1] + b.halfWidths[1];
+    if (centerDiff > compoundedWidth)
+        return false;
+
+    centerDiff = std::abs(a.center[2] - b.center[2]);
+    compoundedWidth = a.halfWidths[2] + b.halfWidths[2];
+    if (centerDiff > compoundedWidth)
+        return false;
+
+    return true;
+}
+
+inline bool TestAABBPlane(const AABBBoundingBox& aabb, const glm::vec3& planePoint, const glm::vec3& planeNormal)
+{
+    float r =
+        aabb.halfWidths[0] * std::abs(glm::dot(glm::vec3(1, 0, 0), planeNormal)) +
+        aabb.halfWidths[1] * std::abs(glm::dot(glm::vec3(0, 1, 0), planeNormal)) +
+        aabb.halfWidths[2] * std::abs(glm::dot(glm::vec3(0, 0, 1), planeNormal));
+
+    float s = glm::dot(planeNormal, aabb.center - planePoint);
+
+    return std::abs(s) <= r;
+}
+
+
+// Overlapping collider pair found by the narrowphase
+struct ColliderContact {
+    uint32_t a, b;          // SoA indices, a < b
+    uint8_t flags;          // ContactFlags
+    glm::vec3 separation;   // XZ-plane penetration, pointing from a to b. Zero for trigger pairs.
+};
+
+enum ContactFlags : uint8_t {
+    ContactTouching = 0x1,      // The colliders collide and the pair is resolved
+    ContactBoxesOverlap = 0x2   // Both colliders have an AABB and the boxes overlap
+};
+
+// Narrowphase test for one combination of collider shapes. Returns ContactFlags, zero if the pair is apart,
+// and sets separation to the XZ-plane translation of b that would separate it from a.
+using NarrowphaseTest = uint8_t(*)(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b, glm::vec3& separation);
+
+inline glm::vec3 ColliderSphereCenter(const eeng::ColliderSoA& soa, size_t i) {
+    return { soa.center_x[i], soa.center_y[i], soa.center_z[i] };
+}
+
+inline glm::vec3 ColliderBoxMin(const eeng::ColliderSoA& soa, size_t i) {
+    return { soa.min_x[i], soa.min_y[i], soa.min_z[i] };
+}
+
+inline glm::vec3 ColliderBoxMax(const eeng::ColliderSoA& soa, size_t i) {
+    return { soa.max_x[i], soa.max_y[i], soa.max_z[i] };
+}
+
+inline uint8_t NarrowSphereSphere(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b, glm::vec3& separation) {
+    const glm::vec3 centerA = ColliderSphereCenter(soa, a), centerB = ColliderSphereCenter(soa, b);
+    if (!SphereSphereIntersection(centerA, soa.radius[a], centerB, soa.radius[b])) return 0;
+
+    glm::vec3 delta = centerB - centerA;
+    delta.y = 0.0f;
+    float dist = glm::length(delta);
+    float minDist = soa.radius[a] + soa.radius[b];
+    if (dist > 0.0001f && dist < minDist)
+        separation = (delta / dist) * (minDist - dist);
+    return ContactTouching;
+}
+
+// Sphere a against box b, using the point of the box closest to the sphere center
+inline uint8_t NarrowSphereAABB(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b, glm::vec3& separation) {
+    const glm::vec3 center = ColliderSphereCenter(soa, a);
+    const glm::vec3 closest = glm::clamp(center, ColliderBoxMin(soa, b), ColliderBoxMax(soa, b));
+    const float radius = soa.radius[a];
+    if (glm::distance2(center, closest) > radius * radius) return 0;
+
+    glm::vec3 delta = closest - center;
+    delta.y = 0.0f;
+    float dist = glm::length(delta);
+    if (dist > 0.0001f && dist < radius)
+        separation = (delta / dist) * (radius - dist);
+    return ContactTouching;
+}
+
+inline uint8_t NarrowAABBSphere(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b, glm::vec3& separation) {
+    const uint8_t flags = NarrowSphereAABB(soa, b, a, separation);
+    separation = -separation;
+    return flags;
+}
+
+// Box against box, separated along the XZ axis of least penetration
+inline uint8_t NarrowAABBAABB(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b, glm::vec3& separation) {
+    if (!eeng::overlap_aabbs_scalar(eeng::ColliderLanes(soa, b), eeng::ColliderQuery::from(soa, a), 1)) return 0;
+
+    const glm::vec3 minA = ColliderBoxMin(soa, a), maxA = ColliderBoxMax(soa, a);
+    const glm::vec3 minB = ColliderBoxMin(soa, b), maxB = ColliderBoxMax(soa, b);
+    const glm::vec3 overlap = glm::min(maxA, maxB) - glm::max(minA, minB);
+    const glm::vec3 delta = (minB + maxB) - (minA + maxA);
+    const int axis = overlap.x < overlap.z ? 0 : 2;
+    separation[axis] = delta[axis] < 0.0f ? -overlap[axis] : overlap[axis];
+    return ContactTouching | ContactBoxesOverlap;
+}
+
+// Both colliders have a sphere and an AABB: they collide when both shapes overlap, and are separated by their spheres
+inline uint8_t NarrowCompound(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b, glm::vec3& separation) {
+    if (!eeng::overlap_aabbs_scalar(eeng::ColliderLanes(soa, b), eeng::ColliderQuery::from(soa, a), 1)) return 0;
+    return ContactBoxesOverlap | NarrowSphereSphere(soa, a, b, separation);
+}
+
+// Narrowphase tests indexed by the shape bits (ColliderHasSphere | ColliderHasAABB) of a and b, minus one
+constexpr NarrowphaseTest NarrowphaseTable[3][3] = {
+    //  b: sphere           AABB              sphere + AABB
+    { NarrowSphereSphere, NarrowSphereAABB, NarrowSphereSphere },  // a: sphere
+    { NarrowAABBSphere,   NarrowAABBAABB,   NarrowAABBAABB },      // a: AABB
+    { NarrowSphereSphere, NarrowAABBAABB,   NarrowCompound },      // a: sphere + AABB
+};
+
+inline NarrowphaseTest NarrowphaseFor(const eeng::ColliderSoA& soa, uint32_t a, uint32_t b) {
+    constexpr uint8_t shapeBits = eeng::ColliderHasSphere | eeng::ColliderHasAABB;
+    return NarrowphaseTable[(soa.flags[a] & shapeBits) - 1][(soa.flags[b] & shapeBits) - 1];
+}
+
+// Pairs per narrowphase task. Fixed so that chunk boundaries, and thereby the merged contact order, do not depend on the thread count.
+constexpr size_t NarrowphaseChunkSize = 128;
+
+// Tests candidate pairs (sorted on a, then b) in parallel and appends the colliding ones to contacts, in pair order.
+// Reads only the SoA, so it is safe to run on worker threads.
+inline void NarrowphaseContacts(
+    const eeng::ColliderSoA& soa,
+    const std::vector<std::pair<uint32_t, uint32_t>>& pairs,
+    eeng::ThreadPool& threadPool,
+    std::vector<ColliderContact>& contacts)
+{
+    const size_t chunkCount = (pairs.size() + NarrowphaseChunkSize - 1) / NarrowphaseChunkSize;
+    std::vector<std::vector<ColliderContact>> chunkContacts(chunkCount);
+
+    threadPool.parallel_for(pairs.size(), NarrowphaseChunkSize, [&](size_t begin, size_t end, size_t chunk) {
+        auto& out = chunkContacts[chunk];
+        for (size_t p = begin; p < end; ++p) {
+            const auto [a, b] = pairs[p];
+            glm::vec3 separation(0.0f);
+            const uint8_t flags = NarrowphaseFor(soa, a, b)(soa, a, b, separation);
+            if (!flags) continue;
+            if ((soa.flags[a] | soa.flags[b]) & eeng::ColliderIsTrigger) separation = glm::vec3(0.0f);
+            out.push_back({ a, b, flags, separation });
+        }
+    });
+
+    for (auto& chunk : chunkContacts)
+        contacts.insert(contacts.end(), chunk.begin(), chunk.end());
+}
+
+// Per-collider outcome of the narrowphase, written to the collider components in one go
+enum ColliderResultFlags : uint8_t {
+    ResultSphereContact = 0x1,  // SphereColliderComponent::sphereCollissionTriggered
+    ResultPlaneContact = 0x2,   // SphereColliderComponent::planeCollissionTriggered, set by planes, meshes and heightfields
+    ResultBoxContact = 0x4      // AABBColliderComponent::collissionTriggered
+};
+
+// Tests every collider against the planes, triangle meshes and heightfields near it, in parallel, and records the
+// result in results. Heightfields are tested below the center of the sphere or box only.
+inline void StaticGeometryContacts(
+    const eeng::ColliderSoA& soa,
+    const StaticCollisionWorld& staticWorld,
+    eeng::ThreadPool& threadPool,
+    std::vector<uint8_t>& results)
+{
+    threadPool.parallel_for(soa.count, NarrowphaseChunkSize, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            if (soa.flags[i] & eeng::ColliderIsAsleep) continue;
+            if (soa.flags[i] & eeng::ColliderHasSphere) {
+                const glm::vec3 center = ColliderSphereCenter(soa, i);
+                const float radius = soa.radius[i];
+                staticWorld.QueryPlanes(center, glm::vec3(radius), [&](const PlaneColliderComponent& plane) {
+                    if (std::abs(glm::dot(plane.normal, center - plane.position)) <= radius)
+                        results[i] |= ResultPlaneContact;
+                });
+                const float c[3]{ center.x, center.y, center.z };
+                const float min[3]{ c[0] - radius, c[1] - radius, c[2] - radius }, max[3]{ c[0] + radius, c[1] + radius, c[2] + radius };
+                staticWorld.QueryMeshes(min, max, [&](const StaticCollisionWorld::StaticMesh& mesh) {
+                    if ((mesh.layer & soa.mask[i]) && mesh.bvh->overlaps_sphere(c, radius))
+                        results[i] |= ResultPlaneContact;
+                });
+                for (const auto& field : staticWorld.Heightfields()) {
+                    if ((field.layer & soa.mask[i]) && field.heightfield->contains(c[0], c[2]) &&
+                        c[1] - radius <= field.heightfield->height(c[0], c[2]))
+                        results[i] |= ResultPlaneContact;
+                }
+            }
+            if (soa.flags[i] & eeng::ColliderHasAABB) {
+                const glm::vec3 min = ColliderBoxMin(soa, i), max = ColliderBoxMax(soa, i);
+                const glm::vec3 halfWidths = (max - min) * 0.5f;
+                const AABBBoundingBox aabb((min + max) * 0.5f, halfWidths.x, halfWidths.y, halfWidths.z);
+                staticWorld.QueryPlanes(aabb.center, halfWidths, [&](const PlaneColliderComponent& plane) {
+                    if (TestAABBPlane(aabb, plane.position, plane.normal))
+                        results[i] |= ResultBoxContact;
+                });
+                const float bmin[3]{ min.x, min.y, min.z }, bmax[3]{ max.x, max.y, max.z };
+                staticWorld.QueryMeshes(bmin, bmax, [&](const StaticCollisionWorld::StaticMesh& mesh) {
+                    if ((mesh.layer & soa.mask[i]) && mesh.bvh->overlaps_aabb(bmin, bmax))
+                        results[i] |= ResultBoxContact;
+                });
+                for (const auto& field : staticWorld.Heightfields()) {
+                    if ((field.layer & soa.mask[i]) && field.heightfield->contains(aabb.center.x, aabb.center.z) &&
+                        bmin[1] <= field.heightfield->height(aabb.center.x, aabb.center.z))
+                        results[i] |= ResultBoxContact;
+                }
+            }
+        }
+    });
+}
+
+// Rebuilds the tree over the bounds of the dynamic colliders, the SoA entries after the statics. Sleeping colliders
+// are included, so that the colliders that are awake still find them.
+inline void BuildDynamicTree(const eeng::ColliderSoA& soa, size_t staticCount, DynamicColliderTree& dynamic)
+{
+    const size_t n = soa.count - staticCount;
+    for (auto& axis : dynamic.bounds) axis.resize(n);
+    dynamic.ids.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        float min[3], max[3];
+        soa.bounds(staticCount + k, min, max);
+        for (int a = 0; a < 3; ++a) {
+            dynamic.bounds[a][k] = min[a];
+            dynamic.bounds[3 + a][k] = max[a];
+        }
+        dynamic.ids[k] = static_cast<uint32_t>(staticCount + k);
+    }
+    dynamic.tree.build(
+        dynamic.bounds[0].data(), dynamic.bounds[1].data(), dynamic.bounds[2].data(),
+        dynamic.bounds[3].data(), dynamic.bounds[4].data(), dynamic.bounds[5].data(),
+        n, dynamic.ids.data());
+}
+
+// Candidate pairs (a, b), a < b, sorted and unique. Dynamic colliders are paired through the dynamic tree, which must
+// be built over their current bounds, and with static colliders through the static world. Sleeping colliders start
+// no queries, so they are only paired with colliders that are awake; CollisionSystem keeps the contacts between
+// sleeping ones from before they fell asleep. Layer filtering happens here, before any narrowphase work.
+inline void CollectCandidatePairs(
+    const eeng::ColliderSoA& soa,
+    const StaticCollisionWorld& staticWorld,
+    const DynamicColliderTree& dynamic,
+    std::unordered_map<entt::entity, int>& candidateCounts,
+    std::vector<std::pair<uint32_t, uint32_t>>& pairs)
+{
+    candidateCounts.clear();
+    pairs.clear();
+
+    const size_t staticCount = staticWorld.StaticCount();
+    for (size_t i = staticCount; i < soa.count; ++i) {
+        const uint32_t a = static_cast<uint32_t>(i);
+        if (soa.flags[a] & eeng::ColliderIsAsleep) continue;
+        int candidateCount = 0;
+        float min[3], max[3];
+        soa.bounds(a, min, max);
+
+        // A pair of awake colliders is found from both sides and stored once, from the lower index
+        dynamic.tree.query(min, max, [&](uint32_t b) {
+            if (a == b || !soa.layers_interact(a, b)) return;
+            candidateCount++;
+            if (a < b || (soa.flags[b] & eeng::ColliderIsAsleep))
+                pairs.emplace_back(std::min(a, b), std::max(a, b));
+        });
+
+        // Static indices are below any dynamic index, so the pair is already ordered
+        staticWorld.QueryColliders(min, max, [&](uint32_t b) {
+            if (!soa.layers_interact(a, b)) return;
+            candidateCount++;
+            pairs.emplace_back(b, a);
+        });
+
+        candidateCounts[ColliderOwner(soa, a)] = candidateCount;
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+}
+
+// Pushes colliding bodies apart with the world's contact solver. Contacts are ordered on their entity pair first,
+// so the outcome depends neither on the order in which the registry stores entities nor on the thread count.
+// Static colliders stay put. Transforms and the SoA mirror are both updated, for scene queries later in the frame.
+inline void SolveContacts(entt::registry& registry, CollisionWorld& world, const std::vector<ColliderContact>& contacts, eeng::ThreadPool& threadPool)
+{
+    auto& soa = world.soa;
+    const size_t staticCount = world.staticWorld.StaticCount();
+
+    // Trigger pairs have a zero separation and are left out
+    std::vector<std::pair<ContactPairCache::Key, const ColliderContact*>> ordered;
+    for (const auto& contact : contacts) {
+        if ((contact.flags & ContactTouching) && contact.separation != glm::vec3(0.0f))
+            ordered.emplace_back(ContactPairCache::MakeKey(ColliderOwner(soa, contact.a), ColliderOwner(soa, contact.b)), &contact);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    // Solver bodies are numbered in contact order
+    std::vector<uint32_t> bodyOfCollider(soa.count, UINT32_MAX);
+    std::vector<uint32_t> colliderOfBody;
+    std::vector<float> invMass;
+    auto bodyIndex = [&](uint32_t i) {
+        if (bodyOfCollider[i] == UINT32_MAX) {
+            bodyOfCollider[i] = static_cast<uint32_t>(colliderOfBody.size());
+            colliderOfBody.push_back(i);
+            invMass.push_back(i < staticCount ? 0.0f : 1.0f);
+        }
+        return bodyOfCollider[i];
+    };
+
+    std::vector<eeng::SolverContact> solverContacts;
+    solverContacts.reserve(ordered.size());
+    for (const auto& [key, contact] : ordered) {
+        const float depth = glm::length(contact->separation);
+        const glm::vec3 normal = contact->separation / depth;
+        solverContacts.push_back({ bodyIndex(contact->a), bodyIndex(contact->b), { normal.x, normal.y, normal.z }, depth });
+    }
+
+    world.solver.prepare(solverContacts.data(), solverContacts.size(), invMass.data(), invMass.size());
+    std::vector<float> displacement(3 * colliderOfBody.size());
+    world.solver.solve(displacement.data(), &threadPool);
+
+    for (size_t k = 0; k < colliderOfBody.size(); ++k) {
+        if (invMass[k] == 0.0f) continue;
+        const float* d = &displacement[3 * k];
+        registry.get<TransformComponent>(ColliderOwner(soa, colliderOfBody[k])).position += glm::vec3(d[0], d[1], d[2]);
+        soa.translate(colliderOfBody[k], d[0], d[1], d[2]);
+    }
+    world.stats.solverBatches = world.solver.batch_count();
+}
+
+// Contacts with mesh triangles whose contact normal is steeper than this (|normal.y| below it) are walls.
+// Flatter contacts are left to GroundingSystem.
+constexpr float MeshWallNormalY = 0.7f;
+constexpr int MeshWallIterations = 3;
+
+// Pushes awake, non-trigger dynamic spheres horizontally out of mesh walls, in parallel. Each pass moves the
+// sphere out of its deepest wall contact, so that corners made of several triangles are not pushed twice.
+inline void ResolveMeshContacts(entt::registry& registry, CollisionWorld& world, eeng::ThreadPool& threadPool)
+{
+    auto& soa = world.soa;
+    const auto& staticWorld = world.staticWorld;
+    if (staticWorld.Meshes().empty()) return;
+
+    const size_t staticCount = staticWorld.StaticCount();
+    threadPool.parallel_for(soa.count - staticCount, NarrowphaseChunkSize, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = staticCount + begin; i < staticCount + end; ++i) {
+            const uint8_t flags = soa.flags[i];
+            if ((flags & (eeng::ColliderIsAsleep | eeng::ColliderIsTrigger)) || !(flags & eeng::ColliderHasSphere)) continue;
+
+            const float radius = soa.radius[i];
+            const glm::vec3 start = ColliderSphereCenter(soa, i);
+            glm::vec3 center = start;
+            for (int it = 0; it < MeshWallIterations; ++it) {
+                const float c[3]{ center.x, center.y, center.z };
+                const float min[3]{ c[0] - radius, c[1] - radius, c[2] - radius }, max[3]{ c[0] + radius, c[1] + radius, c[2] + radius };
+                glm::vec3 push(0.0f);
+                staticWorld.QueryMeshes(min, max, [&](const StaticCollisionWorld::StaticMesh& mesh) {
+                    if (!(mesh.layer & soa.mask[i])) return;
+                    mesh.bvh->query_sphere(c, radius, [&](uint32_t, const float closest[3]) {
+                        const glm::vec3 offset = center - glm::vec3(closest[0], closest[1], closest[2]);
+                        const float distance = glm::length(offset);
+                        if (distance <= 0.0f || std::abs(offset.y) >= MeshWallNormalY * distance) return;
+                        glm::vec3 horizontal(offset.x, 0.0f, offset.z);
+                        horizontal *= (radius - distance) / glm::length(horizontal);
+                        if (glm::length2(horizontal) > glm::length2(push)) push = horizontal;
+                    });
+                });
+                if (push == glm::vec3(0.0f)) break;
+                center += push;
+            }
+
+            const glm::vec3 d = center - start;
+            if (d == glm::vec3(0.0f)) continue;
+            registry.get<TransformComponent>(ColliderOwner(soa, i)).position += d;
+            soa.translate(i, d.x, d.y, d.z);
+        }
+    });
+}
+
+// Distance kept between a swept body and the surface it stopped at, so that it starts the next sweep outside it
+constexpr float ContinuousSkin = 0.01f;
+
+// Continuous collision for bodies with a ContinuousCollisionComponent whose sphere moved further than its radius
+// since the last collision stage, which is where the discrete tests start to miss thin colliders. Each such move is
+// swept as a sphere-cast from the previous position against colliders, planes and mesh walls, in parallel, and the
+// body is moved back to the first time of impact. Its velocity into the surface is removed; the discrete tests that
+// follow then see the contact. Colliders the sphere already touches at the start are left to those tests too.
+// Dynamic colliders are swept against at their current positions, found through world.dynamicTree, which must be
+// built over them. Mesh walls are swept with the ray of the sphere center, which catches every wall the sphere would
+// otherwise pass through.
+inline void ContinuousCollisions(entt::registry& registry, CollisionWorld& world, eeng::ThreadPool& threadPool)
+{
+    auto& soa = world.soa;
+    const auto& staticWorld = world.staticWorld;
+    const size_t staticCount = staticWorld.StaticCount();
+
+    struct Sweep {
+        uint32_t collider;
+        glm::vec3 start;        // Sphere center at the previous position
+        glm::vec3 direction;    // Unit direction of the move
+        float length;
+        float t;                // Time of impact, length if nothing was hit
+        glm::vec3 normal;       // Surface normal at the time of impact
+    };
+    std::vector<Sweep> sweeps;
+    for (size_t i = staticCount; i < soa.count; ++i) {
+        const uint8_t flags = soa.flags[i];
+        if ((flags & (eeng::ColliderIsAsleep | eeng::ColliderIsTrigger)) || !(flags & eeng::ColliderHasSphere)) continue;
+        const auto* ccd = registry.try_get<ContinuousCollisionComponent>(ColliderOwner(soa, i));
+        if (!ccd || !ccd->hasPreviousPosition) continue;
+
+        const glm::vec3 move = registry.get<TransformComponent>(ColliderOwner(soa, i)).position - ccd->previousPosition;
+        const float length = glm::length(move);
+        if (length <= soa.radius[i]) continue;
+        sweeps.push_back({ static_cast<uint32_t>(i), ColliderSphereCenter(soa, i) - move, move / length, length, length, glm::vec3(0.0f) });
+    }
+    world.stats.sweptBodies = sweeps.size();
+    world.stats.sweptHits = 0;
+    if (sweeps.empty()) return;
+
+    threadPool.parallel_for(sweeps.size(), 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t k = begin; k < end; ++k) {
+            Sweep& sweep = sweeps[k];
+            const uint32_t i = sweep.collider;
+            const float radius = soa.radius[i];
+            const float o[3]{ sweep.start.x, sweep.start.y, sweep.start.z };
+            const float d[3]{ sweep.direction.x, sweep.direction.y, sweep.direction.z };
+            const eeng::RayQuery q = eeng::RayQuery::make(o, d, sweep.length, radius);
+            auto pointAt = [&](float t) { return sweep.start + sweep.direction * t; };
+
+            // Normal from the closest point of collider j to the sphere center at the time of impact
+            auto hitCollider = [&](uint32_t j) {
+                if (j == i || !soa.layers_interact(i, j) || (soa.flags[j] & eeng::ColliderIsTrigger)) return;
+                float t;
+                if (!eeng::sphere_cast_collider(soa, j, q, t) || t <= 0.0f || t >= sweep.t) return;
+                const glm::vec3 p = pointAt(t);
+                glm::vec3 closest = ColliderSphereCenter(soa, j);
+                if (soa.flags[j] & eeng::ColliderHasAABB) {
+                    const glm::vec3 boxClosest = glm::clamp(p, ColliderBoxMin(soa, j), ColliderBoxMax(soa, j));
+                    if (!(soa.flags[j] & eeng::ColliderHasSphere) || glm::distance2(p, boxClosest) < glm::distance2(p, closest))
+                        closest = boxClosest;
+                }
+                const glm::vec3 offset = p - closest;
+                sweep.t = t;
+                sweep.normal = glm::length2(offset) > 0.0f ? glm::normalize(offset) : -sweep.direction;
+            };
+
+            staticWorld.RaycastColliders(q.o, q.inv_d, sweep.length, radius, [&](uint32_t j, float tMax) {
+                hitCollider(j);
+                return std::min(tMax, sweep.t);
+            });
+
+            const glm::vec3 end = pointAt(sweep.length);
+            const glm::vec3 sweptMin = glm::min(sweep.start, end) - glm::vec3(radius), sweptMax = glm::max(sweep.start, end) + glm::vec3(radius);
+            const float sweptMinArray[3]{ sweptMin.x, sweptMin.y, sweptMin.z }, sweptMaxArray[3]{ sweptMax.x, sweptMax.y, sweptMax.z };
+            world.dynamicTree.tree.query(sweptMinArray, sweptMaxArray, hitCollider);
+
+            staticWorld.QueryPlanes((sweep.start + end) * 0.5f, (sweptMax - sweptMin) * 0.5f, [&](const PlaneColliderComponent& plane) {
+                const float point[3]{ plane.position.x, plane.position.y, plane.position.z };
+                const float normal[3]{ plane.normal.x, plane.normal.y, plane.normal.z };
+                float t;
+                if (!eeng::sphere_cast_plane(q, point, normal, t) || t <= 0.0f || t >= sweep.t) return;
+                sweep.t = t;
+                sweep.normal = glm::dot(plane.normal, sweep.start - plane.position) >= 0.0f ? plane.normal : -plane.normal;
+            });
+
+            staticWorld.QueryMeshes(sweptMinArray, sweptMaxArray, [&](const StaticCollisionWorld::StaticMesh& mesh) {
+                eeng::TriangleHit hit;
+                if (!(mesh.layer & soa.mask[i]) || !mesh.bvh->raycast(o, d, sweep.length, hit)) return;
+                const glm::vec3 normal(hit.normal[0], hit.normal[1], hit.normal[2]);
+                if (std::abs(normal.y) >= MeshWallNormalY) return;
+                // Back off along the ray until the sphere just touches the triangle's plane
+                const float t = std::max(0.0f, hit.t - radius / std::max(-glm::dot(sweep.direction, normal), 1e-3f));
+                if (t >= sweep.t) return;
+                sweep.t = t;
+                sweep.normal = normal;
+            });
+        }
+    });
+
+    for (const Sweep& sweep : sweeps) {
+        if (sweep.t >= sweep.length) continue;
+        world.stats.sweptHits++;
+        const uint32_t i = sweep.collider;
+        const entt::entity entity = ColliderOwner(soa, i);
+        const glm::vec3 d = sweep.direction * (std::max(0.0f, sweep.t - ContinuousSkin) - sweep.length);
+        registry.get<TransformComponent>(entity).position += d;
+        soa.translate(i, d.x, d.y, d.z);
+        if (auto* velocity = registry.try_get<LinearVelocityComponent>(entity))
+            velocity->velocity -= std::min(0.0f, glm::dot(velocity->velocity, sweep.normal)) * sweep.normal;
+    }
+}
+
+// Where the next sweep of each continuous body starts
+inline void RecordSweepStarts(entt::registry& registry) {
+    auto view = registry.view<TransformComponent, ContinuousCollisionComponent>();
+    for (auto entity : view) {
+        auto& ccd = view.get<ContinuousCollisionComponent>(entity);
+        ccd.previousPosition = view.get<TransformComponent>(entity).position;
+        ccd.hasPreviousPosition = true;
+    }
+}
+
+// The collision stage: gathers world-space colliders once, sweeps fast movers, runs the broadphase once, dispatches candidate
+// pairs to the narrowphase for their shapes, tests colliders against planes and meshes, and finally writes trigger
+// flags, updates the contact cache and resolves contacts. The whole stage is timed in world.stats.
+inline void CollisionSystem(entt::registry& registry, CollisionWorld& world, eeng::ThreadPool& threadPool)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto& soa = world.soa;
+
+    // Gather
+    RefreshColliderSoA(registry, soa, world.staticWorld);
+
+    BuildDynamicTree(soa, world.staticWorld.StaticCount(), world.dynamicTree);
+
+    // Sweep fast movers back to their first impact, before any discrete test. Bodies that were moved back need
+    // their new bounds in the tree for the broadphase.
+    ContinuousCollisions(registry, world, threadPool);
+    if (world.stats.sweptHits)
+        BuildDynamicTree(soa, world.staticWorld.StaticCount(), world.dynamicTree);
+
+    // Broadphase
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    CollectCandidatePairs(soa, world.staticWorld, world.dynamicTree, world.candidateCounts, pairs);
+
+    // Narrowphase
+    std::vector<ColliderContact> contacts;
+    NarrowphaseContacts(soa, pairs, threadPool, contacts);
+
+    std::vector<uint8_t> results(soa.count, 0);
+    StaticGeometryContacts(soa, world.staticWorld, threadPool, results);
+
+    auto markContact = [&](uint32_t i, uint8_t contactFlags) {
+        if ((contactFlags & ContactTouching) && (soa.flags[i] & eeng::ColliderHasSphere)) results[i] |= ResultSphereContact;
+        if ((contactFlags & ContactTouching) && (soa.flags[i] & eeng::ColliderHasAABB)) results[i] |= ResultBoxContact;
+        if (contactFlags & ContactBoxesOverlap) results[i] |= ResultBoxContact;
+    };
+    for (const auto& contact : contacts) {
+        markContact(contact.a, contact.flags);
+        markContact(contact.b, contact.flags);
+    }
+
+    // Write results, which also clears the flags of colliders without contacts. Sleeping colliders keep theirs.
+    for (size_t i = 0; i < soa.count; ++i) {
+        if (soa.flags[i] & eeng::ColliderIsAsleep) continue;
+        const entt::entity entity = ColliderOwner(soa, i);
+        if (soa.flags[i] & eeng::ColliderHasSphere) {
+            auto& collider = registry.get<SphereColliderComponent>(entity);
+            collider.sphereCollissionTriggered = results[i] & ResultSphereContact;
+            collider.planeCollissionTriggered = results[i] & ResultPlaneContact;
+        }
+        if (soa.flags[i] & eeng::ColliderHasAABB) {
+            registry.get<AABBColliderComponent>(entity).collissionTriggered = results[i] & ResultBoxContact;
+        }
+    }
+
+    world.contacts.BeginFrame();
+    for (const auto& contact : contacts) {
+        if (contact.flags & ContactTouching)
+            world.contacts.Add(ColliderOwner(soa, contact.a), ColliderOwner(soa, contact.b));
+    }
+    // Nothing tests a pair of which neither side is awake, so such pairs stay in contact until one of them wakes.
+    // Sleeping islands keep their links, and no end and begin events are sent when bodies fall asleep and wake.
+    auto sleeping = [&](entt::entity e) { return registry.valid(e) && registry.all_of<SleepingTag>(e); };
+    auto resting = [&](entt::entity e) { return sleeping(e) || (registry.valid(e) && registry.all_of<StaticColliderTag>(e)); };
+    world.contacts.CarryOver([&](entt::entity a, entt::entity b) {
+        return (sleeping(a) || sleeping(b)) && resting(a) && resting(b);
+    });
+    world.contacts.EndFrame();
+
+    // Resolve
+    SolveContacts(registry, world, contacts, threadPool);
+    ResolveMeshContacts(registry, world, threadPool);
+    RecordSweepStarts(registry);
+
+    world.stats.colliders = soa.count;
+    world.stats.candidatePairs = pairs.size();
+    world.stats.contacts = contacts.size();
+    world.stats.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
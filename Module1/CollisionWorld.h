@@ -0,0 +1,48 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <unordered_map>
+#include <vector>
+#include "CollisionSoA.h"
+#include "ContactSolver.h"
+#include "ContactCache.h"
+#include "StaticCollisionWorld.h"
+#include "AABBTree.h"
+
+// Dynamic colliders in a bounding volume hierarchy, rebuilt each frame by BuildDynamicTree, and once more
+// after CCD moves colliders. A full median-split rebuild is preferred over refitting last frame's nodes:
+// most dynamic colliders move every frame, and refitted boxes keep growing as colliders drift apart
+// from their siblings. A rebuild keeps the tree tight for the O(n log n) of a sort.
+struct DynamicColliderTree {
+    eeng::AABBTree tree;
+    // Scratch for the rebuild, kept so that a scene of the same size allocates nothing
+    std::vector<float> bounds[6];
+    std::vector<uint32_t> ids;
+};
+
+// Everything the collision stage keeps between frames
+struct CollisionWorld {
+    // World-space colliders in SoA layout, statics first, refreshed each frame
+    eeng::ColliderSoA soa;
+    // Static colliders and planes, rebuilt only when invalidated
+    StaticCollisionWorld staticWorld;
+    // Dynamic colliders, for the broadphase and continuous collision
+    DynamicColliderTree dynamicTree;
+    // Pairs in contact last frame, diffed into begin/stay/end events
+    ContactPairCache contacts;
+    // Position solver for the contacts of each frame
+    eeng::ContactSolver solver;
+    // Broadphase candidates per dynamic collider, after layer filtering
+    std::unordered_map<entt::entity, int> candidateCounts;
+
+    // Cost of the last run of the collision stage
+    struct Stats {
+        size_t colliders = 0;
+        size_t candidatePairs = 0;
+        size_t contacts = 0;
+        size_t solverBatches = 0;
+        size_t sweptBodies = 0;
+        size_t sweptHits = 0;
+        float milliseconds = 0.0f;
+    } stats;
+};
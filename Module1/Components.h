@@ -7,22 +7,47 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <memory>
-#include "../src/RenderableMesh.hpp"
+#include <cmath>
+#include "../src/TriangleMeshBVH.h"
+#include "../src/Heightfield.h"
+#include "../src/AssetRegistry.h"
 #include "CollisionGeometry.h"
 
+namespace eeng { class RenderableMesh; }
+
+using MeshHandle = eeng::AssetHandle<eeng::RenderableMesh>;
+using MeshRegistry = eeng::AssetRegistry<eeng::RenderableMesh>;
+
+// Collision layer bits. Two colliders are tested only if each one's layer is in the other's mask.
+enum CollisionLayer : uint32_t {
+    LayerDefault = 1u << 0,
+    LayerStatic  = 1u << 1,     // Props that never move. Leave LayerStatic out of the props' own mask.
+    LayerPlayer  = 1u << 2,
+    LayerNPC     = 1u << 3,
+    LayerAnimal  = 1u << 4,
+    LayerFood    = 1u << 5,
+    LayerAll     = 0xffffffffu
+};
+
+// Mask of NPC colliders. Moving colliders need LayerStatic in their mask, or they pass through props,
+// static meshes and heightfields.
+constexpr uint32_t NPCCollisionMask = LayerPlayer | LayerNPC | LayerAnimal | LayerStatic;
+
 
 struct AABBColliderComponent {
     AABBBoundingBox aabb;
     bool isTrigger = false;
     bool collissionTriggered = false; 
-
+    uint32_t layer = LayerDefault;
+    uint32_t mask = LayerAll;
 
     AABBColliderComponent() = default;
 
-    AABBColliderComponent(const glm::vec3& center, const glm::vec3& halfWidths, bool isTrigger = false, bool collissionTriggered = false)
+    AABBColliderComponent(const glm::vec3& center, const glm::vec3& halfWidths, bool isTrigger = false, bool collissionTriggered = false,
+        uint32_t layer = LayerDefault, uint32_t mask = LayerAll)
         : aabb(center, halfWidths.x, halfWidths.y, halfWidths.z),
-        collissionTriggered(collissionTriggered),
-        isTrigger(isTrigger) {
+        isTrigger(isTrigger),
+        collissionTriggered(collissionTriggered), layer(layer), mask(mask) {
     }
 };
 
@@ -49,22 +74,49 @@ struct PlaneColliderComponent {
     }
 };
 
+// Static triangle-mesh collider, built in world space from a mesh's geometry (see BuildMeshCollider).
+// Invalidate the StaticCollisionWorld after adding or removing one.
+struct MeshColliderComponent {
+    std::shared_ptr<const eeng::TriangleMeshBVH> bvh;
+    uint32_t layer = LayerStatic;
+};
+
+// Static heightfield collider, in world space (see BuildHeightfieldFromMesh). Grounding prefers heightfields
+// over meshes, since a height lookup costs a few memory reads. Invalidate the StaticCollisionWorld after adding or removing one.
+struct HeightfieldColliderComponent {
+    std::shared_ptr<const eeng::Heightfield> heightfield;
+    uint32_t layer = LayerStatic;
+};
+
 struct SphereColliderComponent {
     Sphere localSphere; 
     bool isTrigger = false;
     bool sphereCollissionTriggered = false;
 	bool planeCollissionTriggered = false;
+    uint32_t layer = LayerDefault;
+    uint32_t mask = LayerAll;
     SphereColliderComponent() = default;
 
-    SphereColliderComponent(const glm::vec3& offset, float radius, bool trigger = false, bool sphereCollissionTriggered = false, bool planeCollissionTriggered = false)
-        : localSphere(offset, radius), isTrigger(trigger), sphereCollissionTriggered(sphereCollissionTriggered), planeCollissionTriggered(planeCollissionTriggered) {
+    SphereColliderComponent(const glm::vec3& offset, float radius, bool trigger = false, bool sphereCollissionTriggered = false, bool planeCollissionTriggered = false,
+        uint32_t layer = LayerDefault, uint32_t mask = LayerAll)
+        : localSphere(offset, radius), isTrigger(trigger), sphereCollissionTriggered(sphereCollissionTriggered), planeCollissionTriggered(planeCollissionTriggered),
+        layer(layer), mask(mask) {
     }
 };
 
 struct PlayerTag {};
 
+// Marks an entity whose colliders never move. Invalidate the StaticCollisionWorld after adding, removing or moving one.
+struct StaticColliderTag {};
+
 enum AnimState:uint8_t{ Start = 0, Idle = 1, Walking = 2, Jumping = 3 };
 
+// Ground below a character, looked up in static heightfields and meshes each frame, see GroundingSystem
+struct GroundComponent {
+    float height = 0.0f;    // Ground height at the character's position
+    bool onMesh = false;    // True where the ground is a mesh or heightfield, false where the ground plane is used
+};
+
 struct AnimeComponent{
     AnimState previousState = AnimState::Start;
     AnimState currentState  = AnimState::Idle;
@@ -80,15 +132,66 @@ struct TransformComponent {
     glm::vec3 scale = glm::vec3(1.0f);
 };
 
+// Transform before the last update step, for entities that move. RenderSystem draws them in between this and
+// their TransformComponent, so that they move smoothly when frames fall between update steps.
+struct PreviousTransformComponent {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+};
+
 struct LinearVelocityComponent {
     glm::vec3 velocity = glm::vec3(0.0f);
 	float gravity = -9.81f;
 };
 
+// Lets a moving body fall asleep after resting for a while, see SleepSystem
+struct SleepComponent {
+    uint32_t restFrames = 0;                // Consecutive frames at rest
+    glm::vec3 lastPosition{ 0.0f };         // Position at the previous sleep update, or where the body fell asleep
+    glm::quat restRotation{ 1.0f, 0.0f, 0.0f, 0.0f };  // Rotation when the body fell asleep
+    uint32_t index = 0;                     // Scratch index used while building islands
+};
+
+// Lets a fast body collide continuously: when its sphere collider moved further than its radius since the last
+// collision stage, the move is swept and stops at the first collider, plane or mesh wall in the way, see
+// ContinuousCollisions. Clear hasPreviousPosition after teleporting the body.
+struct ContinuousCollisionComponent {
+    glm::vec3 previousPosition{ 0.0f };     // Position at the end of the last collision stage
+    bool hasPreviousPosition = false;
+};
+
+// Marks a sleeping body. Sleeping bodies skip movement, collision queries and contact resolution until woken.
+struct SleepingTag {};
+
+// Mesh in the game's MeshRegistry. The component borrows the handle; the reference is held by whoever loaded the mesh.
 struct MeshComponent {
-    std::weak_ptr<eeng::RenderableMesh> mesh;
+    MeshHandle mesh;
 };
 
+// World matrix of the TransformComponent, rebuilt by WorldMatrixSystem only when the transform has changed. Systems
+// write transforms in place rather than through registry.patch, so EnTT's on_update signal would miss most changes;
+// instead the transform the matrix was built from is kept and compared. Static props are never rebuilt.
+struct WorldMatrixComponent {
+    glm::mat4 matrix{ 1.0f };
+    glm::vec3 position{ NAN };              // Transform the matrix was built from, NaN until the first build
+    glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec3 scale{ 1.0f };
+};
+
+// Same as glm::translate(position) * glm::mat4_cast(rotation) * glm::scale(scale) for a unit rotation, without the
+// two matrix products. Straight-line code, so a loop over many transforms vectorizes.
+inline glm::mat4 ComposeWorldMatrix(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+    return glm::mat4(
+        glm::vec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f),
+        glm::vec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f),
+        glm::vec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f),
+        glm::vec4(position, 1.0f));
+}
+
 struct PlayerControllerComponent {
     float speed = 5.0f;
     glm::vec3 fwd = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -100,6 +203,20 @@ struct NPCWaypointComponent {
     std::vector<glm::vec3> waypoints;
     size_t currentWaypointIndex = 0;
     float speed = 1.0f;
+    bool loop = true;       // Start over after the last waypoint, or stop there and clear the waypoints
+};
+
+// Lets an NPC walk to a goal along a path from the PathfindingService, see PathfindingSystem.
+// Set goal and hasNewGoal; the path replaces the NPC's waypoints when it arrives.
+struct NavigationAgentComponent {
+    glm::vec3 goal{ 0.0f };
+    bool hasNewGoal = false;
+    uint64_t ticket = 0;    // Request in flight, 0 if none
+};
+
+// Makes a waypoint NPC steer around other agents instead of walking into them, see CrowdSteeringSystem
+struct CrowdAgentComponent {
+    float radius = 0.5f;    // Personal space on the xz-plane
 };
 
 
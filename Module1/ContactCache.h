@@ -0,0 +1,100 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+enum class ContactPhase : std::uint8_t {
+    Begin,  // Pair started touching this frame
+    Stay,   // Pair touched last frame and still does
+    End     // Pair touched last frame but no longer does. Entities may have been destroyed since.
+};
+
+struct ContactEvent {
+    entt::entity a;
+    entt::entity b;
+    ContactPhase phase;
+};
+
+// Remembers which entity pairs touched last frame and turns each frame's contacts into begin/stay/end events.
+// Pairs are stored sorted on (entity, entity), smaller entity first, so the event order is deterministic.
+// Only the pairs are kept. The contact solver is position based and measures each penetration afresh, so there
+// is no per-pair state to warm-start it from.
+class ContactPairCache {
+public:
+    using Key = std::uint64_t;
+
+    static Key MakeKey(entt::entity a, entt::entity b) {
+        std::uint64_t ia = entt::to_integral(a), ib = entt::to_integral(b);
+        if (ia > ib) std::swap(ia, ib);
+        return (ia << 32) | ib;
+    }
+    static entt::entity First(Key key) { return static_cast<entt::entity>(key >> 32); }
+    static entt::entity Second(Key key) { return static_cast<entt::entity>(key & 0xffffffffu); }
+
+    // Add a contact found this frame. Call between BeginFrame and EndFrame.
+    void Add(entt::entity a, entt::entity b) {
+        current.push_back(MakeKey(a, b));
+    }
+
+    void BeginFrame() {
+        current.clear();
+    }
+
+    // Keep each pair of last frame for which keep(a, b) is true, e.g. pairs that no collider tested this frame
+    // because both sides are asleep. Call between BeginFrame and EndFrame.
+    template<class F>
+    void CarryOver(F&& keep) {
+        for (Key key : previous)
+            if (keep(First(key), Second(key))) current.push_back(key);
+    }
+
+    // Diffs this frame's contacts against last frame's and fills Events()
+    void EndFrame() {
+        std::sort(current.begin(), current.end());
+        current.erase(std::unique(current.begin(), current.end()), current.end());
+
+        events.clear();
+        size_t i = 0, j = 0;
+        while (i < previous.size() || j < current.size()) {
+            if (j == current.size() || (i < previous.size() && previous[i] < current[j])) {
+                Emit(previous[i++], ContactPhase::End);
+            }
+            else if (i == previous.size() || current[j] < previous[i]) {
+                Emit(current[j++], ContactPhase::Begin);
+            }
+            else {
+                Emit(current[j], ContactPhase::Stay);
+                i++; j++;
+            }
+        }
+        std::swap(previous, current);
+    }
+
+    const std::vector<ContactEvent>& Events() const { return events; }
+
+    // Calls func(a, b) for each pair that touched in the last completed frame
+    template<class F>
+    void ForEachPair(F&& func) const {
+        for (Key key : previous) func(First(key), Second(key));
+    }
+
+    size_t PairCount() const { return previous.size(); }
+
+    void Clear() {
+        previous.clear();
+        current.clear();
+        events.clear();
+    }
+
+private:
+    void Emit(Key key, ContactPhase phase) {
+        events.push_back({ First(key), Second(key), phase });
+    }
+
+    std::vector<Key> previous;
+    std::vector<Key> current;
+    std::vector<ContactEvent> events;
+};
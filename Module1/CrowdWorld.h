@@ -0,0 +1,33 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <vector>
+#include "SpatialHash.h"
+
+// Everything the crowd steering stage keeps between frames, see CrowdSteeringSystem
+struct CrowdWorld {
+    // Agents are rehashed on the xz-plane each frame
+    eeng::SpatialHash hash;
+
+    // Agent state gathered from the registry each frame, one entry per agent. Kept between frames so that
+    // a crowd of the same size allocates nothing.
+    std::vector<entt::entity> entities;
+    std::vector<float> x, z;                    // Position
+    std::vector<float> preferredX, preferredZ;  // Velocity towards the next waypoint
+    std::vector<float> radius;
+    std::vector<float> maxSpeed;
+    std::vector<float> velocityX, velocityZ;    // Steered velocity, written in parallel
+
+    struct Settings {
+        float neighborRadius = 3.0f;    // Agents further apart than this ignore each other
+        float timeHorizon = 2.0f;       // Seconds ahead that predicted collisions are avoided
+        float separation = 2.0f;        // Strength of the push apart of overlapping agents
+        float avoidance = 1.0f;         // Strength of the sidestep away from predicted collisions
+    } settings;
+
+    struct Stats {
+        size_t agents = 0;
+        size_t neighborPairs = 0;
+        float milliseconds = 0.0f;
+    } stats;
+};
@@ -9,16 +9,17 @@
 #include "CalorieTracker.cpp"
 #include "Systems.h"
 
-std::vector<Sphere*> allSpheres;
-
 bool Game::init()
 {
-
-    forwardRenderer = std::make_shared<eeng::ForwardRenderer>();
-    forwardRenderer->init("shaders/phong_vert.glsl", "shaders/phong_frag.glsl");
-
-    shapeRenderer = std::make_shared<ShapeRendering::ShapeRenderer>();
-    shapeRenderer->init();
+    // Headless, there is no GL context: nothing is rendered, and meshes keep only what the updates use
+    const bool cpuOnly = is_headless();
+    if (!cpuOnly) {
+        forwardRenderer = std::make_shared<eeng::ForwardRenderer>();
+        forwardRenderer->init("shaders/phong_vert.glsl", "shaders/phong_frag.glsl");
+
+        shapeRenderer = std::make_shared<ShapeRendering::ShapeRenderer>();
+        shapeRenderer->init();
+    }
 
     entity_registry = std::make_shared<entt::registry>();
     //auto ent1 = entity_registry->create();
@@ -36,29 +37,31 @@ bool Game::init()
     #pragma region Generating meshes
     // Grass
     grassMesh = std::make_shared<eeng::RenderableMesh>();
+    grassMesh->setCpuOnly(cpuOnly);
     grassMesh->load("assets/grass/grass_trees_merged2.fbx", false);
     
     // Horse
-    horseMesh = std::make_shared<eeng::RenderableMesh>();
-    horseMesh->load("assets/Animals/Horse.fbx", false);
+    horseMesh = meshes.load("Horse", [cpuOnly](eeng::RenderableMesh& mesh) {
+        mesh.setCpuOnly(cpuOnly);
+        mesh.load("assets/Animals/Horse.fbx", false);
+        });
 
     // Character
     characterMesh = std::make_shared<eeng::RenderableMesh>();
 
-    playerMesh = std::make_shared<eeng::RenderableMesh>();
-    playerMesh->load("assets/Amy/Ch46_nonPBR.fbx");
-    playerMesh->load("assets/Amy/idle.fbx", true);
-    playerMesh->load("assets/Amy/walking.fbx", true);
-    playerMesh->load("assets/Amy/jump.fbx", true);
-    playerMesh->removeTranslationKeys("mixamorig:Hips");
+    // Player and NPC animate separately, so each has a mesh of its own
+    auto loadAmy = [cpuOnly](eeng::RenderableMesh& mesh) {
+        mesh.setCpuOnly(cpuOnly);
+        mesh.load("assets/Amy/Ch46_nonPBR.fbx");
+        mesh.load("assets/Amy/idle.fbx", true);
+        mesh.load("assets/Amy/walking.fbx", true);
+        mesh.load("assets/Amy/jump.fbx", true);
+        mesh.removeTranslationKeys("mixamorig:Hips");
+        };
+    playerMesh = meshes.load("Amy (player)", loadAmy);
 
     // Load NPC mesh (fully independent)
-    npcMesh = std::make_shared<eeng::RenderableMesh>();
-    npcMesh->load("assets/Amy/Ch46_nonPBR.fbx");
-    npcMesh->load("assets/Amy/idle.fbx", true);
-    npcMesh->load("assets/Amy/walking.fbx", true);
-    npcMesh->load("assets/Amy/jump.fbx", true);
-    npcMesh->removeTranslationKeys("mixamorig:Hips");
+    npcMesh = meshes.load("Amy (NPC)", loadAmy);
 
 #if 0
     // Character
@@ -119,7 +122,10 @@ bool Game::init()
     );
 
     entity_registry->emplace<MeshComponent>(horseEntity, horseMesh);
+    entity_registry->emplace<WorldMatrixComponent>(horseEntity);
     entity_registry->emplace<HorseComponent>(horseEntity);
+    // The horse spins in place but never moves, so its colliders are static
+    entity_registry->emplace<StaticColliderTag>(horseEntity);
 
     glm::vec3 horseBounds[] = {
     glm::vec3(0.0f, 0.0f, 0.0f),
@@ -136,11 +142,13 @@ bool Game::init()
         boundingSphereHorse.radius,    
         false,                     
         false,					  
-        false
+        false,
+        LayerAnimal,
+        LayerPlayer | LayerNPC | LayerAnimal
     );
     AABBBoundingBox aabbHorse = BuildAABBFromSphere(boundingSphereHorse);
     glm::vec3 halfWidthsVecHorse(aabbHorse.halfWidths[0], aabbHorse.halfWidths[1], aabbHorse.halfWidths[2]);
-    entity_registry->emplace<AABBColliderComponent>(horseEntity, aabbHorse.center, halfWidthsVecHorse, true, false);
+    entity_registry->emplace<AABBColliderComponent>(horseEntity, aabbHorse.center, halfWidthsVecHorse, true, false, LayerAnimal, LayerPlayer | LayerNPC | LayerAnimal);
 
     /////  PLAYER!!!!!!!!!!!!!!!!!!!!!!!!!
     playerEntity = entity_registry->create();
@@ -152,7 +160,12 @@ bool Game::init()
     );
     entity_registry->emplace<PlayerTag>(playerEntity);
     entity_registry->emplace<MeshComponent>(playerEntity, playerMesh);
+    entity_registry->emplace<WorldMatrixComponent>(playerEntity);
     entity_registry->emplace<LinearVelocityComponent>(playerEntity, glm::vec3{ 0.0f });
+    entity_registry->emplace<SleepComponent>(playerEntity);
+    entity_registry->emplace<GroundComponent>(playerEntity);
+    entity_registry->emplace<ContinuousCollisionComponent>(playerEntity);
+    entity_registry->emplace<PreviousTransformComponent>(playerEntity);
 	entity_registry->emplace<PlayerControllerComponent>(playerEntity, 5.0f);
     entity_registry->emplace<AnimeComponent>(playerEntity, AnimState::Start, AnimState::Idle, 0.5f, 0.0f, 0.0f, true);
     
@@ -175,12 +188,14 @@ bool Game::init()
         boundingSpherePlayer.radius,    // Radius
         false,                     // isTrigger
 		false,					  // collissionTriggered
-        false
+        false,
+        LayerPlayer,               // layer
+        LayerAll                   // mask
     );
 
     AABBBoundingBox aabb = BuildAABBFromSphere(boundingSpherePlayer);
     glm::vec3 halfWidthsVec(aabb.halfWidths[0], aabb.halfWidths[1], aabb.halfWidths[2]);
-    entity_registry->emplace<AABBColliderComponent>(playerEntity, aabb.center, halfWidthsVec, true, false);
+    entity_registry->emplace<AABBColliderComponent>(playerEntity, aabb.center, halfWidthsVec, true, false, LayerPlayer, LayerAll);
 
     // === Add one NPC ===
     entt::entity npcEntity = entity_registry->create();
@@ -190,9 +205,15 @@ bool Game::init()
         glm::vec3{ 0.0f, 0.0f, 0.0f },
         glm::vec3{ 0.03f, 0.03f, 0.03f });
     entity_registry->emplace<MeshComponent>(npcEntity, npcMesh);
+    entity_registry->emplace<WorldMatrixComponent>(npcEntity);
     entity_registry->emplace<AnimeComponent>(npcEntity, AnimState::Start, AnimState::Idle, 0.5f, 0.0f, 0.0f, true);
 
     entity_registry->emplace<LinearVelocityComponent>(npcEntity, glm::vec3{ 0.0f });
+    entity_registry->emplace<SleepComponent>(npcEntity);
+    entity_registry->emplace<GroundComponent>(npcEntity);
+    entity_registry->emplace<CrowdAgentComponent>(npcEntity);
+    entity_registry->emplace<NavigationAgentComponent>(npcEntity);
+    entity_registry->emplace<PreviousTransformComponent>(npcEntity);
 
     // Waypoints and movement logic
     NPCWaypointComponent npcPath;
@@ -211,11 +232,13 @@ bool Game::init()
         boundingSphereNPC.radius,
         false,
         false,
-        false);
+        false,
+        LayerNPC,
+        NPCCollisionMask);
 
     AABBBoundingBox aabbNPC = BuildAABBFromSphere(boundingSphereNPC);
     glm::vec3 halfWidthsNPC(aabbNPC.halfWidths[0], aabbNPC.halfWidths[1], aabbNPC.halfWidths[2]);
-    entity_registry->emplace<AABBColliderComponent>(npcEntity, aabbNPC.center, halfWidthsNPC, true, false);
+    entity_registry->emplace<AABBColliderComponent>(npcEntity, aabbNPC.center, halfWidthsNPC, true, false, LayerNPC, NPCCollisionMask);
 
     // Create ground entity with a plane collider at y = 0
     entt::entity groundEntity = entity_registry->create();
@@ -228,6 +251,10 @@ bool Game::init()
         groundEntity,
         glm::vec3{ 0, 0, 0 },   // a point on the plane
         glm::vec3{ 0, 1, 0 });  // up direction (normal)
+    // Terrain and trees, which characters stand on and walk around
+    auto groundMesh = BuildMeshCollider(*grassMesh, grassWorldMatrix, true);
+    entity_registry->emplace<MeshColliderComponent>(groundEntity, groundMesh);
+    entity_registry->emplace<HeightfieldColliderComponent>(groundEntity, BuildHeightfieldFromMesh(*groundMesh, 0.5f));
 
 
 
@@ -253,7 +280,9 @@ bool Game::init()
         foodAABB.center,
         glm::vec3(foodAABB.halfWidths[0], foodAABB.halfWidths[1], foodAABB.halfWidths[2]),
         false,
-        false
+        false,
+        LayerFood,
+        LayerPlayer // Only the player can pick food up
     );
 
     // Add sphere collider as trigger so it enters BVH
@@ -263,10 +292,22 @@ bool Game::init()
         radius,
         true,       // Trigger! No physical push
         false,
-        false
+        false,
+        LayerFood,
+        LayerPlayer
     );
 
 
+    if (stressScene.Enabled())
+        SpawnStressScene(*entity_registry, stressScene, npcMesh, horseMesh);
+
+    // Navigation grid from the static geometry, which the first refresh of the colliders builds
+    RefreshColliderSoA(*entity_registry, collisionWorld.soa, collisionWorld.staticWorld);
+    navigationGrid = BuildNavigationGrid(collisionWorld, threadPool, 0.5f);
+    pathfinding.set_grid(navigationGrid);
+
+    registerSystems();
+
     eventQueue.RegisterListener([this](const std::string& e) {
         if      (e == "PLAYER_JUMPED") calorieTracker->AddCalories(0.2f);
         else if (e == "PLAYER_WALKED") calorieTracker->AddCalories(0.05f);
@@ -275,6 +316,55 @@ bool Game::init()
     return true;
 }
 
+void Game::registerSystems()
+{
+    using Access = eeng::SystemScheduler::Access;
+
+    // Added in the order they used to run in. A system waits only for the earlier ones it shares data with.
+    scheduler.add("RecordPreviousTransforms",
+        Access().reads<TransformComponent>().writes<PreviousTransformComponent>(),
+        [this] { RecordPreviousTransforms(*entity_registry); });
+    scheduler.add("PlayerController",
+        Access().reads<PlayerControllerComponent, PlayerTag>()
+            .writes<TransformComponent, LinearVelocityComponent, AnimeComponent, PlayerLogic, EventQueue>(),
+        [this] { PlayerControllerSystem(*entity_registry, frame.input, playerLogic, eventQueue); });
+    scheduler.add("Pathfinding",
+        Access().reads<TransformComponent>().writes<NavigationAgentComponent, NPCWaypointComponent, eeng::PathfindingService>(),
+        [this] { PathfindingSystem(*entity_registry, pathfinding, pathResults); });
+    scheduler.add("NPCController",
+        Access().reads<TransformComponent>().writes<NPCWaypointComponent, LinearVelocityComponent, AnimeComponent>(),
+        [this] { NPCControllerSystem(*entity_registry); });
+    scheduler.add("CrowdSteering",
+        Access().reads<TransformComponent, NPCWaypointComponent, CrowdAgentComponent>().writes<LinearVelocityComponent, CrowdWorld>(),
+        [this] { CrowdSteeringSystem(*entity_registry, crowdWorld, threadPool); });
+    scheduler.add("Sleep",
+        Access().reads<TransformComponent, CollisionWorld>().writes<LinearVelocityComponent, SleepComponent, SleepingTag>(),
+        [this] { SleepSystem(*entity_registry, collisionWorld.contacts, frame.deltaTime); });
+    scheduler.add("Movement",
+        Access().reads<GroundComponent, SleepingTag>().writes<TransformComponent, LinearVelocityComponent, AnimeComponent>(),
+        [this] { MovementSystem(*entity_registry, frame.deltaTime, threadPool); });
+    scheduler.add("Grounding",
+        Access().reads<SleepingTag, CollisionWorld>().writes<TransformComponent, GroundComponent, AnimeComponent>(),
+        [this] { GroundingSystem(*entity_registry, collisionWorld.staticWorld, threadPool); });
+    scheduler.add("Animate",
+        Access().reads<MeshComponent>().writes<AnimeComponent, MeshRegistry>(),
+        [this] { AnimateSystem(*entity_registry, meshes, frame.deltaTime, frame.time, characterAnimSpeed); });
+    scheduler.add("Collision",
+        Access().reads<SleepingTag, StaticColliderTag, PlaneColliderComponent, MeshColliderComponent, HeightfieldColliderComponent>()
+            .writes<TransformComponent, LinearVelocityComponent, SphereColliderComponent, AABBColliderComponent,
+                ContinuousCollisionComponent, CollisionWorld>(),
+        [this] { CollisionSystem(*entity_registry, collisionWorld, threadPool); });
+    scheduler.add("ContactEvents",
+        Access().reads<CollisionWorld>().writes<FoodComponent, PlayerLogic, QuestState>(),
+        [this] { ContactEventSystem(*entity_registry, collisionWorld.contacts, playerLogic, myQuest); });
+    scheduler.add("HorseFeeding",
+        Access().writes<TransformComponent, HorseComponent, PlayerLogic, QuestState>(),
+        [this] { HorseFeedingSystem(*entity_registry, frame.input, playerLogic, frame.deltaTime, myQuest); });
+    scheduler.add("WorldMatrices",
+        Access().reads<TransformComponent>().writes<WorldMatrixComponent, WorldMatrixCache>(),
+        [this] { WorldMatrixSystem(*entity_registry, worldMatrices); });
+}
+
 void Game::update(
     float time,
     float deltaTime,
@@ -287,16 +377,29 @@ void Game::update(
 
     //updatePlayer(deltaTime, input);
 
-    PlayerControllerSystem(*entity_registry, input, playerLogic, eventQueue);
-    NPCControllerSystem(*entity_registry);
-    MovementSystem(*entity_registry, deltaTime);
-    AnimateSystem(*entity_registry, deltaTime, time, characterAnimSpeed);
-    //SphereCollisionSystem(*entity_registry);
-    BVHCollisionSystem(*entity_registry, collisionCandidateCounts, playerLogic,horseEntity, myQuest);
-    SpherePlaneCollisionSystem(*entity_registry);
-    AABBCollisionSystem(*entity_registry);
-    AABBPlaneCollisionSystem(*entity_registry);
-    HorseFeedingSystem(*entity_registry, input, playerLogic, deltaTime, myQuest);
+    // N sends the NPCs to the player
+    const bool navigateKey = input->IsKeyPressed(eeng::InputManager::Key::N);
+    if (navigateKey && !navigateKeyDown) {
+        const glm::vec3 playerPosition = entity_registry->get<TransformComponent>(playerEntity).position;
+        for (auto [entity, agent] : entity_registry->view<NavigationAgentComponent>().each()) {
+            agent.goal = playerPosition;
+            agent.hasNewGoal = true;
+        }
+    }
+    navigateKeyDown = navigateKey;
+
+    frame = { time, deltaTime, input };
+    scheduler.run(threadPool);
+
+    if (stressScene.Enabled()) {
+        stressReport.RecordSystems(scheduler);
+        // Headless there is no extract, so its copy of the scene is timed here
+        if (is_headless()) {
+            const auto start = std::chrono::steady_clock::now();
+            ExtractRenderSystem(*entity_registry, meshes, 0.0f, worldMatrices, snapshot);
+            stressReport.Record("ExtractRender", std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
 
 
     //eventQueue.BroadcastAllEvents();
@@ -306,22 +409,50 @@ void Game::update(
         glm::vec4(100.0f, 100.0f, 100.0f, 1.0f));
 
 
-    // Intersect player view ray with AABBs of other objects 
-    glm_aux::intersect_ray_AABB(player.viewRay, character_aabb2.min, character_aabb2.max);
-    glm_aux::intersect_ray_AABB(player.viewRay, character_aabb3.min, character_aabb3.max);
-    glm_aux::intersect_ray_AABB(player.viewRay, horse_aabb.min, horse_aabb.max);
+    SceneQuery sceneQuery(collisionWorld.soa, collisionWorld.staticWorld);
+
+    // Intersect the player view ray with the collision world
+    if (auto* tfm = entity_registry->try_get<TransformComponent>(playerEntity))
+    {
+        const glm::vec3 fwd = glm::normalize(tfm->rotation * glm::vec3(0.0f, 0.0f, 1.0f));
+        player.viewRay = glm_aux::Ray{ tfm->position + glm::vec3(0.0f, 2.0f, 0.0f), fwd };
+
+        SceneHit hit;
+        if (sceneQuery.Raycast({ player.viewRay.origin, player.viewRay.dir, 100.0f, 0.0f, LayerAll & ~LayerPlayer }, hit))
+            player.viewRay.z_near = hit.distance;
+    }
+
+    // Line of sight from each NPC to the player, blocked by static geometry only. All NPCs are cast as
+    // one batch, which tests each collider batch against a packet of rays and spreads packets over the pool.
+    npcsSeeingPlayer = 0;
+    if (auto* playerTfm = entity_registry->try_get<TransformComponent>(playerEntity))
+    {
+        const glm::vec3 eyeOffset(0.0f, 1.8f, 0.0f);
+        const glm::vec3 target = playerTfm->position + eyeOffset;
+        sightRays.clear();
+        auto npcs = entity_registry->view<TransformComponent, NPCWaypointComponent>();
+        for (auto entity : npcs) {
+            const glm::vec3 eye = npcs.get<TransformComponent>(entity).position + eyeOffset;
+            const float distance = glm::distance(eye, target);
+            if (distance > 0.0f) sightRays.push_back({ eye, (target - eye) / distance, distance, 0.0f, LayerStatic });
+            else npcsSeeingPlayer++;
+        }
+
+        sightHits.resize(sightRays.size());
+        sightBlocked.resize(sightRays.size());
+        sceneQuery.RaycastBatch(sightRays.data(), sightRays.size(), sightHits.data(), sightBlocked.data(), &threadPool);
+        npcsSeeingPlayer += std::count(sightBlocked.begin(), sightBlocked.end(), uint8_t(0));
+    }
 
-    // We can also compute a ray from the current mouse position,
-    // to use for object picking and such ...
+    // Pick the entity under the mouse
     if (input->GetMouseState().rightButton)
     {
         glm::ivec2 windowPos(camera.mouse_xy_prev.x, matrices.windowSize.y - camera.mouse_xy_prev.y);
         auto ray = glm_aux::world_ray_from_window_coords(windowPos, matrices.V, matrices.P, matrices.VP);
-        // Intersect with e.g. AABBs ...
 
-        eeng::Log("Picking ray origin = %s, dir = %s",
-            glm_aux::to_string(ray.origin).c_str(),
-            glm_aux::to_string(ray.dir).c_str());
+        SceneHit hit;
+        if (sceneQuery.Raycast({ ray.origin, ray.dir, 1000.0f }, hit))
+            eeng::Log("Picked entity %u at distance %.2f", entt::to_integral(hit.entity), hit.distance);
     }
 
 
@@ -331,11 +462,13 @@ void Game::update(
 
 }
 
-void Game::render(
+bool Game::extract(
     float time,
+    float alpha,
     int windowWidth,
     int windowHeight)
 {
+    // The GUI reads and edits game state, so it is built here rather than in render
     renderUI();
 
 
@@ -350,25 +483,23 @@ void Game::render(
 
     matrices.VP = glm_aux::create_viewport_matrix(0.0f, 0.0f, windowWidth, windowHeight, 0.0f, 1.0f);
 
-    // Begin rendering pass
-    forwardRenderer->beginPass(matrices.P, matrices.V, pointlight.pos, pointlight.color, camera.pos);
-
-    RenderSystem(*entity_registry, forwardRenderer, shapeRenderer, drawSkeleton, axisLen);
-    
-    // Grass
-    forwardRenderer->renderMesh(grassMesh, grassWorldMatrix);
-    grass_aabb = grassMesh->m_model_aabb.post_transform(grassWorldMatrix);
-
-    // Horse
-    //horseMesh->animate(3, time);
-    //forwardRenderer->renderMesh(horseMesh, horseWorldMatrix);
-    //horse_aabb = horseMesh->m_model_aabb.post_transform(horseWorldMatrix);
-
-
-    // End rendering pass
-    drawcallCount = forwardRenderer->endPass();
+    snapshot.P = matrices.P;
+    snapshot.V = matrices.V;
+    snapshot.eyePos = camera.pos;
+    snapshot.lightPos = pointlight.pos;
+    snapshot.lightColor = pointlight.color;
+    snapshot.drawSkeleton = drawSkeleton;
+    snapshot.axisLen = axisLen;
+
+    const auto extractStart = std::chrono::steady_clock::now();
+    ExtractRenderSystem(*entity_registry, meshes, alpha, worldMatrices, snapshot);
+    if (stressScene.Enabled()) {
+        stressReport.Record("ExtractRender", std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - extractStart).count());
+        if (renderMs >= 0.0f) stressReport.Record("Render", renderMs);
+    }
 
-    // === Draw wireframe sphere colliders ===
+    // === Wireframe sphere colliders ===
+    snapshot.spheres.clear();
     {
         auto view = entity_registry->view<TransformComponent, SphereColliderComponent>();
         for (auto entity : view) {
@@ -376,45 +507,21 @@ void Game::render(
             // Skip collected food
             if (entity_registry->any_of<FoodComponent>(entity)) {
                 const auto& food = entity_registry->get<FoodComponent>(entity);
-                if (food.isCollected) {
-                    std::cout << "Skipping rendering of food AABB for entity: " << int(entity) << "\n";
-                    continue;
-                }
+                if (food.isCollected) continue;
             }
 
             const auto& transform = view.get<TransformComponent>(entity);
             const auto& collider = view.get<SphereColliderComponent>(entity);
 
-            glm::vec3 worldCenter = transform.position + collider.localSphere.center;
-            float radius = collider.localSphere.radius;
-
             ShapeRendering::Color4u color = (collider.sphereCollissionTriggered || collider.planeCollissionTriggered)
                 ? ShapeRendering::Color4u{ 0xFF0000FF } : ShapeRendering::Color4u{ 0xFF00FF00 }; 
 
-            shapeRenderer->push_states(color);
-
-            // YZ plane (circle facing X)
-            shapeRenderer->push_states(glm_aux::TS(worldCenter, radius * glm::vec3(1.0f)));
-            shapeRenderer->push_circle_ring<32>();
-            shapeRenderer->pop_states<glm::mat4>();
-
-            // XZ plane (circle facing Y)
-            shapeRenderer->push_states(glm_aux::TS(worldCenter, radius * glm::vec3(1.0f)) *
-                glm::rotate(glm::radians(90.0f), glm::vec3(0, 0, 1)));
-            shapeRenderer->push_circle_ring<32>();
-            shapeRenderer->pop_states<glm::mat4>();
-
-            // XY plane (circle facing Z)
-            shapeRenderer->push_states(glm_aux::TS(worldCenter, radius * glm::vec3(1.0f)) *
-                glm::rotate(glm::radians(90.0f), glm::vec3(0, 1, 0)));
-            shapeRenderer->push_circle_ring<32>();
-            shapeRenderer->pop_states<glm::mat4>();
-
-            shapeRenderer->pop_states<ShapeRendering::Color4u>();
+            snapshot.spheres.push_back({ transform.position + collider.localSphere.center, collider.localSphere.radius, color });
         }
     }
 
-    // === Draw wireframe AABB colliders ===
+    // === Wireframe AABB colliders ===
+    snapshot.boxes.clear();
     {
         auto view = entity_registry->view<TransformComponent, AABBColliderComponent>();
         for (auto entity : view) {
@@ -422,10 +529,7 @@ void Game::render(
             // Skip collected food
             if (entity_registry->any_of<FoodComponent>(entity)) {
                 const auto& food = entity_registry->get<FoodComponent>(entity);
-                if (food.isCollected) {
-                    std::cout << "Skipping rendering of food AABB for entity: " << int(entity) << "\n";
-                    continue;
-                }
+                if (food.isCollected) continue;
             }
 
             const auto& transform = view.get<TransformComponent>(entity);
@@ -434,31 +538,88 @@ void Game::render(
 
             glm::vec3 centerWorld = transform.position + aabb.center;
             glm::vec3 half = glm::vec3(aabb.halfWidths[0], aabb.halfWidths[1], aabb.halfWidths[2]);
-            glm::vec3 min = centerWorld - half;
-            glm::vec3 max = centerWorld + half;
 
             ShapeRendering::Color4u color = aabbComp.collissionTriggered
                 ? ShapeRendering::Color4u{ 0xFFFF0000 } // Red if collided
             : ShapeRendering::Color4u{ 0xFF00FF00 }; // Green if not
 
-            shapeRenderer->push_states(color);
-            shapeRenderer->push_AABB(min, max);
-            shapeRenderer->pop_states<ShapeRendering::Color4u>();
+            snapshot.boxes.push_back({ centerWorld - half, centerWorld + half, color });
         }
     }
 
-    #pragma region I dont know what this is so I hide it
-    // Draw player view ray
-    if (player.viewRay)
-    {
-        shapeRenderer->push_states(ShapeRendering::Color4u{ 0xff00ff00 });
-        shapeRenderer->push_line(player.viewRay.origin, player.viewRay.point_of_contact());
+    // Player view ray
+    snapshot.viewRayHit = bool(player.viewRay);
+    snapshot.viewRayStart = player.viewRay.origin;
+    snapshot.viewRayEnd = snapshot.viewRayHit
+        ? player.viewRay.point_of_contact()
+        : player.viewRay.origin + player.viewRay.dir * 100.0f;
+
+    return true;
+}
+
+void Game::render(
+    float time,
+    float alpha,
+    int windowWidth,
+    int windowHeight)
+{
+    // Reads only the snapshot and members used by nothing but rendering, since the next update may be running
+    
+    // Begin rendering pass
+    forwardRenderer->beginPass(snapshot.P, snapshot.V, snapshot.lightPos, snapshot.lightColor, snapshot.eyePos);
+
+    const auto renderStart = std::chrono::steady_clock::now();
+    RenderSystem(snapshot, forwardRenderer, shapeRenderer);
+    renderMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+    
+    // Grass
+    forwardRenderer->renderMesh(grassMesh, grassWorldMatrix);
+    grass_aabb = grassMesh->m_model_aabb.post_transform(grassWorldMatrix);
+
+    // Horse
+    //horseMesh->animate(3, time);
+    //forwardRenderer->renderMesh(horseMesh, horseWorldMatrix);
+    //horse_aabb = horseMesh->m_model_aabb.post_transform(horseWorldMatrix);
+
+
+    // End rendering pass
+    drawcallCount = forwardRenderer->endPass();
+
+    // === Draw wireframe sphere colliders ===
+    for (const auto& sphere : snapshot.spheres) {
+        shapeRenderer->push_states(sphere.color);
+
+        // YZ plane (circle facing X)
+        shapeRenderer->push_states(glm_aux::TS(sphere.center, sphere.radius * glm::vec3(1.0f)));
+        shapeRenderer->push_circle_ring<32>();
+        shapeRenderer->pop_states<glm::mat4>();
+
+        // XZ plane (circle facing Y)
+        shapeRenderer->push_states(glm_aux::TS(sphere.center, sphere.radius * glm::vec3(1.0f)) *
+            glm::rotate(glm::radians(90.0f), glm::vec3(0, 0, 1)));
+        shapeRenderer->push_circle_ring<32>();
+        shapeRenderer->pop_states<glm::mat4>();
+
+        // XY plane (circle facing Z)
+        shapeRenderer->push_states(glm_aux::TS(sphere.center, sphere.radius * glm::vec3(1.0f)) *
+            glm::rotate(glm::radians(90.0f), glm::vec3(0, 1, 0)));
+        shapeRenderer->push_circle_ring<32>();
+        shapeRenderer->pop_states<glm::mat4>();
+
+        shapeRenderer->pop_states<ShapeRendering::Color4u>();
     }
-    else
-    {
-        shapeRenderer->push_states(ShapeRendering::Color4u{ 0xffffffff });
-        shapeRenderer->push_line(player.viewRay.origin, player.viewRay.origin + player.viewRay.dir * 100.0f);
+
+    // === Draw wireframe AABB colliders ===
+    for (const auto& box : snapshot.boxes) {
+        shapeRenderer->push_states(box.color);
+        shapeRenderer->push_AABB(box.min, box.max);
+        shapeRenderer->pop_states<ShapeRendering::Color4u>();
     }
+
+    #pragma region I dont know what this is so I hide it
+    // Draw player view ray
+    shapeRenderer->push_states(snapshot.viewRayHit ? ShapeRendering::Color4u{ 0xff00ff00 } : ShapeRendering::Color4u{ 0xffffffff });
+    shapeRenderer->push_line(snapshot.viewRayStart, snapshot.viewRayEnd);
     shapeRenderer->pop_states<ShapeRendering::Color4u>();
 
     // Draw object bases
@@ -495,7 +656,7 @@ void Game::render(
 
 
     // Draw shape batches
-    shapeRenderer->render(matrices.P * matrices.V);
+    shapeRenderer->render(snapshot.P * snapshot.V);
     shapeRenderer->post_render();
 
 
@@ -574,6 +735,71 @@ void Game::renderUI()
     }
 
     ImGui::SliderFloat("Animation speed", &characterAnimSpeed, 0.1f, 5.0f);
+
+    const auto& collisionStats = collisionWorld.stats;
+    ImGui::Text("Collision: %.3f ms, %zu colliders, %zu pairs, %zu contacts",
+        collisionStats.milliseconds, collisionStats.colliders, collisionStats.candidatePairs, collisionStats.contacts);
+    ImGui::Text("Sleeping bodies: %zu", entity_registry->view<SleepingTag>().size());
+    ImGui::SliderInt("Solver iterations", &collisionWorld.solver.settings.iterations, 1, 16);
+    ImGui::Text("Solver batches: %zu", collisionStats.solverBatches);
+    ImGui::Text("Swept bodies: %zu, hits: %zu", collisionStats.sweptBodies, collisionStats.sweptHits);
+    for (const auto& mesh : collisionWorld.staticWorld.Meshes()) {
+        ImGui::Text("Mesh collider: %zu triangles, %zu nodes, %.1f KB",
+            mesh.bvh->triangle_count(), mesh.bvh->node_count(), mesh.bvh->memory_usage() / 1024.0f);
+    }
+    for (const auto& field : collisionWorld.staticWorld.Heightfields()) {
+        ImGui::Text("Heightfield: %zu x %zu samples, cell %.2f",
+            field.heightfield->columns(), field.heightfield->rows(), field.heightfield->cell_size());
+    }
+    ImGui::Text("World matrices: %zu rebuilt of %zu", worldMatrices.stats.rebuilt, worldMatrices.stats.entities);
+    ImGui::Text("Hierarchy: %zu nodes, %zu propagated", worldMatrices.hierarchy.size(), worldMatrices.stats.propagated);
+    ImGui::Text("NPCs seeing the player: %zu", npcsSeeingPlayer);
+    ImGui::Text("Crowd: %.3f ms, %zu agents, %zu neighbor pairs",
+        crowdWorld.stats.milliseconds, crowdWorld.stats.agents, crowdWorld.stats.neighborPairs);
+    if (ImGui::CollapsingHeader("System schedule")) {
+        ImGui::Checkbox("Run systems in parallel", &scheduler.parallel);
+        ImGui::Text("Systems: %.3f ms, %zu systems in %zu levels", scheduler.frame_ms(), scheduler.size(), scheduler.level_count());
+        for (size_t i = 0; i < scheduler.size(); i++) {
+            const auto& info = scheduler.info(i);
+            std::string after;
+            for (size_t dependency : info.dependencies)
+                after += (after.empty() ? "after " : ", ") + scheduler.info(dependency).name;
+            ImGui::Text("%zu %-16s %6.3f ms at %6.3f ms  %s", info.level, info.name.c_str(), info.ms, info.start_ms, after.c_str());
+        }
+    }
+    if (ImGui::CollapsingHeader("Snapshot")) {
+        auto timed = [](auto&& func) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+        if (ImGui::Button("Save"))
+            snapshots.takeMs = timed([&] { TakeSnapshot(*entity_registry, snapshots.saved); snapshots.delta.bytes.clear(); });
+        if (!snapshots.saved.Empty()) {
+            ImGui::SameLine();
+            if (ImGui::Button("Save changes"))
+                snapshots.takeMs = timed([&] { TakeDeltaSnapshot(*entity_registry, snapshots.saved, snapshots.delta); });
+            ImGui::SameLine();
+            if (ImGui::Button("Restore")) {
+                snapshots.restoreMs = timed([&] {
+                    RestoreSnapshot(*entity_registry, snapshots.saved);
+                    if (!snapshots.delta.Empty()) RestoreSnapshot(*entity_registry, snapshots.delta);
+                });
+                collisionWorld.staticWorld.Invalidate();
+            }
+            ImGui::Text("Saved: %.1f KB, changes: %.1f KB",
+                snapshots.saved.bytes.size() / 1024.0f, snapshots.delta.bytes.size() / 1024.0f);
+            ImGui::Text("Take: %.3f ms, restore: %.3f ms", snapshots.takeMs, snapshots.restoreMs);
+        }
+    }
+    if (navigationGrid) {
+        const auto pathStats = pathfinding.stats();
+        ImGui::Text("Navigation grid: %zu x %zu cells, %.1f KB",
+            navigationGrid->columns(), navigationGrid->rows(), navigationGrid->memory_usage() / 1024.0f);
+        ImGui::Text("Paths: %zu pending, %zu searched, %zu cached, %zu cells expanded",
+            pathStats.pending, pathStats.searches, pathStats.cache_hits, pathStats.expanded);
+        ImGui::Text("Press [N] to send the NPCs to the player");
+    }
     
     if (auto anime = entity_registry->try_get<AnimeComponent>(playerEntity))
     {
@@ -584,8 +810,8 @@ void Game::renderUI()
             ImGui::Text("Calories burned: %.2f kcal", calorieTracker->getCalories());
         }
 
-        if (collisionCandidateCounts.contains(playerEntity)) {
-            ImGui::Text("Player BVH candidates: %d", collisionCandidateCounts[playerEntity]);
+        if (collisionWorld.candidateCounts.contains(playerEntity)) {
+            ImGui::Text("Player BVH candidates: %d", collisionWorld.candidateCounts[playerEntity]);
         }
 
         switch (myQuest) {
@@ -612,7 +838,12 @@ void Game::renderUI()
 
 void Game::destroy()
 {
+    if (stressScene.Enabled())
+        LogStressReport(stressReport, stressScene, *entity_registry, snapshot);
 
+    meshes.release(horseMesh);
+    meshes.release(playerMesh);
+    meshes.release(npcMesh);
 }
 
 void Game::updateCamera(
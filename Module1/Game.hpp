@@ -10,6 +10,16 @@
 #include "PlayerLogic.cpp"
 #include "CalorieTracker.cpp"
 #include "EventQueue.h"
+#include "ThreadPool.hpp"
+#include "CollisionWorld.h"
+#include "CrowdWorld.h"
+#include "PathfindingService.hpp"
+#include "SystemScheduler.hpp"
+#include "RenderSnapshot.h"
+#include "WorldMatrixCache.h"
+#include "SceneQuery.h"
+#include "RegistrySnapshot.h"
+#include "StressScene.h"
 
 enum QuestState {
     FindFood,
@@ -27,21 +37,38 @@ public:
 
     QuestState myQuest = QuestState::FindFood;
 
+    /// @brief Procedural scene spawned by init on top of the hand-built one, none by default. Set before init.
+    StressSceneSettings stressScene;
+
     /// @brief General update method that is called each frame
     /// @param time Total time elapsed in seconds
-    /// @param deltaTime Time elapsed since the last frame
+    /// @param deltaTime The fixed update step
     /// @param input Input from mouse, keyboard and controllers
     void update(
         float time,
         float deltaTime,
         InputManagerPtr input) override;
 
-    /// @brief For rendering of game contents
+    /// @brief Copies what render needs into the snapshot and builds the GUI. Never runs during update.
     /// @param time Total time elapsed in seconds
+    /// @param alpha How far the frame is between the last two updates, as a fraction of the update step
+    /// @param windowWidth Current width of the window in pixels
+    /// @param windowHeight Current height of the window in pixels
+    /// @return True, render reads only the snapshot
+    bool extract(
+        float time,
+        float alpha,
+        int windowWidth,
+        int windowHeight) override;
+
+    /// @brief For rendering of game contents, from the snapshot. May run during the next update.
+    /// @param time Total time elapsed in seconds
+    /// @param alpha How far the frame is between the last two updates, as a fraction of the update step
     /// @param screenWidth Current width of the window in pixels
     /// @param screenHeight Current height of the window in pixels
     void render(
         float time,
+        float alpha,
         int windowWidth,
         int windowHeight) override;
 
@@ -51,6 +78,9 @@ public:
 private:
     /// @brief For rendering of GUI elements
     void renderUI();
+
+    /// @brief Adds the systems run by update() to the scheduler, with the data each of them reads and writes
+    void registerSystems();
     entt::entity playerEntity = entt::entity{};
 	float elapsedTime = 0.0f;
     bool drawSkeleton = true;
@@ -59,10 +89,43 @@ private:
     std::shared_ptr<CalorieTracker> calorieTracker;
     EventQueue eventQueue;
     entt::entity horseEntity = entt::entity{};
-    //std::vector<Sphere*> allSpheres;
     // Renderer for rendering imported animated or non-animated models
     eeng::ForwardRendererPtr forwardRenderer;
-    std::unordered_map<entt::entity, int> collisionCandidateCounts;
+    // Colliders, static collision data and contact cache of the collision stage
+    CollisionWorld collisionWorld;
+    // Spatial hash and scratch buffers of the crowd steering stage
+    CrowdWorld crowdWorld;
+    // Walkable cells of the level, built from its static geometry in init
+    std::shared_ptr<const eeng::NavigationGrid> navigationGrid;
+    // Searches paths for navigation agents on a worker thread
+    eeng::PathfindingService pathfinding;
+    std::vector<eeng::PathfindingService::Result> pathResults;
+    bool navigateKeyDown = false;
+    // Workers for the systems and their parallel loops
+    eeng::ThreadPool threadPool;
+    // Runs the systems of update(), concurrently where they touch different data
+    eeng::SystemScheduler scheduler;
+    // Arguments of the current update(), for the systems
+    struct Frame
+    {
+        float time = 0.0f;
+        float deltaTime = 0.0f;
+        InputManagerPtr input;
+    } frame;
+    // Scratch buffers of the world matrix rebuild
+    WorldMatrixCache worldMatrices;
+    // Quick save of the registry and the changes since, taken and restored from the UI
+    struct Snapshots
+    {
+        RegistrySnapshot saved, delta;
+        float takeMs = 0.0f, restoreMs = 0.0f;
+    } snapshots;
+    // Timings of the stress scene, logged by destroy
+    StressReport stressReport;
+    // Duration of the last render, written by render only and recorded by extract
+    float renderMs = -1.0f;
+    // What render draws, copied from the game state by extract
+    RenderSnapshot snapshot;
     // Immediate-mode renderer for basic 2D or 3D primitives
     ShapeRendererPtr shapeRenderer;
     float feedingtime = 3;
@@ -115,8 +178,11 @@ private:
         glm_aux::Ray viewRay;
     } player;
 
-    // Game meshes
-    std::shared_ptr<eeng::RenderableMesh> grassMesh, horseMesh, characterMesh, playerMesh, npcMesh;
+    // Meshes referenced by MeshComponents, and the game's references to them
+    MeshRegistry meshes;
+    MeshHandle horseMesh, playerMesh, npcMesh;
+    // Meshes drawn by the game directly
+    std::shared_ptr<eeng::RenderableMesh> grassMesh, characterMesh;
 
     // Game entity transformations
     glm::mat4 characterWorldMatrix1, characterWorldMatrix2, characterWorldMatrix3;
@@ -131,6 +197,12 @@ private:
 
     // Stats
     int drawcallCount = 0;
+    // NPCs with a clear line of sight to the player this frame
+    size_t npcsSeeingPlayer = 0;
+    // Eye-to-eye segments from the NPCs to the player, cast as one packet each frame
+    std::vector<SceneRay> sightRays;
+    std::vector<SceneHit> sightHits;
+    std::vector<uint8_t> sightBlocked;
 
     /// @brief Placeholder system for updating the camera position based on inputs
     /// @param input Input from mouse, keyboard and controllers
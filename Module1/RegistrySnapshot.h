@@ -0,0 +1,378 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <tuple>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include "Components.h"
+
+// Binary copy of the registry's entities and of the trivially copyable components in SnapshotComponents, for quick
+// saves, level reloads and rollback. Each component type is one block, its entities and then its components as raw
+// bytes, in the order of the type's storage, so that restoring a type is one bulk insert. Components of other types
+// (waypoint lists, collider meshes...) are left alone on entities that live through a restore, and lost on entities
+// that a restore destroys.
+//
+// A delta snapshot holds what changed since a full snapshot: the entities created and destroyed, and per type the
+// components added or whose bytes differ, and those removed. Restore the full snapshot, then the delta. Deltas are
+// taken against a full snapshot rather than against each other, so that any of them restores in two steps.
+// Components are compared byte for byte, padding included, so a delta may hold a few unchanged ones.
+//
+// The layout follows SnapshotComponents and the component types, so a snapshot is for the build that wrote it.
+
+template<class... T> struct ComponentList {};
+
+// Append new types at the end
+using SnapshotComponents = ComponentList<
+    TransformComponent, PreviousTransformComponent, LinearVelocityComponent, AnimeComponent, GroundComponent,
+    SleepComponent, ContinuousCollisionComponent, SphereColliderComponent, AABBColliderComponent,
+    PlaneColliderComponent, HorseComponent, FoodComponent, MeshComponent, WorldMatrixComponent,
+    PlayerControllerComponent, CrowdAgentComponent, PlayerTag, StaticColliderTag, SleepingTag>;
+
+struct RegistrySnapshot {
+    std::vector<std::byte> bytes;   // Kept between snapshots, so that taking one of the same size allocates nothing
+
+    bool Empty() const { return bytes.empty(); }
+};
+
+// Layout: magic, type count, delta flag; created entities, destroyed entities; then per type its size, the
+// entities and components added or changed, and the entities it was removed from. A full snapshot lists every
+// entity and component as created or added. Arrays start at multiples of 16 bytes.
+struct SnapshotWriter {
+    static constexpr uint32_t Magic = 0x4e534545;  // "EESN"
+
+    std::vector<std::byte>& bytes;
+
+    template<class V>
+    void Write(const V& value) {
+        const size_t at = bytes.size();
+        bytes.resize(at + sizeof(V));
+        std::memcpy(bytes.data() + at, &value, sizeof(V));
+    }
+
+    // Offset of space for count elements of size elementSize
+    size_t Reserve(size_t count, size_t elementSize) {
+        const size_t at = (bytes.size() + 15) & ~size_t(15);
+        bytes.resize(at + count * elementSize);
+        return at;
+    }
+
+    size_t WriteArray(const void* data, size_t count, size_t elementSize) {
+        const size_t at = Reserve(count, elementSize);
+        if (count) std::memcpy(bytes.data() + at, data, count * elementSize);
+        return at;
+    }
+};
+
+// Reads what SnapshotWriter wrote. Reading past the end yields zeros and null arrays, and clears ok.
+struct SnapshotReader {
+    const std::vector<std::byte>& bytes;
+    size_t pos = 0;
+    bool ok = true;
+
+    template<class V>
+    V Read() {
+        V value{};
+        if (pos + sizeof(V) > bytes.size()) { ok = false; return value; }
+        std::memcpy(&value, bytes.data() + pos, sizeof(V));
+        pos += sizeof(V);
+        return value;
+    }
+
+    template<class V>
+    const V* ReadArray(size_t count) {
+        const size_t at = (pos + 15) & ~size_t(15);
+        if (at + count * sizeof(V) > bytes.size()) { ok = false; return nullptr; }
+        pos = at + count * sizeof(V);
+        return reinterpret_cast<const V*>(bytes.data() + at);
+    }
+};
+
+// One type's block while reading
+template<class T>
+struct SnapshotBlock {
+    uint32_t count = 0, removedCount = 0;
+    const entt::entity* entities = nullptr;
+    const T* components = nullptr;
+    const entt::entity* removed = nullptr;
+
+    bool Read(SnapshotReader& in) {
+        if (in.Read<uint32_t>() != sizeof(T)) return in.ok = false;
+        count = in.Read<uint32_t>();
+        entities = in.ReadArray<entt::entity>(count);
+        if constexpr (!std::is_empty_v<T>) components = in.ReadArray<T>(count);
+        removedCount = in.Read<uint32_t>();
+        removed = in.ReadArray<entt::entity>(removedCount);
+        return in.ok;
+    }
+};
+
+// Entity -> position in an array of entities, by entity index, for finding entities of another snapshot
+struct SnapshotEntityIndex {
+    std::vector<uint32_t> slots;    // Position + 1, 0 if absent
+
+    void Build(const entt::entity* entities, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            const size_t index = entt::to_entity(entities[i]);
+            if (index >= slots.size()) slots.resize(index + 1, 0);
+            slots[index] = i + 1;
+        }
+    }
+
+    void Clear(const entt::entity* entities, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) slots[entt::to_entity(entities[i])] = 0;
+    }
+
+    // Position of entity in entities, or -1 if absent or of another version
+    int64_t Find(entt::entity entity, const entt::entity* entities) const {
+        const size_t index = entt::to_entity(entity);
+        if (index >= slots.size() || !slots[index]) return -1;
+        const uint32_t i = slots[index] - 1;
+        return entities[i] == entity ? int64_t(i) : -1;
+    }
+};
+
+template<class T>
+void WriteSnapshotBlock(SnapshotWriter& out, const entt::registry& registry) {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 16, "Snapshot components are copied as raw bytes");
+    const auto* storage = registry.storage<T>();
+    const uint32_t count = storage ? uint32_t(storage->size()) : 0;
+    out.Write(uint32_t(sizeof(T)));
+    out.Write(count);
+    const size_t entitiesAt = out.Reserve(count, sizeof(entt::entity));
+    size_t componentsAt = 0;
+    if constexpr (!std::is_empty_v<T>) componentsAt = out.Reserve(count, sizeof(T));
+
+    // each() visits the storage back to front. Filled from the back, the block keeps the storage's order, and
+    // so does a restore.
+    if (storage) {
+        size_t i = count;
+        for (auto element : storage->each()) {
+            --i;
+            std::memcpy(out.bytes.data() + entitiesAt + i * sizeof(entt::entity), &std::get<0>(element), sizeof(entt::entity));
+            if constexpr (!std::is_empty_v<T>)
+                std::memcpy(out.bytes.data() + componentsAt + i * sizeof(T), &std::get<1>(element), sizeof(T));
+        }
+    }
+    out.Write(uint32_t(0));     // Nothing removed
+    out.Reserve(0, sizeof(entt::entity));
+}
+
+template<class T>
+void WriteDeltaBlock(SnapshotWriter& out, const entt::registry& registry, SnapshotReader& base, SnapshotEntityIndex& index,
+    std::vector<entt::entity>& entities, std::vector<std::byte>& components) {
+    SnapshotBlock<T> block;
+    block.Read(base);
+    index.Build(block.entities, block.count);
+
+    // Added, or with other bytes than in the base
+    entities.clear();
+    components.clear();
+    const auto* storage = registry.storage<T>();
+    if (storage) {
+        for (auto element : storage->each()) {
+            const entt::entity entity = std::get<0>(element);
+            const int64_t i = index.Find(entity, block.entities);
+            if constexpr (std::is_empty_v<T>) {
+                if (i >= 0) continue;
+            }
+            else {
+                const T& component = std::get<1>(element);
+                if (i >= 0 && std::memcmp(&component, block.components + i, sizeof(T)) == 0) continue;
+                const size_t at = components.size();
+                components.resize(at + sizeof(T));
+                std::memcpy(components.data() + at, &component, sizeof(T));
+            }
+            entities.push_back(entity);
+        }
+    }
+    out.Write(uint32_t(sizeof(T)));
+    out.Write(uint32_t(entities.size()));
+    out.WriteArray(entities.data(), entities.size(), sizeof(entt::entity));
+    if constexpr (!std::is_empty_v<T>) out.WriteArray(components.data(), entities.size(), sizeof(T));
+
+    // Removed since the base, also from entities destroyed since
+    entities.clear();
+    for (uint32_t i = 0; i < block.count; ++i)
+        if (!storage || !storage->contains(block.entities[i])) entities.push_back(block.entities[i]);
+    out.Write(uint32_t(entities.size()));
+    out.WriteArray(entities.data(), entities.size(), sizeof(entt::entity));
+    index.Clear(block.entities, block.count);
+}
+
+template<class T>
+void RestoreSnapshotBlock(SnapshotReader& in, entt::registry& registry, bool delta) {
+    SnapshotBlock<T> block;
+    if (!block.Read(in)) return;
+    auto& storage = registry.storage<T>();
+
+    if (!delta) {
+        storage.clear();
+        if constexpr (std::is_empty_v<T>) storage.insert(block.entities, block.entities + block.count);
+        else storage.insert(block.entities, block.entities + block.count, block.components);
+        return;
+    }
+
+    for (uint32_t i = 0; i < block.removedCount; ++i)
+        storage.remove(block.removed[i]);
+    for (uint32_t i = 0; i < block.count; ++i) {
+        const entt::entity entity = block.entities[i];
+        if constexpr (std::is_empty_v<T>) {
+            if (!storage.contains(entity)) storage.emplace(entity);
+        }
+        else if (storage.contains(entity)) storage.get(entity) = block.components[i];
+        else storage.emplace(entity, block.components[i]);
+    }
+}
+
+template<class... T>
+void WriteSnapshotBlocks(ComponentList<T...>, SnapshotWriter& out, const entt::registry& registry) {
+    (WriteSnapshotBlock<T>(out, registry), ...);
+}
+
+template<class... T>
+void WriteDeltaBlocks(ComponentList<T...>, SnapshotWriter& out, const entt::registry& registry, SnapshotReader& base) {
+    SnapshotEntityIndex index;
+    std::vector<entt::entity> entities;
+    std::vector<std::byte> components;
+    (WriteDeltaBlock<T>(out, registry, base, index, entities, components), ...);
+}
+
+template<class... T>
+void RestoreSnapshotBlocks(ComponentList<T...>, SnapshotReader& in, entt::registry& registry, bool delta) {
+    (RestoreSnapshotBlock<T>(in, registry, delta), ...);
+}
+
+template<class... T>
+bool ValidSnapshotBlocks(ComponentList<T...>, SnapshotReader& in) {
+    return (SnapshotBlock<T>().Read(in) && ...);
+}
+
+template<class... T>
+constexpr uint32_t SnapshotTypeCount(ComponentList<T...>) { return uint32_t(sizeof...(T)); }
+
+// Reads the header, or clears in.ok if it is not one of this build's
+inline bool ReadSnapshotHeader(SnapshotReader& in) {
+    const uint32_t magic = in.Read<uint32_t>();
+    const uint32_t typeCount = in.Read<uint32_t>();
+    const bool delta = in.Read<uint32_t>() != 0;
+    if (magic != SnapshotWriter::Magic || typeCount != SnapshotTypeCount(SnapshotComponents{})) in.ok = false;
+    return delta;
+}
+
+// Takes a full snapshot of the registry
+inline void TakeSnapshot(const entt::registry& registry, RegistrySnapshot& snapshot) {
+    snapshot.bytes.clear();
+    SnapshotWriter out{ snapshot.bytes };
+    out.Write(SnapshotWriter::Magic);
+    out.Write(SnapshotTypeCount(SnapshotComponents{}));
+    out.Write(uint32_t(0));
+
+    const auto* entityStorage = registry.storage<entt::entity>();
+    uint32_t count = 0;
+    for ([[maybe_unused]] auto element : entityStorage->each()) count++;
+    out.Write(count);
+    const size_t at = out.Reserve(count, sizeof(entt::entity));
+    size_t i = 0;
+    for (auto [entity] : entityStorage->each())
+        std::memcpy(out.bytes.data() + at + i++ * sizeof(entt::entity), &entity, sizeof(entt::entity));
+    out.Write(uint32_t(0));     // Nothing destroyed
+    out.Reserve(0, sizeof(entt::entity));
+
+    WriteSnapshotBlocks(SnapshotComponents{}, out, registry);
+}
+
+// Takes a snapshot of the changes to the registry since the full snapshot base was taken
+inline void TakeDeltaSnapshot(const entt::registry& registry, const RegistrySnapshot& base, RegistrySnapshot& delta) {
+    SnapshotReader in{ base.bytes };
+    const bool baseIsDelta = ReadSnapshotHeader(in);
+    (void)baseIsDelta;
+    assert(in.ok && !baseIsDelta);
+
+    delta.bytes.clear();
+    SnapshotWriter out{ delta.bytes };
+    out.Write(SnapshotWriter::Magic);
+    out.Write(SnapshotTypeCount(SnapshotComponents{}));
+    out.Write(uint32_t(1));
+
+    const uint32_t baseCount = in.Read<uint32_t>();
+    const entt::entity* baseEntities = in.ReadArray<entt::entity>(baseCount);
+    in.ReadArray<entt::entity>(in.Read<uint32_t>());
+
+    SnapshotEntityIndex index;
+    index.Build(baseEntities, baseCount);
+    std::vector<entt::entity> entities;
+    for (auto [entity] : registry.storage<entt::entity>()->each())
+        if (index.Find(entity, baseEntities) < 0) entities.push_back(entity);
+    out.Write(uint32_t(entities.size()));
+    out.WriteArray(entities.data(), entities.size(), sizeof(entt::entity));
+
+    entities.clear();
+    for (uint32_t i = 0; i < baseCount; ++i)
+        if (!registry.valid(baseEntities[i])) entities.push_back(baseEntities[i]);
+    out.Write(uint32_t(entities.size()));
+    out.WriteArray(entities.data(), entities.size(), sizeof(entt::entity));
+
+    WriteDeltaBlocks(SnapshotComponents{}, out, registry, in);
+}
+
+// Restores a full snapshot, or applies a delta to the registry as restored from the delta's base. Entities keep
+// their identifiers. Returns false, without touching the registry, if the snapshot is not one of this build's.
+inline bool RestoreSnapshot(entt::registry& registry, const RegistrySnapshot& snapshot) {
+    SnapshotReader in{ snapshot.bytes };
+    const bool delta = ReadSnapshotHeader(in);
+    const uint32_t createdCount = in.Read<uint32_t>();
+    const entt::entity* created = in.ReadArray<entt::entity>(createdCount);
+    const uint32_t destroyedCount = in.Read<uint32_t>();
+    const entt::entity* destroyed = in.ReadArray<entt::entity>(destroyedCount);
+    SnapshotReader blocks = in;
+    if (!in.ok || !ValidSnapshotBlocks(SnapshotComponents{}, blocks)) return false;
+
+    if (delta) {
+        for (uint32_t i = 0; i < destroyedCount; ++i)
+            if (registry.valid(destroyed[i])) registry.destroy(destroyed[i]);
+    }
+    else {
+        // Destroy the entities that the snapshot does not have
+        SnapshotEntityIndex index;
+        index.Build(created, createdCount);
+        std::vector<entt::entity> extra;
+        for (auto [entity] : registry.storage<entt::entity>().each())
+            if (index.Find(entity, created) < 0) extra.push_back(entity);
+        for (auto entity : extra) registry.destroy(entity);
+    }
+    for (uint32_t i = 0; i < createdCount; ++i) {
+        if (registry.valid(created[i])) continue;
+        [[maybe_unused]] const entt::entity entity = registry.create(created[i]);
+        assert(entity == created[i]);
+    }
+
+    RestoreSnapshotBlocks(SnapshotComponents{}, in, registry, delta);
+    return true;
+}
+
+inline bool SaveSnapshot(const RegistrySnapshot& snapshot, const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(snapshot.bytes.data()), std::streamsize(snapshot.bytes.size()));
+    return bool(file);
+}
+
+// Reads a snapshot written by SaveSnapshot. Returns false if the file is missing or not one of this build's.
+inline bool LoadSnapshot(RegistrySnapshot& snapshot, const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    snapshot.bytes.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(snapshot.bytes.data()), std::streamsize(snapshot.bytes.size()));
+
+    SnapshotReader in{ snapshot.bytes };
+    ReadSnapshotHeader(in);
+    in.ReadArray<entt::entity>(in.Read<uint32_t>());
+    in.ReadArray<entt::entity>(in.Read<uint32_t>());
+    return file && in.ok && ValidSnapshotBlocks(SnapshotComponents{}, in);
+}
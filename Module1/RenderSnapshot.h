@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "RenderableMesh.hpp"
+#include "ShapeRenderer.hpp"
+
+// Everything Game::render draws, copied out of the game state by Game::extract. Rendering reads nothing else, so
+// the engine can run the next updates on another thread while the main thread submits this frame. Kept between
+// frames so that a scene of the same size allocates nothing.
+struct RenderSnapshot {
+    struct MeshInstance {
+        eeng::RenderableMesh* mesh = nullptr;  // Meshes are unloaded only once the game stops, never while it renders
+        glm::mat4 worldMatrix{ 1.0f };
+        eeng::RenderableMesh::Pose pose;    // Bone palette and node transforms at extraction
+    };
+
+    struct DebugSphere {
+        glm::vec3 center;
+        float radius;
+        ShapeRendering::Color4u color;
+    };
+
+    struct DebugBox {
+        glm::vec3 min, max;
+        ShapeRendering::Color4u color;
+    };
+
+    // Camera and light
+    glm::mat4 P{ 1.0f }, V{ 1.0f };
+    glm::vec3 eyePos{ 0.0f };
+    glm::vec3 lightPos{ 0.0f }, lightColor{ 1.0f };
+
+    std::vector<MeshInstance> meshes;
+    bool drawSkeleton = false;              // Bone axes of each mesh, axisLen long
+    float axisLen = 1.0f;
+    std::vector<DebugSphere> spheres;       // Sphere colliders
+    std::vector<DebugBox> boxes;            // AABB colliders
+    glm::vec3 viewRayStart{ 0.0f }, viewRayEnd{ 0.0f };
+    bool viewRayHit = false;
+};
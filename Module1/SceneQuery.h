@@ -0,0 +1,262 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "Components.h"
+#include "CollisionSoA.h"
+#include "CollisionQuery.h"
+#include "ThreadPool.hpp"
+#include "StaticCollisionWorld.h"
+
+struct SceneHit {
+    entt::entity entity = entt::null;
+    float distance = 0.0f;
+    glm::vec3 point{ 0.0f };
+};
+
+struct SceneRay {
+    glm::vec3 origin;
+    glm::vec3 dir;      // Normalized
+    float maxDistance = 1000.0f;
+    float radius = 0.0f; // > 0 for sphere-casts
+    uint32_t mask = LayerAll;
+};
+
+// Raycasts, sphere-casts and overlap queries against the colliders of the current frame.
+// Dynamic colliders are tested in SIMD batches straight from the collider SoA, static ones
+// through the static world's AABB tree, triangle meshes through their own BVHs, and
+// heightfields by ray marching.
+// Colliders are hit on their AABB if they have one, otherwise on their sphere. Sphere-casts
+// against AABBs use the box grown by the radius, which is slightly conservative at the box
+// edges. Sphere-casts do not test triangle meshes or heightfields.
+//
+// Valid until the collider SoA is refreshed the next frame.
+class SceneQuery {
+public:
+    SceneQuery(const eeng::ColliderSoA& soa, const StaticCollisionWorld& staticWorld)
+        : soa(soa), staticWorld(staticWorld) {
+    }
+
+    // Closest hit along the ray
+    bool Raycast(const SceneRay& ray, SceneHit& hit) const {
+        bool found = RaycastSurfaces(ray, ray.maxDistance, hit);
+        SceneRay shortened = ray;
+        if (found) shortened.maxDistance = hit.distance;
+        ForEachHit(shortened, true, [&](size_t i, float t) {
+            hit = MakeHit(ray, i, t);
+            found = true;
+        });
+        return found;
+    }
+
+    // All hits along the ray, nearest first. Each mesh and heightfield is reported once, at its nearest hit.
+    void RaycastAll(const SceneRay& ray, std::vector<SceneHit>& hits) const {
+        hits.clear();
+        ForEachHit(ray, false, [&](size_t i, float t) { hits.push_back(MakeHit(ray, i, t)); });
+        if (ray.radius <= 0.0f) {
+            for (const auto& mesh : staticWorld.Meshes()) {
+                const float o[3]{ ray.origin.x, ray.origin.y, ray.origin.z }, d[3]{ ray.dir.x, ray.dir.y, ray.dir.z };
+                eeng::TriangleHit triangleHit;
+                if ((mesh.layer & ray.mask) && mesh.bvh->raycast(o, d, ray.maxDistance, triangleHit))
+                    hits.push_back({ mesh.entity, triangleHit.t, ray.origin + ray.dir * triangleHit.t });
+            }
+            for (const auto& field : staticWorld.Heightfields()) {
+                const float o[3]{ ray.origin.x, ray.origin.y, ray.origin.z }, d[3]{ ray.dir.x, ray.dir.y, ray.dir.z };
+                float t;
+                if ((field.layer & ray.mask) && field.heightfield->raycast(o, d, ray.maxDistance, t))
+                    hits.push_back({ field.entity, t, ray.origin + ray.dir * t });
+            }
+        }
+        std::sort(hits.begin(), hits.end(), [](const SceneHit& a, const SceneHit& b) { return a.distance < b.distance; });
+    }
+
+    // Closest hit of a sphere swept along the ray
+    bool SphereCast(SceneRay ray, float radius, SceneHit& hit) const {
+        ray.radius = radius;
+        return Raycast(ray, hit);
+    }
+
+    // True if nothing in mask lies between from and to. Meshes and heightfields are tested first and stop at
+    // their first hit, which makes this cheaper than a Raycast when the view is blocked by level geometry.
+    bool LineOfSight(const glm::vec3& from, const glm::vec3& to, uint32_t mask = LayerAll) const {
+        const float distance = glm::distance(from, to);
+        if (distance <= 0.0f) return true;
+        const glm::vec3 dir = (to - from) / distance;
+        if (staticWorld.SurfacesBlock(from, dir, distance, mask)) return false;
+        bool blocked = false;
+        ForEachHit({ from, dir, distance, 0.0f, mask }, true, [&](size_t, float) { blocked = true; });
+        return !blocked;
+    }
+
+    // Entities whose colliders overlap the sphere
+    void Overlap(const glm::vec3& center, float radius, std::vector<entt::entity>& entities, uint32_t mask = LayerAll) const {
+        entities.clear();
+        eeng::ColliderQuery query{ center.x, center.y, center.z, radius,
+            { center.x - radius, center.y - radius, center.z - radius },
+            { center.x + radius, center.y + radius, center.z + radius } };
+
+        auto test = [&](size_t i) {
+            if (!(soa.layer[i] & mask)) return;
+            const eeng::ColliderLanes lane(soa, i);
+            const bool hit = (soa.flags[i] & eeng::ColliderHasAABB)
+                ? eeng::overlap_aabbs_scalar(lane, query, 1)
+                : eeng::overlap_spheres_scalar(lane, query, 1);
+            if (hit) entities.push_back(static_cast<entt::entity>(soa.owner[i]));
+        };
+
+        staticWorld.QueryColliders(query.min, query.max, [&](uint32_t i) { test(i); });
+        for (size_t i = staticWorld.StaticCount(); i < soa.count; ++i) test(i);
+        staticWorld.QueryMeshes(query.min, query.max, [&](const StaticCollisionWorld::StaticMesh& mesh) {
+            const float c[3]{ center.x, center.y, center.z };
+            if ((mesh.layer & mask) && mesh.bvh->overlaps_sphere(c, radius)) entities.push_back(mesh.entity);
+        });
+        // Heightfields are solid below their surface
+        for (const auto& field : staticWorld.Heightfields()) {
+            if ((field.layer & mask) && field.heightfield->contains(center.x, center.z) &&
+                center.y - radius <= field.heightfield->height(center.x, center.z))
+                entities.push_back(field.entity);
+        }
+    }
+
+    // Closest hit for each ray in a packet. found[i] is set to 1 if ray i hit something, and only then is hits[i] written.
+    // Dynamic collider batches are loaded once and tested against every ray of the packet before moving on.
+    // Packets are spread over the thread pool if given.
+    void RaycastBatch(const SceneRay* rays, size_t count, SceneHit* hits, uint8_t* found, eeng::ThreadPool* threadPool = nullptr) const {
+        auto runPacket = [&](size_t begin, size_t end, size_t) {
+            eeng::RayQuery queries[PacketSize];
+            float best[PacketSize];
+            size_t bestIndex[PacketSize];
+            SceneHit surfaceHits[PacketSize];
+
+            for (size_t p = begin; p < end; p += PacketSize) {
+                const size_t n = std::min(PacketSize, end - p);
+                for (size_t r = 0; r < n; ++r) {
+                    queries[r] = MakeQuery(rays[p + r]);
+                    best[r] = queries[r].t_max;
+                    bestIndex[r] = SIZE_MAX;
+                    // Statics first, to shrink the rays before the brute-force dynamic pass
+                    if (RaycastSurfaces(rays[p + r], best[r], surfaceHits[r])) {
+                        best[r] = surfaceHits[r].distance; bestIndex[r] = SurfaceHitIndex; queries[r].t_max = best[r];
+                    }
+                    TraverseStatic(queries[r], rays[p + r].mask, true, [&](size_t i, float t) {
+                        best[r] = t; bestIndex[r] = i; queries[r].t_max = t;
+                    });
+                }
+
+                for (size_t first = staticWorld.StaticCount() / W * W; first < soa.count; first += W) {
+                    const eeng::ColliderLanes lanes(soa, first);
+                    const uint32_t valid = ValidLanes(first);
+                    for (size_t r = 0; r < n; ++r) {
+                        TestBatch(lanes, first, valid, queries[r], rays[p + r].mask, [&](size_t i, float t) {
+                            if (t < best[r]) { best[r] = t; bestIndex[r] = i; queries[r].t_max = t; }
+                        });
+                    }
+                }
+
+                for (size_t r = 0; r < n; ++r) {
+                    found[p + r] = bestIndex[r] != SIZE_MAX;
+                    if (bestIndex[r] == SurfaceHitIndex) hits[p + r] = surfaceHits[r];
+                    else if (found[p + r]) hits[p + r] = MakeHit(rays[p + r], bestIndex[r], best[r]);
+                }
+            }
+        };
+
+        if (threadPool) threadPool->parallel_for(count, PacketSize * 4, runPacket);
+        else runPacket(0, count, 0);
+    }
+
+private:
+    static constexpr size_t W = eeng::CollisionBatchWidth;
+    static constexpr size_t PacketSize = 16;
+    static constexpr size_t SurfaceHitIndex = SIZE_MAX - 1;    // Marks a packet ray whose closest hit is on a mesh or heightfield
+
+    static eeng::RayQuery MakeQuery(const SceneRay& ray) {
+        const float o[3]{ ray.origin.x, ray.origin.y, ray.origin.z };
+        const float d[3]{ ray.dir.x, ray.dir.y, ray.dir.z };
+        return eeng::RayQuery::make(o, d, ray.maxDistance, ray.radius);
+    }
+
+    SceneHit MakeHit(const SceneRay& ray, size_t i, float t) const {
+        return { static_cast<entt::entity>(soa.owner[i]), t, ray.origin + ray.dir * t };
+    }
+
+    // Closest mesh or heightfield hit within maxDistance. Sphere-casts skip both.
+    bool RaycastSurfaces(const SceneRay& ray, float maxDistance, SceneHit& hit) const {
+        if (ray.radius > 0.0f) return false;
+        StaticCollisionWorld::SurfaceHit surfaceHit;
+        if (!staticWorld.RaycastSurfaces(ray.origin, ray.dir, maxDistance, ray.mask, surfaceHit)) return false;
+        hit = { surfaceHit.entity, surfaceHit.distance, ray.origin + ray.dir * surfaceHit.distance };
+        return true;
+    }
+
+    // Lanes in [first, first + W) that are dynamic colliders
+    uint32_t ValidLanes(size_t first) const {
+        const size_t lo = std::max(first, staticWorld.StaticCount());
+        const size_t hi = std::min(first + W, soa.count);
+        if (hi <= lo) return 0;
+        const uint32_t upTo = (hi - first >= 32) ? ~0u : ((1u << (hi - first)) - 1);
+        return upTo & ~((1u << (lo - first)) - 1);
+    }
+
+    // Calls func(index, t) for hits in one batch of dynamic colliders
+    template<class F>
+    void TestBatch(const eeng::ColliderLanes& lanes, size_t first, uint32_t valid, const eeng::RayQuery& query, uint32_t mask, F&& func) const {
+        float t[W], ts[W];
+        uint32_t hitMask = eeng::ray_aabbs<W>(lanes, query, t) & valid;
+
+        // Colliders with a sphere only have an empty box and need the sphere test
+        uint32_t sphereOnly = 0;
+        for (size_t k = 0; k < W; ++k)
+            if ((valid >> k & 1u) && (soa.flags[first + k] & (eeng::ColliderHasAABB | eeng::ColliderHasSphere)) == eeng::ColliderHasSphere)
+                sphereOnly |= 1u << k;
+        if (sphereOnly) {
+            const uint32_t sphereHits = eeng::ray_spheres_scalar(lanes, query, W, ts) & sphereOnly;
+            for (size_t k = 0; k < W; ++k) if (sphereHits >> k & 1u) t[k] = ts[k];
+            hitMask |= sphereHits;
+        }
+
+        while (hitMask) {
+            const int k = std::countr_zero(hitMask);
+            hitMask &= hitMask - 1;
+            if (soa.layer[first + k] & mask) func(first + k, t[k]);
+        }
+    }
+
+    template<class F>
+    void TraverseStatic(const eeng::RayQuery& query, uint32_t mask, bool closest, F&& func) const {
+        staticWorld.RaycastColliders(query.o, query.inv_d, query.t_max, query.radius, [&](uint32_t i, float tMax) {
+            if (!(soa.layer[i] & mask)) return tMax;
+            eeng::RayQuery q = query;
+            q.t_max = tMax;
+            float t;
+            if (!eeng::ray_collider(soa, i, q, t)) return tMax;
+            func(i, t);
+            return closest ? t : tMax;
+        });
+    }
+
+    // Calls func(index, t) for hits. With closest set, only hits nearer than all previous ones are reported.
+    template<class F>
+    void ForEachHit(const SceneRay& ray, bool closest, F&& func) const {
+        eeng::RayQuery query = MakeQuery(ray);
+        TraverseStatic(query, ray.mask, closest, [&](size_t i, float t) {
+            func(i, t);
+            if (closest) query.t_max = t;
+        });
+        for (size_t first = staticWorld.StaticCount() / W * W; first < soa.count; first += W) {
+            TestBatch(eeng::ColliderLanes(soa, first), first, ValidLanes(first), query, ray.mask, [&](size_t i, float t) {
+                if (closest) {
+                    if (t >= query.t_max) return;
+                    query.t_max = t;
+                }
+                func(i, t);
+            });
+        }
+    }
+
+    const eeng::ColliderSoA& soa;
+    const StaticCollisionWorld& staticWorld;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include "Components.h"
+#include "CollisionSoA.h"
+#include "AABBTree.h"
+#include "TriangleMeshBVH.h"
+#include "Heightfield.h"
+
+// Collision data for colliders that never move: static sphere/AABB colliders (StaticColliderTag),
+// all planes, all triangle meshes (MeshColliderComponent) and all heightfields (HeightfieldColliderComponent). Built once and kept until Invalidate() is called, e.g. after a level load or
+// after moving a static entity.
+//
+// Static colliders occupy the first StaticCount() slots of the collider SoA, so dynamic colliders
+// can be paired with them using plain SoA indices.
+class StaticCollisionWorld {
+public:
+    void Invalidate() { dirty = true; }
+    bool IsDirty() const { return dirty; }
+
+    // A triangle-mesh collider with its world-space bounds
+    struct StaticMesh {
+        entt::entity entity = entt::null;
+        std::shared_ptr<const eeng::TriangleMeshBVH> bvh;
+        uint32_t layer = LayerStatic;
+        float min[3], max[3];
+    };
+
+    // A heightfield collider with its world-space bounds
+    struct StaticHeightfield {
+        entt::entity entity = entt::null;
+        std::shared_ptr<const eeng::Heightfield> heightfield;
+        uint32_t layer = LayerStatic;
+        float min[3], max[3];
+    };
+
+    // Hit on a mesh or heightfield
+    struct SurfaceHit {
+        entt::entity entity = entt::null;
+        float distance = 0.0f;
+        glm::vec3 normal{ 0.0f };
+    };
+
+    // Index the first staticCount colliders of soa, the given planes, meshes and heightfields
+    void Build(const eeng::ColliderSoA& soa, size_t staticCount, const std::vector<PlaneColliderComponent>& planes,
+        std::vector<StaticMesh> meshes = {}, std::vector<StaticHeightfield> heightfields = {}) {
+        this->staticCount = staticCount;
+
+        // Index each collider by the box around its sphere and AABB
+        std::vector<float> bounds[6];
+        for (auto& b : bounds) b.resize(staticCount);
+        for (size_t i = 0; i < staticCount; ++i) {
+            float min[3], max[3];
+            soa.bounds(i, min, max);
+            for (int a = 0; a < 3; ++a) {
+                bounds[a][i] = min[a];
+                bounds[3 + a][i] = max[a];
+            }
+        }
+        tree.build(
+            bounds[0].data(), bounds[1].data(), bounds[2].data(),
+            bounds[3].data(), bounds[4].data(), bounds[5].data(),
+            staticCount);
+
+        for (auto& axis : axisPlanes) axis.clear();
+        otherPlanes.clear();
+        for (const auto& plane : planes) {
+            int axis = -1;
+            for (int a = 0; a < 3; ++a)
+                if (std::abs(plane.normal[a]) == 1.0f) axis = a;
+            if (axis >= 0) axisPlanes[axis].push_back({ plane.position[axis], plane });
+            else otherPlanes.push_back(plane);
+        }
+        for (auto& axis : axisPlanes)
+            std::sort(axis.begin(), axis.end(), [](const AxisPlane& a, const AxisPlane& b) { return a.offset < b.offset; });
+
+        this->meshes = std::move(meshes);
+        for (auto& mesh : this->meshes)
+            mesh.bvh->bounds(mesh.min, mesh.max);
+        this->heightfields = std::move(heightfields);
+        for (auto& field : this->heightfields)
+            field.heightfield->bounds(field.min, field.max);
+
+        dirty = false;
+    }
+
+    size_t StaticCount() const { return staticCount; }
+
+    // Calls func(soaIndex) for each static collider whose bounds overlap [min, max]
+    template<class F>
+    void QueryColliders(const float min[3], const float max[3], F&& func) const {
+        tree.query(min, max, std::forward<F>(func));
+    }
+
+    // Calls func(soaIndex, tMax) for each static collider whose bounds, grown by inflate, the ray hits within tMax.
+    // func returns the new tMax. invDir is the inverse ray direction, see eeng::RayQuery.
+    template<class F>
+    void RaycastColliders(const float origin[3], const float invDir[3], float tMax, float inflate, F&& func) const {
+        tree.raycast(origin, invDir, tMax, inflate, std::forward<F>(func));
+    }
+
+    // Calls func(plane) for each plane within extent of center along the plane normal,
+    // extent being a sphere radius or AABB half widths per axis.
+    template<class F>
+    void QueryPlanes(const glm::vec3& center, const glm::vec3& extent, F&& func) const {
+        // Axis-aligned planes: binary search on the plane offset
+        for (int a = 0; a < 3; ++a) {
+            const auto& planes = axisPlanes[a];
+            auto it = std::lower_bound(planes.begin(), planes.end(), center[a] - extent[a],
+                [](const AxisPlane& p, float v) { return p.offset < v; });
+            for (; it != planes.end() && it->offset <= center[a] + extent[a]; ++it)
+                func(it->plane);
+        }
+        for (const auto& plane : otherPlanes) {
+            const float r = glm::dot(extent, glm::abs(plane.normal));
+            if (std::abs(glm::dot(plane.normal, center - plane.position)) <= r)
+                func(plane);
+        }
+    }
+
+    const std::vector<StaticMesh>& Meshes() const { return meshes; }
+
+    // Calls func(mesh) for each mesh whose bounds overlap [min, max]. Scenes hold few meshes, so they are
+    // checked one by one, and each mesh's own BVH does the rest.
+    template<class F>
+    void QueryMeshes(const float min[3], const float max[3], F&& func) const {
+        for (const auto& mesh : meshes) {
+            if (mesh.min[0] > max[0] || min[0] > mesh.max[0] || mesh.min[1] > max[1] ||
+                min[1] > mesh.max[1] || mesh.min[2] > max[2] || min[2] > mesh.max[2])
+                continue;
+            func(mesh);
+        }
+    }
+
+    const std::vector<StaticHeightfield>& Heightfields() const { return heightfields; }
+
+    // Closest hit along a ray against the meshes and heightfields in mask, within maxDistance. dir is normalized.
+    bool RaycastSurfaces(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, uint32_t mask, SurfaceHit& hit) const {
+        const float o[3]{ origin.x, origin.y, origin.z };
+        const float d[3]{ dir.x, dir.y, dir.z };
+        bool found = false;
+        for (const auto& mesh : meshes) {
+            eeng::TriangleHit triangleHit;
+            if (!(mesh.layer & mask) || !mesh.bvh->raycast(o, d, maxDistance, triangleHit)) continue;
+            maxDistance = triangleHit.t;
+            hit = { mesh.entity, triangleHit.t, glm::vec3(triangleHit.normal[0], triangleHit.normal[1], triangleHit.normal[2]) };
+            found = true;
+        }
+        for (const auto& field : heightfields) {
+            float t;
+            if (!(field.layer & mask) || !field.heightfield->raycast(o, d, maxDistance, t)) continue;
+            maxDistance = t;
+            const glm::vec3 p = origin + dir * t;
+            hit = { field.entity, t, glm::vec3(0.0f) };
+            field.heightfield->normal(p.x, p.z, &hit.normal.x);
+            found = true;
+        }
+        return found;
+    }
+
+    // True if a mesh or heightfield in mask blocks the segment from origin to origin + dir * maxDistance.
+    // Stops at the first hit.
+    bool SurfacesBlock(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, uint32_t mask) const {
+        const float o[3]{ origin.x, origin.y, origin.z };
+        const float d[3]{ dir.x, dir.y, dir.z };
+        float t;
+        for (const auto& field : heightfields)
+            if ((field.layer & mask) && field.heightfield->raycast(o, d, maxDistance, t)) return true;
+        for (const auto& mesh : meshes)
+            if ((mesh.layer & mask) && mesh.bvh->any_hit(o, d, maxDistance)) return true;
+        return false;
+    }
+
+    // Height of the highest heightfield in mask at each of count positions, given as separate x and z arrays.
+    // covered[i] is cleared for positions outside all heightfields, whose height is left as is.
+    void HeightfieldHeights(const float* x, const float* z, size_t count, uint32_t mask, float* heights, uint8_t* covered) const {
+        std::fill(covered, covered + count, uint8_t(0));
+        std::vector<float> fieldHeights(count);
+        for (const auto& field : heightfields) {
+            if (!(field.layer & mask)) continue;
+            field.heightfield->heights(x, z, count, fieldHeights.data());
+            for (size_t i = 0; i < count; ++i) {
+                if (!field.heightfield->contains(x[i], z[i])) continue;
+                heights[i] = covered[i] ? std::max(heights[i], fieldHeights[i]) : fieldHeights[i];
+                covered[i] = 1;
+            }
+        }
+    }
+
+private:
+    struct AxisPlane {
+        float offset;
+        PlaneColliderComponent plane;
+    };
+
+    bool dirty = true;
+    size_t staticCount = 0;
+    eeng::AABBTree tree;
+    std::vector<AxisPlane> axisPlanes[3];
+    std::vector<PlaneColliderComponent> otherPlanes;
+    std::vector<StaticMesh> meshes;
+    std::vector<StaticHeightfield> heightfields;
+};
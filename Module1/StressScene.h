@@ -0,0 +1,167 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/constants.hpp>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <random>
+#include <algorithm>
+#include <type_traits>
+#include "Components.h"
+#include "RegistrySnapshot.h"
+#include "RenderSnapshot.h"
+#include "SystemScheduler.hpp"
+#include "Log.hpp"
+
+// Procedural scene for finding where the systems stop scaling: animated NPCs walking looping waypoint paths,
+// static props with colliders and food items, spread over a square centered at the origin. Spawned on top of the
+// hand-built scene. Run it headless for a fixed number of steps (see main.cpp) and read the report at exit.
+struct StressSceneSettings {
+    size_t npcs = 0;
+    size_t staticColliders = 0;
+    size_t food = 0;
+    float areaSize = 200.0f;    // Side of the square, in meters
+    uint32_t seed = 1;
+
+    bool Enabled() const { return npcs || staticColliders || food; }
+};
+
+// Call before the first collider refresh, which builds the static collision world from the props
+inline void SpawnStressScene(entt::registry& registry, const StressSceneSettings& settings, MeshHandle npcMesh, MeshHandle propMesh) {
+    std::mt19937 rng(settings.seed);
+    const float half = settings.areaSize * 0.5f;
+    std::uniform_real_distribution<float> coordinate(-half, half), unit(0.0f, 1.0f);
+    auto randomPoint = [&] { return glm::vec3(coordinate(rng), 0.0f, coordinate(rng)); };
+
+    // Same components as the hand-built NPC, minus navigation. Each walks a loop of 3 to 5 points near its start.
+    for (size_t i = 0; i < settings.npcs; i++) {
+        const glm::vec3 start = randomPoint();
+        const entt::entity entity = registry.create();
+        registry.emplace<TransformComponent>(entity, start, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.03f));
+        registry.emplace<MeshComponent>(entity, npcMesh);
+        registry.emplace<WorldMatrixComponent>(entity);
+        registry.emplace<AnimeComponent>(entity, AnimState::Start, AnimState::Idle, 0.5f, 0.0f, 0.0f, true);
+        registry.emplace<LinearVelocityComponent>(entity, glm::vec3{ 0.0f });
+        registry.emplace<SleepComponent>(entity);
+        registry.emplace<GroundComponent>(entity);
+        registry.emplace<CrowdAgentComponent>(entity);
+        registry.emplace<PreviousTransformComponent>(entity, start);
+
+        NPCWaypointComponent path;
+        const size_t points = 3 + rng() % 3;
+        for (size_t p = 0; p < points; p++) {
+            const glm::vec3 offset(unit(rng) * 20.0f - 10.0f, 0.0f, unit(rng) * 20.0f - 10.0f);
+            path.waypoints.push_back(glm::clamp(start + offset, glm::vec3(-half, 0.0f, -half), glm::vec3(half, 0.0f, half)));
+        }
+        path.speed = 1.5f + unit(rng) * 1.5f;
+        registry.emplace<NPCWaypointComponent>(entity, std::move(path));
+
+        registry.emplace<SphereColliderComponent>(entity, glm::vec3(0.0f, 1.1f, 0.0f), 1.1f, false, false, false,
+            LayerNPC, NPCCollisionMask);
+        registry.emplace<AABBColliderComponent>(entity, glm::vec3(0.0f, 1.1f, 0.0f), glm::vec3(1.1f), true, false,
+            LayerNPC, NPCCollisionMask);
+    }
+
+    // Static props drawn with the prop mesh, on LayerStatic so that the NPCs walking among them collide with them
+    for (size_t i = 0; i < settings.staticColliders; i++) {
+        const float radius = 0.5f + unit(rng) * 1.5f;
+        const float yaw = unit(rng) * glm::two_pi<float>();
+        const entt::entity entity = registry.create();
+        registry.emplace<TransformComponent>(entity, randomPoint(), glm::quat(glm::vec3(0.0f, yaw, 0.0f)), glm::vec3(0.01f));
+        registry.emplace<MeshComponent>(entity, propMesh);
+        registry.emplace<WorldMatrixComponent>(entity);
+        registry.emplace<StaticColliderTag>(entity);
+        registry.emplace<SphereColliderComponent>(entity, glm::vec3(0.0f, radius, 0.0f), radius, false, false, false,
+            LayerStatic, LayerPlayer | LayerNPC | LayerAnimal);
+        registry.emplace<AABBColliderComponent>(entity, glm::vec3(0.0f, radius, 0.0f), glm::vec3(radius), true, false,
+            LayerStatic, LayerPlayer | LayerNPC | LayerAnimal);
+    }
+
+    // Same as the hand-built food
+    for (size_t i = 0; i < settings.food; i++) {
+        const glm::vec3 position = randomPoint();
+        const glm::vec3 center = position + glm::vec3(0.0f, 0.5f, 0.0f);
+        const float radius = 0.3f;
+        const entt::entity entity = registry.create();
+        registry.emplace<TransformComponent>(entity, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+        registry.emplace<FoodComponent>(entity, false);
+        registry.emplace<AABBColliderComponent>(entity, center, glm::vec3(radius), false, false, LayerFood, LayerPlayer);
+        registry.emplace<SphereColliderComponent>(entity, center, radius, true, false, false, LayerFood, LayerPlayer);
+    }
+}
+
+// Per-stage timings of a stress run, as mean and worst over the frames recorded
+struct StressReport {
+    struct Timing {
+        std::string name;
+        double totalMs = 0.0;
+        float maxMs = 0.0f;
+        size_t samples = 0;
+    };
+
+    std::vector<Timing> timings;    // In order of first record
+    size_t frames = 0;
+
+    void Record(const std::string& name, float ms) {
+        auto it = std::find_if(timings.begin(), timings.end(), [&](const Timing& timing) { return timing.name == name; });
+        if (it == timings.end()) it = timings.insert(timings.end(), Timing{ name });
+        it->totalMs += ms;
+        it->maxMs = std::max(it->maxMs, ms);
+        it->samples++;
+    }
+
+    // Call after each run of the scheduler
+    void RecordSystems(const eeng::SystemScheduler& scheduler) {
+        frames++;
+        for (size_t i = 0; i < scheduler.size(); i++)
+            Record(scheduler.info(i).name, scheduler.info(i).ms);
+        Record("Systems (wall)", scheduler.frame_ms());
+    }
+};
+
+// Packed entities and components of one type. The sparse arrays, shared by all types, are left out.
+template<class T>
+size_t StorageBytes(const entt::registry& registry) {
+    const auto* storage = registry.storage<T>();
+    if (!storage) return 0;
+    return storage->capacity() * (sizeof(entt::entity) + (std::is_empty_v<T> ? 0 : sizeof(T)));
+}
+
+template<class... T>
+size_t LogStorageBytes(ComponentList<T...>, const entt::registry& registry) {
+    size_t total = 0;
+    auto log = [&](std::string_view name, size_t count, size_t bytes) {
+        if (!count) return;
+        eeng::Log("  %-40.*s %8zu %10.1f KB", int(name.size()), name.data(), count, bytes / 1024.0f);
+        total += bytes;
+    };
+    (log(entt::type_id<T>().name(), registry.storage<T>() ? registry.storage<T>()->size() : 0, StorageBytes<T>(registry)), ...);
+    return total;
+}
+
+inline void LogStressReport(const StressReport& report, const StressSceneSettings& settings, const entt::registry& registry,
+    const RenderSnapshot& snapshot) {
+    eeng::Log("Stress scene: %zu NPCs, %zu static colliders, %zu food over %.0f x %.0f m, %zu frames",
+        settings.npcs, settings.staticColliders, settings.food, settings.areaSize, settings.areaSize, report.frames);
+
+    eeng::Log("  %-40s %10s %10s", "Stage", "mean ms", "max ms");
+    for (const auto& timing : report.timings)
+        eeng::Log("  %-40s %10.3f %10.3f", timing.name.c_str(), timing.samples ? timing.totalMs / timing.samples : 0.0, timing.maxMs);
+
+    eeng::Log("  %-40s %8s %13s", "Storage", "count", "memory");
+    size_t total = LogStorageBytes(SnapshotComponents{}, registry);
+    total += LogStorageBytes(ComponentList<NPCWaypointComponent, NavigationAgentComponent>{}, registry);
+
+    size_t waypointBytes = 0;
+    for (auto [entity, path] : registry.view<NPCWaypointComponent>().each())
+        waypointBytes += path.waypoints.capacity() * sizeof(glm::vec3);
+    size_t snapshotBytes = snapshot.meshes.capacity() * sizeof(RenderSnapshot::MeshInstance);
+    for (const auto& instance : snapshot.meshes)
+        snapshotBytes += (instance.pose.boneMatrices.capacity() + instance.pose.meshMatrices.capacity()) * sizeof(glm::mat4);
+    eeng::Log("  %-40s %8s %10.1f KB", "Waypoint lists", "", waypointBytes / 1024.0f);
+    eeng::Log("  %-40s %8zu %10.1f KB", "Render snapshot", snapshot.meshes.size(), snapshotBytes / 1024.0f);
+    eeng::Log("  %-40s %8s %10.1f KB", "Total", "", (total + waypointBytes + snapshotBytes) / 1024.0f);
+}
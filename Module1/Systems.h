@@ -9,10 +9,22 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <memory>
 #include "ShapeRenderer.hpp"
+#include "CollisionSoA.h"
+#include "ThreadPool.hpp"
+#include "ContactCache.h"
+#include "StaticCollisionWorld.h"
+#include "CollisionWorld.h"
+#include "CollisionSystems.h"
+#include "CrowdWorld.h"
+#include "NavigationGrid.h"
+#include "PathfindingService.hpp"
+#include "RenderSnapshot.h"
+#include "WorldMatrixCache.h"
+#include "DisjointSet.h"
 #include <glm/gtx/quaternion.hpp>
 #include <iostream>
-
-extern std::vector<Sphere*> allSpheres;
+#include <algorithm>
+#include <chrono>
 
 namespace eeng {
     using ForwardRendererPtr = std::shared_ptr<ForwardRenderer>;
@@ -37,14 +49,14 @@ inline void FinalizeBlend(AnimeComponent& anim) {
 }
 
 // Refactored by moving the code which handles jumping into its own function. 
-inline void ApplyJumpPhysics(TransformComponent& tfm, LinearVelocityComponent& vel, AnimeComponent& anim, float deltaTime) {
+inline void ApplyJumpPhysics(TransformComponent& tfm, LinearVelocityComponent& vel, AnimeComponent& anim, float deltaTime, float groundHeight = 0.0f) {
     if (!anim.isGrounded) {
         anim.jumpTime += deltaTime;
         vel.velocity.y += vel.gravity * deltaTime;  
         tfm.position.y += vel.velocity.y * deltaTime;
 
-        if (tfm.position.y < 0.0f) {
-            tfm.position.y = 0.0f;
+        if (tfm.position.y < groundHeight) {
+            tfm.position.y = groundHeight;
             vel.velocity.y = 0.0f;
             anim.jumpTime = 0.0f;
             anim.isGrounded = true;
@@ -103,16 +115,19 @@ inline void PlayerControllerSystem(entt::registry& registry, InputManagerPtr inp
 }
 
 // MovementSystem 
-inline void MovementSystem(entt::registry& registry, float deltaTime) {
-    auto view = registry.view<TransformComponent, LinearVelocityComponent, AnimeComponent>();
-    for (auto entity : view) {
+// Entities are independent of each other, so they are moved in parallel chunks of the view.
+constexpr size_t MovementChunkSize = 64;
+
+inline void MovementSystem(entt::registry& registry, float deltaTime, eeng::ThreadPool& threadPool) {
+    auto view = registry.view<TransformComponent, LinearVelocityComponent, AnimeComponent>(entt::exclude<SleepingTag>);
+    threadPool.parallel_for_each(view, MovementChunkSize, [&](entt::entity entity) {
         auto& tfm   = view.get<TransformComponent>(entity);
         auto& vel   = view.get<LinearVelocityComponent>(entity);
         auto& anim  = view.get<AnimeComponent>(entity);
+        const auto* ground = registry.try_get<GroundComponent>(entity);
         tfm.position += vel.velocity * deltaTime;
-        ApplyJumpPhysics(tfm, vel, anim, deltaTime);
-
-    }
+        ApplyJumpPhysics(tfm, vel, anim, deltaTime, ground ? ground->height : 0.0f);
+    });
 }
 
 inline void HorseFeedingSystem(entt::registry& registry, InputManagerPtr input, std::shared_ptr<PlayerLogic> playerLogic, float deltaTime, QuestState& myQuest) {
@@ -160,9 +175,17 @@ inline void NPCControllerSystem(entt::registry& registry) {
             continue;
         }
 
+        // Height follows the ground, so steer in the horizontal plane only
         glm::vec3 dir = npc.waypoints[npc.currentWaypointIndex] - tfm.position;
+        dir.y = 0.0f;
         if (glm::length2(dir) < proximityThresholdSq) {
-            npc.currentWaypointIndex = (npc.currentWaypointIndex + 1) % npc.waypoints.size();
+            if (!npc.loop && npc.currentWaypointIndex + 1 == npc.waypoints.size()) {
+                npc.waypoints.clear();
+                npc.currentWaypointIndex = 0;
+            }
+            else {
+                npc.currentWaypointIndex = (npc.currentWaypointIndex + 1) % npc.waypoints.size();
+            }
             vel.velocity = glm::vec3(0.0f);
             UpdateAnimState(anim, AnimState::Idle);
         }
@@ -173,44 +196,228 @@ inline void NPCControllerSystem(entt::registry& registry) {
     }
 }
 
-// RenderSystem 
-inline void RenderSystem(entt::registry& registry, eeng::ForwardRendererPtr renderer, ShapeRendererPtr shprenderer, bool drawSkeleton, float axisLen) {
+constexpr size_t CrowdChunkSize = 64;
+
+// Steers crowd agents around each other, after NPCControllerSystem has pointed their velocities at their waypoints.
+// Agents are hashed on the xz-plane once, then each agent, in parallel, looks up its neighbors and adds two terms to
+// its preferred velocity: a push away from neighbors it overlaps, and a sidestep away from neighbors it would come
+// closer to than their combined radii within the time horizon, going by both agents' preferred velocities. Each
+// agent reads only the gathered state and writes only its own velocity, so the result does not depend on the thread
+// count. Vertical velocity, e.g. from jumping, is left alone.
+inline void CrowdSteeringSystem(entt::registry& registry, CrowdWorld& crowd, eeng::ThreadPool& threadPool)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Gather
+    crowd.entities.clear();
+    crowd.x.clear(); crowd.z.clear();
+    crowd.preferredX.clear(); crowd.preferredZ.clear();
+    crowd.radius.clear(); crowd.maxSpeed.clear();
+    auto view = registry.view<TransformComponent, LinearVelocityComponent, NPCWaypointComponent, CrowdAgentComponent>();
+    for (auto entity : view) {
+        const auto& position = view.get<TransformComponent>(entity).position;
+        const auto& velocity = view.get<LinearVelocityComponent>(entity).velocity;
+        crowd.entities.push_back(entity);
+        crowd.x.push_back(position.x);
+        crowd.z.push_back(position.z);
+        crowd.preferredX.push_back(velocity.x);
+        crowd.preferredZ.push_back(velocity.z);
+        crowd.radius.push_back(view.get<CrowdAgentComponent>(entity).radius);
+        crowd.maxSpeed.push_back(view.get<NPCWaypointComponent>(entity).speed);
+    }
+    const size_t count = crowd.entities.size();
+    crowd.velocityX.resize(count);
+    crowd.velocityZ.resize(count);
+    crowd.hash.build(crowd.x.data(), crowd.z.data(), count, crowd.settings.neighborRadius);
+
+    // Steer
+    const auto settings = crowd.settings;
+    std::vector<size_t> chunkPairs((count + CrowdChunkSize - 1) / CrowdChunkSize, 0);
+    threadPool.parallel_for(count, CrowdChunkSize, [&](size_t begin, size_t end, size_t chunk) {
+        for (size_t i = begin; i < end; ++i) {
+            const glm::vec2 position(crowd.x[i], crowd.z[i]);
+            const glm::vec2 preferred(crowd.preferredX[i], crowd.preferredZ[i]);
+            glm::vec2 separation(0.0f), avoidance(0.0f);
+
+            crowd.hash.query(position.x, position.y, settings.neighborRadius, [&](uint32_t j, float distance2) {
+                if (j == i) return;
+                chunkPairs[chunk]++;
+                const glm::vec2 offset = position - glm::vec2(crowd.x[j], crowd.z[j]);
+                const float combined = crowd.radius[i] + crowd.radius[j];
+
+                if (distance2 < combined * combined) {
+                    // Agents on top of each other split along x, in index order
+                    const float distance = std::sqrt(distance2);
+                    const glm::vec2 away = distance > 1e-5f ? offset / distance : glm::vec2(i < j ? -1.0f : 1.0f, 0.0f);
+                    separation += away * (combined - distance) / combined;
+                    return;
+                }
+
+                // Closest approach of the two agents if both keep their preferred velocities
+                const glm::vec2 relative = preferred - glm::vec2(crowd.preferredX[j], crowd.preferredZ[j]);
+                const float speed2 = glm::dot(relative, relative);
+                if (speed2 < 1e-8f) return;
+                const float t = -glm::dot(offset, relative) / speed2;
+                if (t <= 0.0f || t >= settings.timeHorizon) return;
+                const glm::vec2 closest = offset + relative * t;
+                const float closest2 = glm::dot(closest, closest);
+                if (closest2 >= combined * combined) return;
+                // Head-on approaches sidestep to the right of the relative velocity
+                const glm::vec2 away = closest2 > 1e-10f ? closest / std::sqrt(closest2) : glm::normalize(glm::vec2(relative.y, -relative.x));
+                avoidance += away * (1.0f - t / settings.timeHorizon);
+            });
+
+            glm::vec2 velocity = preferred + (separation * settings.separation + avoidance * settings.avoidance) * crowd.maxSpeed[i];
+            const float speed = glm::length(velocity);
+            if (speed > crowd.maxSpeed[i]) velocity *= crowd.maxSpeed[i] / speed;
+            crowd.velocityX[i] = velocity.x;
+            crowd.velocityZ[i] = velocity.y;
+        }
+    });
+
+    // Write back
+    for (size_t i = 0; i < count; ++i) {
+        auto& velocity = view.get<LinearVelocityComponent>(crowd.entities[i]).velocity;
+        velocity.x = crowd.velocityX[i];
+        velocity.z = crowd.velocityZ[i];
+    }
+
+    crowd.stats.agents = count;
+    crowd.stats.neighborPairs = 0;
+    for (size_t pairs : chunkPairs) crowd.stats.neighborPairs += pairs;
+    crowd.stats.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Remembers where moving entities are before an update step changes their transforms. Run first in each update.
+inline void RecordPreviousTransforms(entt::registry& registry) {
+    auto view = registry.view<TransformComponent, PreviousTransformComponent>();
+    for (auto entity : view) {
+        const auto& tfm = view.get<TransformComponent>(entity);
+        auto& previous = view.get<PreviousTransformComponent>(entity);
+        previous.position = tfm.position;
+        previous.rotation = tfm.rotation;
+    }
+}
+
+// Rebuilds the WorldMatrixComponent of each entity whose transform changed since its last build. Changed transforms are
+// gathered first, so that the matrices are built in one tight loop over contiguous arrays, then written back.
+inline void WorldMatrixSystem(entt::registry& registry, WorldMatrixCache& cache) {
+    auto view = registry.view<TransformComponent, WorldMatrixComponent>();
+
+    cache.entities.clear();
+    cache.positions.clear();
+    cache.rotations.clear();
+    cache.scales.clear();
+    size_t count = 0;
+    for (auto entity : view) {
+        const auto& tfm = view.get<TransformComponent>(entity);
+        const auto& world = view.get<WorldMatrixComponent>(entity);
+        count++;
+        if (tfm.position == world.position && tfm.rotation == world.rotation && tfm.scale == world.scale) continue;
+        cache.entities.push_back(entity);
+        cache.positions.push_back(tfm.position);
+        cache.rotations.push_back(tfm.rotation);
+        cache.scales.push_back(tfm.scale);
+    }
+
+    const size_t n = cache.entities.size();
+    cache.matrices.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        cache.matrices[i] = ComposeWorldMatrix(cache.positions[i], cache.rotations[i], cache.scales[i]);
+
+    // Entities in the hierarchy get their matrix when it is propagated, together with their descendants
+    size_t direct = 0;
+    for (size_t i = 0; i < n; ++i) {
+        auto& world = view.get<WorldMatrixComponent>(cache.entities[i]);
+        const size_t node = cache.hierarchy.index_of(cache.entities[i]);
+        if (node == cache.hierarchy.null_index) {
+            world.matrix = cache.matrices[i];
+            direct++;
+        }
+        else cache.hierarchy.set_local_at(node, cache.matrices[i]);
+        world.position = cache.positions[i];
+        world.rotation = cache.rotations[i];
+        world.scale = cache.scales[i];
+    }
+    const size_t propagated = cache.hierarchy.propagate([&](size_t node) {
+        if (auto* world = registry.try_get<WorldMatrixComponent>(cache.hierarchy.payload_at(node)))
+            world->matrix = cache.hierarchy.world_at(node);
+    });
+
+    cache.stats.entities = count;
+    cache.stats.rebuilt = direct + propagated;
+    cache.stats.propagated = propagated;
+}
+
+// Copies the meshes of the registry into the snapshot, with their world matrices and poses. alpha is how far the
+// frame is between the last two update steps; entities with a PreviousTransformComponent are placed that far
+// between their previous and current transforms, relative to their parent if they have one.
+inline void ExtractRenderSystem(entt::registry& registry, const MeshRegistry& meshes, float alpha, const WorldMatrixCache& worldMatrices, RenderSnapshot& snapshot) {
     auto view = registry.view<TransformComponent, MeshComponent>();
+    size_t count = 0;
     for (auto entity : view) {
         auto& tfm = view.get<TransformComponent>(entity);
-        auto& meshComp = view.get<MeshComponent>(entity);
+        auto* mesh = meshes.get(view.get<MeshComponent>(entity).mesh);
+        if (!mesh) continue;
+
+        if (count == snapshot.meshes.size()) snapshot.meshes.emplace_back();
+        auto& instance = snapshot.meshes[count++];
+        instance.mesh = mesh;
+
+        // Movers are drawn in between steps, everything else with its cached matrix
+        if (const auto* previous = registry.try_get<PreviousTransformComponent>(entity)) {
+            instance.worldMatrix = ComposeWorldMatrix(
+                glm::mix(previous->position, tfm.position, alpha),
+                glm::slerp(previous->rotation, tfm.rotation, alpha),
+                tfm.scale);
+            const auto& hierarchy = worldMatrices.hierarchy;
+            const size_t node = hierarchy.index_of(entity);
+            if (node != hierarchy.null_index && hierarchy.parent_index_at(node) != hierarchy.null_index)
+                instance.worldMatrix = hierarchy.world_at(hierarchy.parent_index_at(node)) * instance.worldMatrix;
+        }
+        else if (const auto* world = registry.try_get<WorldMatrixComponent>(entity)) {
+            instance.worldMatrix = world->matrix;
+        }
+        else {
+            instance.worldMatrix = ComposeWorldMatrix(tfm.position, tfm.rotation, tfm.scale);
+        }
+        instance.mesh->getPose(instance.pose);
+    }
+    snapshot.meshes.resize(count);
+}
 
-        if (auto mesh = meshComp.mesh.lock()) {
-            glm::mat4 worldMatrix =
-                glm::translate(tfm.position) *
-                glm::mat4_cast(tfm.rotation) *
-                glm::scale(tfm.scale);
+// RenderSystem 
+// Draws the meshes of a snapshot, and their skeletons if the snapshot's drawSkeleton is set
+inline void RenderSystem(const RenderSnapshot& snapshot, eeng::ForwardRendererPtr renderer, ShapeRendererPtr shprenderer) {
+    const float axisLen = snapshot.axisLen;
+    for (const auto& instance : snapshot.meshes) {
+        const auto* mesh = instance.mesh;
+        const glm::mat4& worldMatrix = instance.worldMatrix;
 
-            renderer->renderMesh(mesh, worldMatrix);
+        renderer->renderMesh(*instance.mesh, worldMatrix, instance.pose);
 
-            if (drawSkeleton) {
-                for (int i = 0; i < mesh->boneMatrices.size(); ++i) {
-                    auto IBinverse = glm::inverse(mesh->m_bones[i].inversebind_tfm);
-                    glm::mat4 global = worldMatrix * mesh->boneMatrices[i] * IBinverse;
-                    glm::vec3 pos = glm::vec3(global[3]);
+        if (snapshot.drawSkeleton) {
+            for (int i = 0; i < instance.pose.boneMatrices.size(); ++i) {
+                auto IBinverse = glm::inverse(mesh->m_bones[i].inversebind_tfm);
+                glm::mat4 global = worldMatrix * instance.pose.boneMatrices[i] * IBinverse;
+                glm::vec3 pos = glm::vec3(global[3]);
 
-                    glm::vec3 right = glm::vec3(global[0]); // X
-                    glm::vec3 up = glm::vec3(global[1]); // Y
-                    glm::vec3 fwd = glm::vec3(global[2]); // Z
+                glm::vec3 right = glm::vec3(global[0]); // X
+                glm::vec3 up = glm::vec3(global[1]); // Y
+                glm::vec3 fwd = glm::vec3(global[2]); // Z
 
-                    shprenderer->push_states(ShapeRendering::Color4u::Red);
-                    shprenderer->push_line(pos, pos + axisLen * right);
+                shprenderer->push_states(ShapeRendering::Color4u::Red);
+                shprenderer->push_line(pos, pos + axisLen * right);
 
-                    shprenderer->push_states(ShapeRendering::Color4u::Green);
-                    shprenderer->push_line(pos, pos + axisLen * up);
+                shprenderer->push_states(ShapeRendering::Color4u::Green);
+                shprenderer->push_line(pos, pos + axisLen * up);
 
-                    shprenderer->push_states(ShapeRendering::Color4u::Blue);
-                    shprenderer->push_line(pos, pos + axisLen * fwd);
+                shprenderer->push_states(ShapeRendering::Color4u::Blue);
+                shprenderer->push_line(pos, pos + axisLen * fwd);
 
-                    shprenderer->pop_states<ShapeRendering::Color4u>();
-                    shprenderer->pop_states<ShapeRendering::Color4u>();
-                    shprenderer->pop_states<ShapeRendering::Color4u>();
-                }
+                shprenderer->pop_states<ShapeRendering::Color4u>();
+                shprenderer->pop_states<ShapeRendering::Color4u>();
+                shprenderer->pop_states<ShapeRendering::Color4u>();
             }
         }
     }
@@ -226,7 +433,7 @@ inline const char* ToString(AnimState state) {
     }
 }
 
-inline void AnimateSystem(entt::registry& registry, float deltaTime, 
+inline void AnimateSystem(entt::registry& registry, const MeshRegistry& meshes, float deltaTime, 
     float totalElapsedTime, float characterAnimSpeed) {
     
     auto view = registry.view<TransformComponent, AnimeComponent, MeshComponent>();
@@ -236,7 +443,8 @@ inline void AnimateSystem(entt::registry& registry, float deltaTime,
         auto& animeComp = view.get<AnimeComponent>(entity);
         auto& meshComp = view.get<MeshComponent>(entity);
 
-        auto mesh = meshComp.mesh.lock();
+        auto* mesh = meshes.get(meshComp.mesh);
+        if (!mesh) continue;
 
         if (animeComp.currentState != animeComp.previousState) {
             animeComp.blendTimer += deltaTime;
@@ -261,523 +469,282 @@ inline void AnimateSystem(entt::registry& registry, float deltaTime,
     }
 }
 
-inline bool SphereSphereIntersection(const glm::vec3& centerA, float radiusA, const glm::vec3& centerB, float radiusB){
-    float distanceSq = glm::distance2(centerA, centerB);
-    float radiusSum = radiusA + radiusB;
-    return distanceSq <= radiusSum * radiusSum;
-}
 
-inline void SphereCollisionSystem(entt::registry& registry)
+// Builds a static triangle-mesh collider from a loaded mesh, in world space. Submeshes are placed the way
+// the renderer places them, by their node transform, and skinned submeshes are left out since they deform.
+inline std::shared_ptr<const eeng::TriangleMeshBVH> BuildMeshCollider(const eeng::RenderableMesh& mesh, const glm::mat4& worldMatrix, bool quantized = false)
 {
-    auto view = registry.view<TransformComponent, SphereColliderComponent>();
-
-    for (auto entity : view) {
-        view.get<SphereColliderComponent>(entity).sphereCollissionTriggered = false;
-    }
-
-    for (auto entityA : view) {
-        const auto& transformA = view.get<TransformComponent>(entityA);
-        auto& colliderA = view.get<SphereColliderComponent>(entityA);
-        glm::vec3 centerA = transformA.position + colliderA.localSphere.center;
-        float radiusA = colliderA.localSphere.radius;
-
-        for (auto entityB : view) {
-            if (entityA == entityB) continue;
-
-            const auto& transformB = view.get<TransformComponent>(entityB);
-            auto& colliderB = view.get<SphereColliderComponent>(entityB);
-            glm::vec3 centerB = transformB.position + colliderB.localSphere.center;
-            float radiusB = colliderB.localSphere.radius;
-
-            if (SphereSphereIntersection(centerA, radiusA, centerB, radiusB)) {
-                colliderA.sphereCollissionTriggered = true;
-                colliderB.sphereCollissionTriggered = true;
-            }
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    for (const auto& submesh : mesh.m_meshes) {
+        if (submesh.is_skinned) continue;
+        glm::mat4 M = worldMatrix;
+        if (submesh.node_index != EENG_NULL_INDEX)
+            M = worldMatrix * mesh.m_nodetree.get_payload_at(submesh.node_index).global_tfm;
+
+        const uint32_t first = static_cast<uint32_t>(positions.size() / 3);
+        for (unsigned v = submesh.base_vertex; v < submesh.base_vertex + submesh.nbr_vertices; ++v) {
+            const glm::vec3 p = glm::vec3(M * glm::vec4(mesh.m_positions[v], 1.0f));
+            positions.insert(positions.end(), { p.x, p.y, p.z });
         }
+        for (unsigned k = submesh.base_index; k < submesh.base_index + submesh.nbr_indices; ++k)
+            indices.push_back(first + mesh.m_indices[k]);
     }
+
+    auto bvh = std::make_shared<eeng::TriangleMeshBVH>();
+    bvh->build(positions.data(), indices.data(), indices.size() / 3, quantized);
+    return bvh;
 }
 
-inline void SpherePlaneCollisionSystem(entt::registry& registry)
+// Reacts to contact transitions only: food is picked up and the player notified when a contact begins
+inline void ContactEventSystem(
+    entt::registry& registry,
+    const ContactPairCache& contactCache,
+    std::shared_ptr<PlayerLogic> playerLogic,
+    QuestState& myQuest)
 {
-    auto spheres = registry.view<TransformComponent, SphereColliderComponent>();
-    auto planes  = registry.view<PlaneColliderComponent>();
-
-    for (auto sphereEntity : spheres) {
-        auto& transform = spheres.get<TransformComponent>(sphereEntity);
-        auto& collider = spheres.get<SphereColliderComponent>(sphereEntity);
-        glm::vec3 sphereCenter = transform.position + collider.localSphere.center;
-        float sphereRadius = collider.localSphere.radius;
-
-        collider.planeCollissionTriggered = false;
+    if (!playerLogic) return;
+    const entt::entity player = playerLogic->getEntity();
 
-        for (auto planeEntity : planes) {
-            const auto& plane = planes.get<PlaneColliderComponent>(planeEntity);
+    for (const auto& event : contactCache.Events()) {
+        if (event.phase != ContactPhase::Begin) continue;
+        if (event.a != player && event.b != player) continue;
+        const entt::entity other = (event.a == player) ? event.b : event.a;
 
-            float dist = glm::dot(plane.normal, sphereCenter - plane.position);
+        playerLogic->OnCollision({ player, other });
 
-            if (std::abs(dist) <= sphereRadius) {
-                collider.planeCollissionTriggered = true;
-            }
+        if (auto* food = registry.try_get<FoodComponent>(other); food && !food->isCollected) {
+            playerLogic->CollectFood();
+            food->isCollected = true;
+            myQuest = QuestState::FeedHorse;
         }
     }
 }
 
-inline bool TestAABBAABB(const AABBBoundingBox& a, const AABBBoundingBox& b)
-{
-    float centerDiff = std::abs(a.center[0] - b.center[0]);
-    float compoundedWidth = a.halfWidths[0] + b.halfWidths[0];
-    if (centerDiff > compoundedWidth)
-        return false;
-
-    centerDiff = std::abs(a.center[1] - b.center[1]);
-    compoundedWidth = a.halfWidths[1] + b.halfWidths[1];
-    if (centerDiff > compoundedWidth)
-        return false;
-
-    centerDiff = std::abs(a.center[2] - b.center[2]);
-    compoundedWidth = a.halfWidths[2] + b.halfWidths[2];
-    if (centerDiff > compoundedWidth)
-        return false;
-
-    return true;
-}
+// Bodies slower than this, that also moved less than this per second, are at rest
+constexpr float SleepSpeedThreshold = 0.05f;
+// Frames a whole island must rest before it falls asleep
+constexpr uint32_t SleepFrames = 60;
 
-inline void AABBCollisionSystem(entt::registry& registry) {
-    auto view = registry.view<TransformComponent, AABBColliderComponent>();
+// Puts resting bodies to sleep and wakes them again. Bodies that touched last frame form an island, which
+// sleeps only when all of its bodies have rested for SleepFrames, and wakes as a whole when any of its bodies
+// moves: an awake body that touches it, a velocity set by a controller, or a TransformComponent modified
+// from outside. Run after the controllers and before MovementSystem.
+inline void SleepSystem(entt::registry& registry, const ContactPairCache& contacts, float deltaTime)
+{
+    auto bodies = registry.view<TransformComponent, LinearVelocityComponent, SleepComponent>();
 
-    // Reset all triggers first
-    for (auto entity : view) {
-        registry.get<AABBColliderComponent>(entity).collissionTriggered = false;
+    std::vector<entt::entity> entities;
+    for (auto entity : bodies) {
+        bodies.get<SleepComponent>(entity).index = static_cast<uint32_t>(entities.size());
+        entities.push_back(entity);
     }
-
-    for (auto entityA : view) {
-        auto& aTransform = registry.get<TransformComponent>(entityA);
-        auto& aCollider = registry.get<AABBColliderComponent>(entityA);
-
-        for (auto entityB : view) {
-            if (entityA == entityB) continue;
-
-            auto& bTransform = registry.get<TransformComponent>(entityB);
-            auto& bCollider = registry.get<AABBColliderComponent>(entityB);
-
-            AABBBoundingBox a = aCollider.aabb;
-            AABBBoundingBox b = bCollider.aabb;
-
-            // Optional: apply transform.position to center
-            a.center += aTransform.position;
-            b.center += bTransform.position;
-
-            if (TestAABBAABB(a, b)) {
-                aCollider.collissionTriggered = true;
-                bCollider.collissionTriggered = true;
-            }
+    if (entities.empty()) return;
+
+    // Static colliders and entities without a SleepComponent do not connect islands
+    eeng::DisjointSet islands(entities.size());
+    contacts.ForEachPair([&](entt::entity a, entt::entity b) {
+        if (bodies.contains(a) && bodies.contains(b))
+            islands.unite(bodies.get<SleepComponent>(a).index, bodies.get<SleepComponent>(b).index);
+    });
+
+    const float speedSq = SleepSpeedThreshold * SleepSpeedThreshold;
+    const float stepSq = speedSq * deltaTime * deltaTime;
+    std::vector<uint8_t> islandAwake(entities.size(), 0);
+    for (size_t i = 0; i < entities.size(); ++i) {
+        auto& tfm = bodies.get<TransformComponent>(entities[i]);
+        auto& vel = bodies.get<LinearVelocityComponent>(entities[i]);
+        auto& sleep = bodies.get<SleepComponent>(entities[i]);
+        bool restless;
+
+        if (registry.all_of<SleepingTag>(entities[i])) {
+            restless = tfm.position != sleep.lastPosition || tfm.rotation != sleep.restRotation ||
+                glm::length2(vel.velocity) > speedSq;
         }
-    }
-}
-
-inline bool TestAABBPlane(const AABBBoundingBox& aabb, const glm::vec3& planePoint, const glm::vec3& planeNormal)
-{
-    float r =
-        aabb.halfWidths[0] * std::abs(glm::dot(glm::vec3(1, 0, 0), planeNormal)) +
-        aabb.halfWidths[1] * std::abs(glm::dot(glm::vec3(0, 1, 0), planeNormal)) +
-        aabb.halfWidths[2] * std::abs(glm::dot(glm::vec3(0, 0, 1), planeNormal));
-
-    float s = glm::dot(planeNormal, aabb.center - planePoint);
-
-    return std::abs(s) <= r;
-}
-
-inline void AABBPlaneCollisionSystem(entt::registry& registry) {
-    auto aabbs = registry.view<TransformComponent, AABBColliderComponent>();
-    auto planes = registry.view<PlaneColliderComponent>();
-
-    for (auto entity : aabbs) {
-        auto& tfm = registry.get<TransformComponent>(entity);
-        auto& collider = registry.get<AABBColliderComponent>(entity);
-
-        AABBBoundingBox aabb = collider.aabb;
-        aabb.center += tfm.position;
-
-        for (auto planeEntity : planes) {
-            const auto& plane = registry.get<PlaneColliderComponent>(planeEntity);
-            if (TestAABBPlane(aabb, plane.position, plane.normal)) {
-                collider.collissionTriggered = true;
-            }
+        else {
+            const bool atRest = glm::length2(vel.velocity) <= speedSq && glm::length2(tfm.position - sleep.lastPosition) <= stepSq;
+            sleep.restFrames = atRest ? sleep.restFrames + 1 : 0;
+            sleep.lastPosition = tfm.position;
+            restless = sleep.restFrames < SleepFrames;
         }
+        if (restless) islandAwake[islands.find(i)] = 1;
     }
-}
-
-
-float DistanceBetweenSpheres(Sphere* leftSphere, Sphere* rightSphere) {
-    float centerDistance = glm::distance(leftSphere->center, rightSphere->center);
-    float surfaceDistance = centerDistance - (leftSphere->radius + rightSphere->radius);
-    return std::max(0.0f, surfaceDistance);
-}
-
-void FindMinMaxPoints(const glm::vec3 leftCenter, const glm::vec3 rightCenter, const float leftRadius,
-    const float rightRadius, glm::vec3& minOut, glm::vec3& maxOut) {
-    minOut.x = std::min(leftCenter.x - leftRadius, rightCenter.x - rightRadius);
-    maxOut.x = std::max(leftCenter.x + leftRadius, rightCenter.x + rightRadius);
-
-    minOut.y = std::min(leftCenter.y - leftRadius, rightCenter.y - rightRadius);
-    maxOut.y = std::max(leftCenter.y + leftRadius, rightCenter.y + rightRadius);
-
-    minOut.z = std::min(leftCenter.z - leftRadius, rightCenter.z - rightRadius);
-    maxOut.z = std::max(leftCenter.z + leftRadius, rightCenter.z + rightRadius);
-}
-
-struct SphereNode {
-    Sphere* collisionRepresentation;
-    SphereNode* leftChild;
-    SphereNode* rightChild;
-};
-
-SphereNode* BuildNodeFromSingleSphere(Sphere* sphere) {
-    return new SphereNode{ sphere, nullptr, nullptr };
-}
-
-SphereNode* BuildNodeFromSpheres(Sphere* leftSphere, Sphere* rightSphere) {
-    glm::vec3 minPoint, maxPoint;
-    FindMinMaxPoints(leftSphere->center, rightSphere->center, leftSphere->radius,
-        rightSphere->radius, minPoint, maxPoint);
-
-    glm::vec3 midPoint = minPoint + (maxPoint - minPoint) * 0.5f;
-    float radius = glm::distance(maxPoint, minPoint) * 0.5f;
 
-    return new SphereNode{ new Sphere{ midPoint, radius }, nullptr, nullptr };
-}
-
-
-std::vector<std::pair<SphereNode*, SphereNode*>> FindPairs(std::vector<SphereNode*> openList,
-    float maxDistance) {
-    std::vector<std::pair<SphereNode*, SphereNode*>> allPairs;
-    std::vector<SphereNode*> availableSpheres = openList;
-
-    while (!availableSpheres.empty()) {
-        SphereNode* current = availableSpheres.back();
-        availableSpheres.pop_back();
-
-        float closestDistance = maxDistance;
-        SphereNode* bestMatch = nullptr;
-        int bestIndex = -1;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        const entt::entity entity = entities[i];
+        const bool asleep = registry.all_of<SleepingTag>(entity);
+        auto& sleep = bodies.get<SleepComponent>(entity);
 
-        for (int j = 0; j < availableSpheres.size(); ++j) {
-            float distance = DistanceBetweenSpheres(current->collisionRepresentation,
-                availableSpheres[j]->collisionRepresentation);
-            if (distance < closestDistance) {
-                closestDistance = distance;
-                bestMatch = availableSpheres[j];
-                bestIndex = j;
+        if (islandAwake[islands.find(i)]) {
+            if (asleep) {
+                registry.remove<SleepingTag>(entity);
+                sleep.restFrames = 0;
+                sleep.lastPosition = bodies.get<TransformComponent>(entity).position;
             }
         }
-
-        if (bestMatch) {
-            availableSpheres.erase(availableSpheres.begin() + bestIndex);
+        else if (!asleep) {
+            registry.emplace<SleepingTag>(entity);
+            bodies.get<LinearVelocityComponent>(entity).velocity = glm::vec3(0.0f);
+            sleep.restRotation = bodies.get<TransformComponent>(entity).rotation;
         }
-
-        allPairs.push_back({ current, bestMatch });
     }
-
-    return allPairs;
 }
 
-SphereNode* BuildBVHBottomUp(std::vector<Sphere*> spheres, float maxDistanceBetweenLeaves) {
-    std::vector<SphereNode*> openList;
-    for (Sphere* sphere : spheres) {
-        openList.push_back(BuildNodeFromSingleSphere(sphere));
+// Characters probe for the ground from this far above their feet, so they walk up steps of up to this height
+constexpr float GroundStepHeight = 0.5f;
+// and this far below them. Ground further down makes grounded characters fall.
+constexpr float GroundProbeDepth = 1.0f;
+
+// Finds the ground below each character, in two passes. Heights over heightfields come from one batched
+// lookup of a few memory reads each; only characters outside all heightfields cast a downward ray against
+// the static meshes, in parallel. Where neither is below, the ground plane at y = 0 is used.
+// Grounded characters follow the ground over slopes and steps, and start falling where it drops away;
+// airborne ones land on it in ApplyJumpPhysics.
+inline void GroundingSystem(entt::registry& registry, const StaticCollisionWorld& staticWorld, eeng::ThreadPool& threadPool)
+{
+    auto view = registry.view<TransformComponent, GroundComponent, AnimeComponent>(entt::exclude<SleepingTag>);
+    std::vector<entt::entity> entities(view.begin(), view.end());
+    const size_t count = entities.size();
+
+    std::vector<float> x(count), z(count), heights(count);
+    std::vector<uint8_t> covered(count);
+    for (size_t k = 0; k < count; ++k) {
+        const glm::vec3& position = view.get<TransformComponent>(entities[k]).position;
+        x[k] = position.x;
+        z[k] = position.z;
     }
+    staticWorld.HeightfieldHeights(x.data(), z.data(), count, LayerAll, heights.data(), covered.data());
+
+    threadPool.parallel_for(count, 16, [&](size_t begin, size_t end, size_t) {
+        for (size_t k = begin; k < end; ++k) {
+            auto& tfm = view.get<TransformComponent>(entities[k]);
+            auto& ground = view.get<GroundComponent>(entities[k]);
+            auto& anim = view.get<AnimeComponent>(entities[k]);
 
-    while (openList.size() != 1) {
-        auto pairs = FindPairs(openList, maxDistanceBetweenLeaves);
-        openList.clear();
-
-        for (auto pair : pairs) {
-            if (pair.second) {
-                auto node = BuildNodeFromSpheres(
-                    pair.first->collisionRepresentation, pair.second->collisionRepresentation
-                );
-                node->leftChild = pair.first;
-                node->rightChild = pair.second;
-                openList.push_back(node);
+            if (covered[k]) {
+                ground.onMesh = true;
+                ground.height = heights[k];
             }
             else {
-                auto node = BuildNodeFromSingleSphere(pair.first->collisionRepresentation);
-                node->leftChild = pair.first;
-                openList.push_back(node);
+                const glm::vec3 origin = tfm.position + glm::vec3(0.0f, GroundStepHeight, 0.0f);
+                StaticCollisionWorld::SurfaceHit hit;
+                ground.onMesh = staticWorld.RaycastSurfaces(origin, glm::vec3(0.0f, -1.0f, 0.0f), GroundStepHeight + GroundProbeDepth, LayerAll, hit);
+                ground.height = ground.onMesh ? origin.y - hit.distance : 0.0f;
             }
-        }
-
-        maxDistanceBetweenLeaves = std::numeric_limits<float>::max();
-    }
 
-    return openList[0];
+            if (!anim.isGrounded) continue;
+            if (tfm.position.y - ground.height <= GroundProbeDepth)
+                tfm.position.y = ground.height;
+            else
+                anim.isGrounded = false;
+        }
+    });
 }
 
-std::vector<Sphere*> FindPossibleCollisions(SphereNode* treeRoot, Sphere* sphere) {
-    std::vector<Sphere*> possibleCollisions;
-
-    if (!sphere || !treeRoot)
-        return possibleCollisions;
-
-    if (!SphereSphereIntersection(treeRoot->collisionRepresentation->center, treeRoot->collisionRepresentation->radius, sphere->center, sphere->radius))
-        return possibleCollisions;
+// Static colliders and mesh triangles between this height above the ground and the agent height block a navigation
+// cell. Lower ones are steps that characters walk up, see GroundStepHeight.
+constexpr float NavigationAgentHeight = 2.0f;
+
+// Builds the navigation grid of a level from its static geometry, in parallel. Call once the static world has been
+// built, e.g. after a first RefreshColliderSoA when the level is loaded. The grid covers the level's meshes and
+// heightfields. Ground heights come from the heightfields, from downward rays against the meshes elsewhere, and from
+// the ground plane at y = 0 where neither is below. A cell is walkable where no static collider or mesh triangle
+// is within agentRadius of its center, between GroundStepHeight and NavigationAgentHeight above the ground, which
+// also rules out slopes too steep to step up.
+inline std::shared_ptr<eeng::NavigationGrid> BuildNavigationGrid(const CollisionWorld& world, eeng::ThreadPool& threadPool,
+    float cellSize, float agentRadius = 0.5f)
+{
+    const auto& staticWorld = world.staticWorld;
+    const auto& soa = world.soa;
 
-    if (!treeRoot->leftChild && !treeRoot->rightChild) {
-        possibleCollisions.push_back(treeRoot->collisionRepresentation);
-        return possibleCollisions;
+    glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+    for (const auto& mesh : staticWorld.Meshes()) {
+        min = glm::min(min, glm::vec3(mesh.min[0], mesh.min[1], mesh.min[2]));
+        max = glm::max(max, glm::vec3(mesh.max[0], mesh.max[1], mesh.max[2]));
+    }
+    for (const auto& field : staticWorld.Heightfields()) {
+        float fieldMin[3], fieldMax[3];
+        field.heightfield->bounds(fieldMin, fieldMax);
+        min = glm::min(min, glm::vec3(fieldMin[0], fieldMin[1], fieldMin[2]));
+        max = glm::max(max, glm::vec3(fieldMax[0], fieldMax[1], fieldMax[2]));
+    }
+    // Without level geometry, a flat 100 x 100 area around the origin
+    if (min.x > max.x) {
+        min = glm::vec3(-50.0f, 0.0f, -50.0f);
+        max = glm::vec3(50.0f, 0.0f, 50.0f);
     }
 
-    auto collisions = FindPossibleCollisions(treeRoot->leftChild, sphere);
-    possibleCollisions.insert(possibleCollisions.end(), collisions.begin(), collisions.end());
-
-    collisions = FindPossibleCollisions(treeRoot->rightChild, sphere);
-    possibleCollisions.insert(possibleCollisions.end(), collisions.begin(), collisions.end());
+    auto grid = std::make_shared<eeng::NavigationGrid>();
+    const size_t columns = std::max<size_t>(1, static_cast<size_t>(std::ceil((max.x - min.x) / cellSize)));
+    const size_t rows = std::max<size_t>(1, static_cast<size_t>(std::ceil((max.z - min.z) / cellSize)));
+    grid->build(columns, rows, min.x, min.z, cellSize);
+
+    const size_t count = grid->cell_count();
+    std::vector<float> x(count), z(count), heights(count);
+    std::vector<uint8_t> covered(count);
+    for (uint32_t c = 0; c < count; ++c) {
+        float p[3];
+        grid->center(c, p);
+        x[c] = p[0];
+        z[c] = p[2];
+    }
+    staticWorld.HeightfieldHeights(x.data(), z.data(), count, LayerAll, heights.data(), covered.data());
+
+    const float top = max.y + 1.0f;
+    threadPool.parallel_for(count, 256, [&](size_t begin, size_t end, size_t) {
+        for (size_t c = begin; c < end; ++c) {
+            if (!covered[c]) {
+                StaticCollisionWorld::SurfaceHit hit;
+                heights[c] = staticWorld.RaycastSurfaces(glm::vec3(x[c], top, z[c]), glm::vec3(0.0f, -1.0f, 0.0f), top - min.y + 1.0f, LayerAll, hit)
+                    ? top - hit.distance : 0.0f;
+            }
 
-    return possibleCollisions;
+            const float bmin[3]{ x[c] - agentRadius, heights[c] + GroundStepHeight, z[c] - agentRadius };
+            const float bmax[3]{ x[c] + agentRadius, heights[c] + NavigationAgentHeight, z[c] + agentRadius };
+            bool blocked = false;
+            staticWorld.QueryColliders(bmin, bmax, [&](uint32_t i) {
+                if (!(soa.flags[i] & eeng::ColliderIsTrigger)) blocked = true;
+            });
+            if (!blocked) {
+                staticWorld.QueryMeshes(bmin, bmax, [&](const StaticCollisionWorld::StaticMesh& mesh) {
+                    if (!blocked && mesh.bvh->overlaps_aabb(bmin, bmax)) blocked = true;
+                });
+            }
+            grid->set_walkable(static_cast<uint32_t>(c), !blocked);
+            grid->set_height(static_cast<uint32_t>(c), heights[c]);
+        }
+    });
+    return grid;
 }
 
-
-//inline void BVHCollisionSystem(
-//    entt::registry& registry,
-//    std::unordered_map<entt::entity, int>& collisionCandidateCounts,
-//    std::shared_ptr<PlayerLogic> playerLogic) {
-//    std::vector<std::unique_ptr<Sphere>> tempSpheres; 
-//    allSpheres.clear();
-//    collisionCandidateCounts.clear();
-//
-//    auto aabbView = registry.view<AABBColliderComponent>();
-//    for (auto entity : aabbView) {
-//        registry.get<AABBColliderComponent>(entity).collissionTriggered = false;
-//    }
-//
-//    auto view = registry.view<TransformComponent, SphereColliderComponent>();
-//    for (auto entity : view) {
-//        auto& tfm = registry.get<TransformComponent>(entity);
-//        auto& col = registry.get<SphereColliderComponent>(entity);
-//
-//        glm::vec3 worldCenter = tfm.position + col.localSphere.center;
-//        float worldRadius = col.localSphere.radius;
-//
-//        // Create world-space sphere, store it in temp vector for cleanup
-//        auto sphere = std::make_unique<Sphere>(Sphere{ worldCenter, worldRadius, entity });
-//        allSpheres.push_back(sphere.get());
-//        tempSpheres.push_back(std::move(sphere));
-//
-//        col.sphereCollissionTriggered = false;
-//    }
-//
-//    if (allSpheres.empty()) {
-//        return;
-//    }
-//
-//    //std::cout << "[BVH] Total spheres collected: " << allSpheres.size() << std::endl;
-//
-//    // Build BVH
-//    SphereNode* root = BuildBVHBottomUp(allSpheres, 3.0f);
-//
-//    // Query each sphere against the BVH
-//    for (Sphere* s : allSpheres) {
-//        std::vector<Sphere*> candidates = FindPossibleCollisions(root, s);
-//        collisionCandidateCounts[s->owner] = static_cast<int>(candidates.size()) - 1;
-//
-//        for (Sphere* other : candidates) {
-//            if (s == other) continue;
-//
-//            // === Broad Phase: Sphere-Sphere test ===
-//            if (!SphereSphereIntersection(s->center, s->radius, other->center, other->radius))
-//                continue;
-//
-//            // === Narrow Phase: AABB-AABB test ===
-//            if (registry.any_of<AABBColliderComponent>(s->owner) &&
-//                registry.any_of<AABBColliderComponent>(other->owner)) {
-//                auto& tfmA = registry.get<TransformComponent>(s->owner);
-//                auto& tfmB = registry.get<TransformComponent>(other->owner);
-//
-//                AABBBoundingBox aabbA = registry.get<AABBColliderComponent>(s->owner).aabb;
-//                AABBBoundingBox aabbB = registry.get<AABBColliderComponent>(other->owner).aabb;
-//
-//                aabbA.center += tfmA.position;
-//                aabbB.center += tfmB.position;
-//
-//                if (TestAABBAABB(aabbA, aabbB)) {
-//
-//
-//                    auto& colA = registry.get<SphereColliderComponent>(s->owner);
-//                    auto& colB = registry.get<SphereColliderComponent>(other->owner);
-//
-//                    // === Skip if both are triggers ===
-//                    if (colA.isTrigger && colB.isTrigger)
-//                        continue;
-//
-//                    // === Mark both as triggered (for visualization)
-//                    registry.get<AABBColliderComponent>(s->owner).collissionTriggered = true;
-//                    registry.get<AABBColliderComponent>(other->owner).collissionTriggered = true;
-//                    colA.sphereCollissionTriggered = true;
-//                    colB.sphereCollissionTriggered = true;
-//
-//                    // === Observer notification (only from the trigger) ===
-//                    if (colA.isTrigger && !colB.isTrigger) {
-//                        if (auto logic = registry.try_get<PlayerLogic>(s->owner)) {
-//                            logic->OnCollision({ s->owner, other->owner });
-//                        }
-//                    }
-//                    else if (colB.isTrigger && !colA.isTrigger) {
-//                        if (auto logic = registry.try_get<PlayerLogic>(other->owner)) {
-//                            logic->OnCollision({ other->owner, s->owner });
-//                        }
-//                    }
-//
-//                    if (!colA.isTrigger && !colB.isTrigger) {
-//                        glm::vec3 posA = tfmA.position + colA.localSphere.center;
-//                        glm::vec3 posB = tfmB.position + colB.localSphere.center;
-//                        glm::vec3 delta = posB - posA;
-//                        delta.y = 0.0f;
-//
-//                        float dist = glm::length(delta);
-//                        float rA = colA.localSphere.radius;
-//                        float rB = colB.localSphere.radius;
-//                        float minDist = rA + rB;
-//
-//                        if (dist > 0.0001f && dist < minDist) {
-//                            glm::vec3 normal = delta / dist;
-//                            float penetration = minDist - dist;
-//                            glm::vec3 correction = normal * (penetration * 0.5f);
-//
-//                            tfmA.position -= correction;
-//                            tfmB.position += correction;
-//                        }
-//
-//                    }
-//
-//
-//                }
-//
-//
-//            }
-//        }
-//    }
-//}
-
-
-inline void BVHCollisionSystem(
-    entt::registry& registry,
-    std::unordered_map<entt::entity, int>& collisionCandidateCounts,
-    std::shared_ptr<PlayerLogic> playerLogic,
-    entt::entity horseEntity,
-    QuestState& myQuest)
+// Sends navigation agents with a new goal to the pathfinding service, and hands the service its budget for the
+// frame. Paths that arrive replace the agent's waypoints, to be walked once; results for requests that a newer
+// goal has replaced are dropped. Never waits for a search.
+inline void PathfindingSystem(entt::registry& registry, eeng::PathfindingService& pathfinding, std::vector<eeng::PathfindingService::Result>& results)
 {
-    std::vector<std::unique_ptr<Sphere>> tempSpheres;
-    allSpheres.clear();
-    collisionCandidateCounts.clear();
-
-    for (auto entity : registry.view<AABBColliderComponent>()) {
-        registry.get<AABBColliderComponent>(entity).collissionTriggered = false;
-    }
-
-    auto view = registry.view<TransformComponent, SphereColliderComponent>();
+    auto view = registry.view<TransformComponent, NavigationAgentComponent, NPCWaypointComponent>();
     for (auto entity : view) {
-        auto& tfm = registry.get<TransformComponent>(entity);
-        auto& col = registry.get<SphereColliderComponent>(entity);
-
-        glm::vec3 worldCenter = tfm.position + col.localSphere.center;
-        float worldRadius = col.localSphere.radius;
-
-        auto sphere = std::make_unique<Sphere>(Sphere{ worldCenter, worldRadius, entity });
-        allSpheres.push_back(sphere.get());
-        tempSpheres.push_back(std::move(sphere));
-
-        col.sphereCollissionTriggered = false;
+        auto& agent = view.get<NavigationAgentComponent>(entity);
+        if (!agent.hasNewGoal) continue;
+        const glm::vec3& position = view.get<TransformComponent>(entity).position;
+        const float start[3]{ position.x, position.y, position.z }, goal[3]{ agent.goal.x, agent.goal.y, agent.goal.z };
+        agent.ticket = pathfinding.request(entt::to_integral(entity), start, goal);
+        agent.hasNewGoal = false;
     }
 
-    if (allSpheres.empty()) return;
-
-    SphereNode* root = BuildBVHBottomUp(allSpheres, 3.0f);
-
-    for (Sphere* s : allSpheres) {
-        std::vector<Sphere*> candidates = FindPossibleCollisions(root, s);
-        collisionCandidateCounts[s->owner] = static_cast<int>(candidates.size()) - 1;
-
-        for (Sphere* other : candidates) {
-            if (s == other) continue;
-            if (!SphereSphereIntersection(s->center, s->radius, other->center, other->radius)) continue;
-
-            if (!registry.all_of<AABBColliderComponent>(s->owner) ||
-                !registry.all_of<AABBColliderComponent>(other->owner))
-                continue;
+    pathfinding.update(results);
+    for (const auto& result : results) {
+        const entt::entity entity = static_cast<entt::entity>(result.owner);
+        if (!registry.valid(entity) || !view.contains(entity)) continue;
+        auto& agent = view.get<NavigationAgentComponent>(entity);
+        if (agent.ticket != result.ticket) continue;
+        agent.ticket = 0;
 
-            auto& tfmA = registry.get<TransformComponent>(s->owner);
-            auto& tfmB = registry.get<TransformComponent>(other->owner);
-            auto& colA = registry.get<SphereColliderComponent>(s->owner);
-            auto& colB = registry.get<SphereColliderComponent>(other->owner);
-
-            auto aabbA = registry.get<AABBColliderComponent>(s->owner).aabb;
-            auto aabbB = registry.get<AABBColliderComponent>(other->owner).aabb;
-
-            aabbA.center += tfmA.position;
-            aabbB.center += tfmB.position;
-
-            if (TestAABBAABB(aabbA, aabbB)) {
-
-                registry.get<AABBColliderComponent>(s->owner).collissionTriggered = true;
-                registry.get<AABBColliderComponent>(other->owner).collissionTriggered = true;
-                colA.sphereCollissionTriggered = true;
-                colB.sphereCollissionTriggered = true;
-
-                if (registry.any_of<FoodComponent>(s->owner) && playerLogic && playerLogic->getEntity() == other->owner) {
-                    auto& food = registry.get<FoodComponent>(s->owner);
-                    if (!food.isCollected) {
-                        playerLogic->CollectFood();
-                        food.isCollected = true;
-                        myQuest = QuestState::FeedHorse;
-                    }
-                }
-                else if (registry.any_of<FoodComponent>(other->owner) && playerLogic && playerLogic->getEntity() == s->owner) {
-                    auto& food = registry.get<FoodComponent>(other->owner);
-                    if (!food.isCollected) {
-                        playerLogic->CollectFood();
-                        food.isCollected = true;
-                        myQuest = QuestState::FeedHorse;
-                    }
-                }
-
-                //// Notify only from the trigger
-                //if (colA.isTrigger && !colB.isTrigger && playerLogic->getEntity() == s->owner) {
-                //    std::cout << "Trigger A fired PlayerLogic\n";
-                //    playerLogic->OnCollision({ s->owner, other->owner });
-                //}
-                //else if (colB.isTrigger && !colA.isTrigger && playerLogic->getEntity() == other->owner) {
-                //    std::cout << "Trigger B fired PlayerLogic\n";
-                //    playerLogic->OnCollision({ other->owner, s->owner });
-                //}
-
-                // Only resolve physics if both are not triggers
-                if (!colA.isTrigger && !colB.isTrigger) {
-                    std::cout << "Resolving collision physically\n";
-                    glm::vec3 posA = tfmA.position + colA.localSphere.center;
-                    glm::vec3 posB = tfmB.position + colB.localSphere.center;
-                    glm::vec3 delta = posB - posA;
-                    delta.y = 0.0f;
-
-                    float dist = glm::length(delta);
-                    float minDist = colA.localSphere.radius + colB.localSphere.radius;
-
-                    if (dist > 0.0001f && dist < minDist) {
-                        glm::vec3 normal = delta / dist;
-                        glm::vec3 correction = normal * (minDist - dist) * 0.5f;
-
-                        tfmA.position -= correction;
-                        tfmB.position += correction;
-                    }
-                }
-                else {
-                    std::cout << "No physical resolution due to trigger involvement\n";
-                }
-            }
-        }
+        auto& npc = view.get<NPCWaypointComponent>(entity);
+        npc.waypoints.clear();
+        for (size_t i = 0; i < result.path.size(); i += 3)
+            npc.waypoints.emplace_back(result.path[i], result.path[i + 1], result.path[i + 2]);
+        npc.currentWaypointIndex = 0;
+        npc.loop = false;
     }
 }
-
-
-
-
-
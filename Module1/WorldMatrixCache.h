@@ -0,0 +1,27 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "TransformHierarchy.h"
+
+// Scratch buffers of WorldMatrixSystem. Changed transforms are gathered here and their matrices built in one batch.
+// Kept between frames so that the system allocates nothing once the scene has settled.
+struct WorldMatrixCache {
+    std::vector<entt::entity> entities;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> matrices;
+
+    // Entities attached to a parent, and their parents. The TransformComponent of an entity in the hierarchy is
+    // relative to its parent, and its WorldMatrixComponent is rebuilt whenever its own or an ancestor's transform changes.
+    eeng::TransformHierarchy<entt::entity, glm::mat4> hierarchy;
+
+    struct Stats {
+        size_t entities = 0;    // Entities with a WorldMatrixComponent
+        size_t rebuilt = 0;     // Matrices rebuilt by the last run
+        size_t propagated = 0;  // Of those, matrices of entities in the hierarchy
+    } stats;
+};
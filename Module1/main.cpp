@@ -1,22 +1,54 @@
 #include "Engine.hpp"
 #include "Game.hpp"
 #include <memory>
+#include <string>
+#include <cstdlib>
 
+// Usage: Module1 [--headless [--steps N] [--realtime]] [--stress NPCS COLLIDERS FOOD [--area SIZE]]
+// Headless runs the game's updates without a window or GPU, for N steps (default: until stopped),
+// as fast as possible unless --realtime is given.
+// Stress adds a procedural scene of that many NPCs, static colliders and food over a SIZE x SIZE m area
+// (default 200), and logs per-system timings and memory at exit, e.g. --headless --steps 600 --stress 1000 200 500.
 int main(int argc, char* argv[])
 {
+    bool headless = false, realtime = false;
+    uint64_t steps = 0;
+    StressSceneSettings stress;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--headless") headless = true;
+        else if (arg == "--realtime") realtime = true;
+        else if (arg == "--steps" && i + 1 < argc) steps = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--stress" && i + 3 < argc)
+        {
+            stress.npcs = std::strtoull(argv[++i], nullptr, 10);
+            stress.staticColliders = std::strtoull(argv[++i], nullptr, 10);
+            stress.food = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--area" && i + 1 < argc) stress.areaSize = std::strtof(argv[++i], nullptr);
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return -1;
+        }
+    }
+
     std::cout << "Starting eduEngine..." << std::endl;
 
     eeng::Engine engine;
 
-    if (!engine.init("eduEngine", 1600, 900))
+    const bool initialized = headless ? engine.init_headless(steps, realtime) : engine.init("eduEngine", 1600, 900);
+    if (!initialized)
     {
         std::cerr << "Engine failed to initialize." << std::endl;
         return -1;
     }
 
     auto game = std::make_unique<Game>();
+    game->stressScene = stress;
     engine.run(std::move(game));
 
     std::cout << "Exiting eduEngine." << std::endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,420 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+// Benchmark for the collision stage and alternative broadphases on synthetic scenes.
+// Populates an entt::registry with sphere, AABB and compound colliders in uniform, clustered
+// and moving distributions, and times per frame:
+//   collision-stage   the full CollisionSystem, as run by the game
+//   aabb-tree         the game's broadphase: an AABBTree rebuilt over the dynamic colliders each frame
+//                     (BuildDynamicTree), queried by each awake collider (CollectCandidatePairs)
+//   sweep-and-prune   colliders sorted on their minimum x and swept
+//   brute-force       all pairs
+//   raycast           RayCount segments through the scene, one SceneQuery::Raycast each
+//   ray-packet        the same segments in one SceneQuery::RaycastBatch, on the calling thread
+//   ray-packet-mt     the same, spread over the thread pool
+// Broadphases are followed by the same narrowphase, untimed, so that pairs_found should agree.
+// For the ray cases, pairs_tested and pairs_found are the rays cast and the rays that hit.
+// Runs headless, prints a table and writes the results as JSON.
+//
+// Usage: collision_scene_bench [--json file] [--sizes 100,1000,...] [--frames n] [--max-quadratic n]
+
+#include "CollisionSystems.h"
+#include "SceneQuery.h"
+#include "AABBTree.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Allocation counters, for bytes allocated per frame
+namespace
+{
+    std::atomic<size_t> g_allocated_bytes{ 0 };
+    std::atomic<size_t> g_allocations{ 0 };
+}
+
+void* operator new(size_t size)
+{
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+    enum class Distribution { Uniform, Clustered, Moving };
+
+    const char* to_string(Distribution d)
+    {
+        switch (d)
+        {
+        case Distribution::Uniform: return "uniform";
+        case Distribution::Clustered: return "clustered";
+        case Distribution::Moving: return "moving";
+        }
+        return "";
+    }
+
+    struct Scene
+    {
+        entt::registry registry;
+        std::vector<entt::entity> moving;
+        std::vector<glm::vec3> velocities;
+        float extent = 0.0f;
+    };
+
+    /// Colliders spread over the xz-plane at about one per 4 square units, a tenth of them static
+    void populate(Scene& scene, Distribution distribution, size_t n, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        scene.extent = std::sqrt(float(n)) * 1.0f;
+        std::uniform_real_distribution<float> coord(-scene.extent, scene.extent), height(0.0f, 2.0f);
+        std::uniform_real_distribution<float> size(0.3f, 0.8f), unit(0.0f, 1.0f);
+
+        std::vector<glm::vec3> clusters(std::max<size_t>(1, n / 100));
+        for (auto& c : clusters) c = { coord(rng), 0.0f, coord(rng) };
+        std::normal_distribution<float> spread(0.0f, 3.0f);
+        std::uniform_int_distribution<size_t> pick(0, clusters.size() - 1);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            glm::vec3 p{ coord(rng), height(rng), coord(rng) };
+            if (distribution == Distribution::Clustered)
+                p = clusters[pick(rng)] + glm::vec3(spread(rng), height(rng), spread(rng));
+
+            const entt::entity entity = scene.registry.create();
+            scene.registry.emplace<TransformComponent>(entity, p);
+            const float r = size(rng);
+            switch (i % 3)
+            {
+            case 0:
+                scene.registry.emplace<SphereColliderComponent>(entity, glm::vec3(0.0f), r);
+                scene.registry.emplace<AABBColliderComponent>(entity, glm::vec3(0.0f), glm::vec3(r));
+                break;
+            case 1:
+                scene.registry.emplace<SphereColliderComponent>(entity, glm::vec3(0.0f), r);
+                break;
+            default:
+                scene.registry.emplace<AABBColliderComponent>(entity, glm::vec3(0.0f), glm::vec3(r, r * 0.5f, r));
+                break;
+            }
+
+            if (unit(rng) < 0.1f)
+            {
+                scene.registry.emplace<StaticColliderTag>(entity);
+            }
+            else if (distribution == Distribution::Moving)
+            {
+                const float angle = unit(rng) * 6.2831853f, speed = 1.0f + 2.0f * unit(rng);
+                scene.moving.push_back(entity);
+                scene.velocities.push_back({ std::cos(angle) * speed, 0.0f, std::sin(angle) * speed });
+            }
+        }
+    }
+
+    /// Moves the moving colliders one 60 Hz step, bouncing off the scene bounds
+    void step(Scene& scene)
+    {
+        const float dt = 1.0f / 60.0f;
+        for (size_t k = 0; k < scene.moving.size(); k++)
+        {
+            auto& p = scene.registry.get<TransformComponent>(scene.moving[k]).position;
+            auto& v = scene.velocities[k];
+            p += v * dt;
+            for (int a : { 0, 2 })
+                if (std::abs(p[a]) > scene.extent) v[a] = -v[a];
+        }
+    }
+
+    using Pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    void sort_unique(Pairs& pairs)
+    {
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    }
+
+    bool bounds_overlap(const float amin[3], const float amax[3], const float bmin[3], const float bmax[3])
+    {
+        return amin[0] <= bmax[0] && bmin[0] <= amax[0] && amin[1] <= bmax[1] &&
+            bmin[1] <= amax[1] && amin[2] <= bmax[2] && bmin[2] <= amax[2];
+    }
+
+    /// Colliders sorted on their minimum x, each one paired with the later ones that start before it ends
+    void sweep_and_prune_pairs(const eeng::ColliderSoA& soa, const StaticCollisionWorld& staticWorld, Pairs& pairs)
+    {
+        pairs.clear();
+        struct Entry { float min[3], max[3]; uint32_t index; };
+        std::vector<Entry> entries(soa.count);
+        for (uint32_t i = 0; i < soa.count; i++)
+        {
+            soa.bounds(i, entries[i].min, entries[i].max);
+            entries[i].index = i;
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.min[0] < b.min[0]; });
+
+        const size_t staticCount = staticWorld.StaticCount();
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const Entry& a = entries[i];
+            for (size_t j = i + 1; j < entries.size() && entries[j].min[0] <= a.max[0]; j++)
+            {
+                const Entry& b = entries[j];
+                if (a.index < staticCount && b.index < staticCount) continue;
+                if (!bounds_overlap(a.min, a.max, b.min, b.max) || !soa.layers_interact(a.index, b.index)) continue;
+                pairs.emplace_back(std::min(a.index, b.index), std::max(a.index, b.index));
+            }
+        }
+        sort_unique(pairs);
+    }
+
+    void brute_force_pairs(const eeng::ColliderSoA& soa, const StaticCollisionWorld& staticWorld, Pairs& pairs)
+    {
+        pairs.clear();
+        const size_t staticCount = staticWorld.StaticCount();
+        for (uint32_t b = uint32_t(staticCount); b < soa.count; b++)
+        {
+            float bmin[3], bmax[3];
+            soa.bounds(b, bmin, bmax);
+            for (uint32_t a = 0; a < b; a++)
+            {
+                float amin[3], amax[3];
+                soa.bounds(a, amin, amax);
+                if (bounds_overlap(amin, amax, bmin, bmax) && soa.layers_interact(a, b)) pairs.emplace_back(a, b);
+            }
+        }
+        sort_unique(pairs);
+    }
+
+    struct Result
+    {
+        std::string distribution, system;
+        size_t colliders = 0;
+        bool skipped = false;
+        int frames = 0;
+        double ms_mean = 0.0, ms_min = 0.0;
+        double pairs_tested = 0.0, pairs_found = 0.0;
+        double bytes_per_frame = 0.0, allocations_per_frame = 0.0;
+    };
+
+    struct Options
+    {
+        std::string json_path = "collision_bench.json";
+        std::vector<size_t> sizes{ 100, 1000, 10000, 100000 };
+        int frames = 10;
+        size_t max_quadratic = 10000;   // Largest scene for systems that scale quadratically
+    };
+
+    const size_t RayCount = 256;   // Rays per frame in the ray cases
+
+    /// Times frame(tested, found) over the given number of frames, after one warm-up frame. prepare() runs untimed before each frame.
+    template<class Prepare, class Frame>
+    Result measure(int frames, Prepare&& prepare, Frame&& frame)
+    {
+        Result result;
+        result.frames = frames;
+        result.ms_min = 1e30;
+        size_t tested = 0, found = 0;
+        prepare();
+        frame(tested, found);
+
+        size_t total_tested = 0, total_found = 0, total_bytes = 0, total_allocations = 0;
+        double total_ms = 0.0;
+        for (int f = 0; f < frames; f++)
+        {
+            prepare();
+            const size_t bytes0 = g_allocated_bytes.load(), allocations0 = g_allocations.load();
+            const auto t0 = std::chrono::steady_clock::now();
+            frame(tested, found);
+            const auto t1 = std::chrono::steady_clock::now();
+            total_bytes += g_allocated_bytes.load() - bytes0;
+            total_allocations += g_allocations.load() - allocations0;
+
+            const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            total_ms += ms;
+            result.ms_min = std::min(result.ms_min, ms);
+            total_tested += tested;
+            total_found += found;
+        }
+        result.ms_mean = total_ms / frames;
+        result.pairs_tested = double(total_tested) / frames;
+        result.pairs_found = double(total_found) / frames;
+        result.bytes_per_frame = double(total_bytes) / frames;
+        result.allocations_per_frame = double(total_allocations) / frames;
+        return result;
+    }
+
+    void run_scene(Distribution distribution, size_t n, const Options& options, eeng::ThreadPool& pool, std::vector<Result>& results)
+    {
+        const bool quadratic_ok = n <= options.max_quadratic;
+        auto add = [&](const char* system, Result result) {
+            result.distribution = to_string(distribution);
+            result.system = system;
+            result.colliders = n;
+            if (result.skipped)
+                std::printf("%-10s %8zu  %-16s %10s\n", result.distribution.c_str(), n, system, "skipped");
+            else
+                std::printf("%-10s %8zu  %-16s %10.3f %10.3f %12.0f %10.0f %14.0f\n", result.distribution.c_str(), n, system,
+                    result.ms_mean, result.ms_min, result.pairs_tested, result.pairs_found, result.bytes_per_frame);
+            std::fflush(stdout);
+            results.push_back(result);
+        };
+        Result skipped;
+        skipped.skipped = true;
+
+        // The full stage resolves contacts and so changes its scene, which gets one of its own
+        {
+            Scene scene;
+            populate(scene, distribution, n, 1234);
+            CollisionWorld world;
+            add("collision-stage", measure(options.frames, [&] { step(scene); }, [&](size_t& tested, size_t& found) {
+                CollisionSystem(scene.registry, world, pool);
+                tested = world.stats.candidatePairs;
+                found = world.stats.contacts;
+            }));
+        }
+
+        // Broadphases share one scene, with the SoA refreshed untimed before each frame
+        Scene scene;
+        populate(scene, distribution, n, 1234);
+        eeng::ColliderSoA soa;
+        StaticCollisionWorld staticWorld;
+        Pairs pairs;
+        std::vector<ColliderContact> contacts;
+        auto prepare = [&] {
+            step(scene);
+            RefreshColliderSoA(scene.registry, soa, staticWorld);
+        };
+        auto broadphase = [&](const char* system, bool enabled, auto&& collect) {
+            if (!enabled) return add(system, skipped);
+            add(system, measure(options.frames, prepare, [&](size_t& tested, size_t& found) {
+                collect();
+                tested = pairs.size();
+                // Excluded from the frame time by measuring the broadphase only
+                const size_t bytes = g_allocated_bytes.load(), allocations = g_allocations.load();
+                contacts.clear();
+                NarrowphaseContacts(soa, pairs, pool, contacts);
+                g_allocated_bytes = bytes;
+                g_allocations = allocations;
+                found = contacts.size();
+            }));
+        };
+
+        std::unordered_map<entt::entity, int> candidateCounts;
+        DynamicColliderTree dynamicTree;
+        broadphase("aabb-tree", true, [&] {
+            BuildDynamicTree(soa, staticWorld.StaticCount(), dynamicTree);
+            CollectCandidatePairs(soa, staticWorld, dynamicTree, candidateCounts, pairs);
+        });
+        broadphase("sweep-and-prune", true, [&] { sweep_and_prune_pairs(soa, staticWorld, pairs); });
+        broadphase("brute-force", quadratic_ok, [&] { brute_force_pairs(soa, staticWorld, pairs); });
+
+        // Segments between random points of the scene at eye height, as for NPC line of sight
+        std::mt19937 rng(4321);
+        std::uniform_real_distribution<float> coord(-scene.extent, scene.extent);
+        std::vector<SceneRay> rays(RayCount);
+        for (auto& ray : rays)
+        {
+            const glm::vec3 from(coord(rng), 1.8f, coord(rng)), to(coord(rng), 1.8f, coord(rng));
+            ray = { from, glm::normalize(to - from), glm::distance(from, to) };
+        }
+        std::vector<SceneHit> hits(RayCount);
+        std::vector<uint8_t> hitFound(RayCount);
+        auto raycasts = [&](const char* system, auto&& cast) {
+            add(system, measure(options.frames, prepare, [&](size_t& tested, size_t& found) {
+                cast(SceneQuery(soa, staticWorld));
+                tested = RayCount;
+                found = std::count(hitFound.begin(), hitFound.end(), uint8_t(1));
+            }));
+        };
+
+        raycasts("raycast", [&](const SceneQuery& query) {
+            for (size_t i = 0; i < RayCount; i++) hitFound[i] = query.Raycast(rays[i], hits[i]);
+        });
+        raycasts("ray-packet", [&](const SceneQuery& query) { query.RaycastBatch(rays.data(), RayCount, hits.data(), hitFound.data()); });
+        raycasts("ray-packet-mt", [&](const SceneQuery& query) { query.RaycastBatch(rays.data(), RayCount, hits.data(), hitFound.data(), &pool); });
+    }
+
+    bool write_json(const std::string& path, const Options& options, size_t threads, const std::vector<Result>& results)
+    {
+        FILE* file = std::fopen(path.c_str(), "w");
+        if (!file) return false;
+        std::fprintf(file, "{\n  \"benchmark\": \"collision_scene\",\n  \"threads\": %zu,\n  \"frames\": %d,\n  \"results\": [\n",
+            threads, options.frames);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+            std::fprintf(file, "    { \"distribution\": \"%s\", \"colliders\": %zu, \"system\": \"%s\", ",
+                r.distribution.c_str(), r.colliders, r.system.c_str());
+            if (r.skipped)
+                std::fprintf(file, "\"skipped\": true }");
+            else
+                std::fprintf(file, "\"skipped\": false, \"ms_per_frame\": %.4f, \"ms_min\": %.4f, \"pairs_tested\": %.1f, "
+                    "\"pairs_found\": %.1f, \"bytes_per_frame\": %.0f, \"allocations_per_frame\": %.1f }",
+                    r.ms_mean, r.ms_min, r.pairs_tested, r.pairs_found, r.bytes_per_frame, r.allocations_per_frame);
+            std::fprintf(file, "%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        std::fclose(file);
+        return true;
+    }
+
+    bool parse_options(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const bool has_value = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--json") && has_value) options.json_path = argv[++i];
+            else if (!std::strcmp(argv[i], "--frames") && has_value) options.frames = std::max(1, std::atoi(argv[++i]));
+            else if (!std::strcmp(argv[i], "--max-quadratic") && has_value) options.max_quadratic = std::strtoull(argv[++i], nullptr, 10);
+            else if (!std::strcmp(argv[i], "--sizes") && has_value)
+            {
+                options.sizes.clear();
+                for (char* s = argv[++i]; *s; )
+                {
+                    char* end;
+                    options.sizes.push_back(std::strtoull(s, &end, 10));
+                    if (end == s) return false;
+                    s = *end == ',' ? end + 1 : end;
+                }
+            }
+            else return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parse_options(argc, argv, options))
+    {
+        std::fprintf(stderr, "Usage: %s [--json file] [--sizes 100,1000,...] [--frames n] [--max-quadratic n]\n", argv[0]);
+        return 1;
+    }
+
+    eeng::ThreadPool pool;
+    std::printf("Threads: %zu, frames: %d\n", pool.thread_count(), options.frames);
+    std::printf("%-10s %8s  %-16s %10s %10s %12s %10s %14s\n",
+        "scene", "N", "system", "ms/frame", "ms min", "tested", "found", "bytes/frame");
+
+    std::vector<Result> results;
+    for (Distribution distribution : { Distribution::Uniform, Distribution::Clustered, Distribution::Moving })
+        for (size_t n : options.sizes)
+            run_scene(distribution, n, options, pool, results);
+
+    if (!write_json(options.json_path, options, pool.thread_count(), results))
+    {
+        std::fprintf(stderr, "Could not write %s\n", options.json_path.c_str());
+        return 1;
+    }
+    std::printf("Wrote %s\n", options.json_path.c_str());
+    return 0;
+}
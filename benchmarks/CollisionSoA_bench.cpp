@@ -0,0 +1,178 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+// Microbenchmark for the SoA collider overlap kernels.
+// Compares the per-pair scalar tests used by the collision systems (array of
+// structs, center + half-widths) against the SoA kernels at 4/8/16 lanes, both
+// for brute-force all-pairs and for broadphase-leaf style gathered candidates.
+
+#include "CollisionSoA.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace eeng;
+
+    /// Mirrors Sphere + AABBBoundingBox as the collision systems see them
+    struct AoSCollider
+    {
+        float center[3];
+        float radius;
+        float aabb_center[3];
+        float half_widths[3];
+    };
+
+    inline bool sphere_sphere(const AoSCollider& a, const AoSCollider& b)
+    {
+        const float dx = b.center[0] - a.center[0], dy = b.center[1] - a.center[1], dz = b.center[2] - a.center[2];
+        const float rs = a.radius + b.radius;
+        return dx * dx + dy * dy + dz * dz <= rs * rs;
+    }
+
+    inline bool aabb_aabb(const AoSCollider& a, const AoSCollider& b)
+    {
+        for (int i = 0; i < 3; i++)
+            if (std::abs(a.aabb_center[i] - b.aabb_center[i]) > a.half_widths[i] + b.half_widths[i])
+                return false;
+        return true;
+    }
+
+    struct Scene
+    {
+        std::vector<AoSCollider> aos;
+        ColliderSoA soa;
+        std::vector<std::vector<uint32_t>> leaf_candidates;
+    };
+
+    Scene make_scene(size_t n, size_t candidates_per_query)
+    {
+        std::mt19937 rng(1234);
+        const float extent = std::cbrt((float)n) * 2.0f;
+        std::uniform_real_distribution<float> pos(-extent, extent);
+        std::uniform_real_distribution<float> size(0.25f, 1.0f);
+        std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)n - 1);
+
+        Scene scene;
+        scene.soa.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            const float c[3]{ pos(rng), pos(rng), pos(rng) };
+            const float h = size(rng);
+            const float mn[3]{ c[0] - h, c[1] - h, c[2] - h };
+            const float mx[3]{ c[0] + h, c[1] + h, c[2] + h };
+            scene.aos.push_back({ { c[0], c[1], c[2] }, h, { c[0], c[1], c[2] }, { h, h, h } });
+            scene.soa.push((uint32_t)i, ColliderHasSphere | ColliderHasAABB, c, h, mn, mx);
+        }
+        scene.soa.pad();
+
+        scene.leaf_candidates.resize(n);
+        for (auto& candidates : scene.leaf_candidates)
+            for (size_t k = 0; k < candidates_per_query; k++)
+                candidates.push_back(pick(rng));
+        return scene;
+    }
+
+    /// Best-of-N wall time in milliseconds
+    template<class F>
+    double time_ms(int repeats, size_t& result, const F& func)
+    {
+        double best = 1e30;
+        for (int r = 0; r < repeats; r++)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            result = func();
+            const auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+        return best;
+    }
+
+    template<size_t W>
+    size_t soa_all_pairs(const ColliderSoA& soa)
+    {
+        size_t hits = 0;
+        for_each_overlapping_pair<W>(soa,
+            [](const ColliderLanes& c, const ColliderQuery& q) { return overlap_spheres<W>(c, q) & overlap_aabbs<W>(c, q); },
+            [&](size_t, size_t) { hits++; });
+        return hits;
+    }
+
+    size_t aos_all_pairs(const std::vector<AoSCollider>& aos)
+    {
+        size_t hits = 0;
+        for (size_t i = 0; i < aos.size(); i++)
+            for (size_t j = i + 1; j < aos.size(); j++)
+                if (sphere_sphere(aos[i], aos[j]) && aabb_aabb(aos[i], aos[j]))
+                    hits++;
+        return hits;
+    }
+
+    size_t aos_leaves(const Scene& scene)
+    {
+        size_t hits = 0;
+        for (size_t i = 0; i < scene.aos.size(); i++)
+            for (uint32_t j : scene.leaf_candidates[i])
+                if (sphere_sphere(scene.aos[i], scene.aos[j]) && aabb_aabb(scene.aos[i], scene.aos[j]))
+                    hits++;
+        return hits;
+    }
+
+    size_t soa_leaves(const Scene& scene)
+    {
+        size_t hits = 0;
+        ColliderGather batch;
+        for (size_t i = 0; i < scene.soa.count; i++)
+        {
+            const auto q = ColliderQuery::from(scene.soa, i);
+            const auto& candidates = scene.leaf_candidates[i];
+            for (size_t k = 0; k < candidates.size(); k += CollisionMaxBatchWidth)
+            {
+                const size_t n = std::min(CollisionMaxBatchWidth, candidates.size() - k);
+                batch.gather_spheres(scene.soa, candidates.data() + k, n);
+                uint32_t mask = overlap_spheres<16>(batch.lanes(), q);
+                while (mask)
+                {
+                    const int lane = std::countr_zero(mask);
+                    mask &= mask - 1;
+                    hits += overlap_aabbs_scalar(ColliderLanes(scene.soa, candidates[k + lane]), q, 1);
+                }
+            }
+        }
+        return hits;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int repeats = argc > 1 ? std::atoi(argv[1]) : 5;
+    const size_t sizes[] = { 256, 1024, 4096 };
+    const size_t candidates_per_query = 32;
+
+    std::printf("Native collision batch width: %zu\n", CollisionBatchWidth);
+    std::printf("%8s  %-22s %10s %10s %8s\n", "N", "kernel", "ms", "hits", "speedup");
+
+    for (size_t n : sizes)
+    {
+        const Scene scene = make_scene(n, candidates_per_query);
+        size_t hits = 0;
+
+        const double aos_ms = time_ms(repeats, hits, [&] { return aos_all_pairs(scene.aos); });
+        std::printf("%8zu  %-22s %10.3f %10zu %8s\n", n, "all-pairs AoS scalar", aos_ms, hits, "1.00x");
+
+        auto report = [&](const char* name, double ms, double baseline) {
+            std::printf("%8zu  %-22s %10.3f %10zu %7.2fx\n", n, name, ms, hits, baseline / ms);
+            };
+        report("all-pairs SoA 4", time_ms(repeats, hits, [&] { return soa_all_pairs<4>(scene.soa); }), aos_ms);
+        report("all-pairs SoA 8", time_ms(repeats, hits, [&] { return soa_all_pairs<8>(scene.soa); }), aos_ms);
+        report("all-pairs SoA 16", time_ms(repeats, hits, [&] { return soa_all_pairs<16>(scene.soa); }), aos_ms);
+
+        const double leaf_ms = time_ms(repeats, hits, [&] { return aos_leaves(scene); });
+        std::printf("%8zu  %-22s %10.3f %10zu %8s\n", n, "leaves AoS scalar", leaf_ms, hits, "1.00x");
+        report("leaves SoA gather 16", time_ms(repeats, hits, [&] { return soa_leaves(scene); }), leaf_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_AABBTree_h
+#define EENG_AABBTree_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+#include <algorithm>
+
+namespace eeng
+{
+    /// @brief Bounding volume hierarchy over axis-aligned boxes, built in one pass and not updated in place.
+    /** Nodes are stored depth-first in one array: the left child of an internal node
+     * directly follows it and the right child is referenced by index. Built by median split
+     * along the longest axis of the box centroids.
+     *
+     * Used both for static geometry, built once, and for moving colliders, rebuilt from scratch
+     * every step. A rebuild is O(n log n) and reuses the node and item arrays, so rebuilding a
+     * scene of the same size allocates nothing.
+     */
+    class AABBTree
+    {
+    public:
+        /// 32-byte node
+        struct Node
+        {
+            float min[3];
+            uint32_t index;     ///< Internal node: right child. Leaf: first element in items().
+            float max[3];
+            uint32_t count;     ///< Nbr of items in a leaf, 0 for internal nodes
+
+            bool is_leaf() const { return count > 0; }
+        };
+        static_assert(sizeof(Node) == 32);
+
+        static constexpr size_t MaxLeafSize = 4;
+
+        /// @brief Build over n boxes given as separate min/max coordinate arrays (e.g. the arrays of a ColliderSoA)
+        /// @param ids Id reported for each box. Defaults to the box index.
+        void build(
+            const float* min_x, const float* min_y, const float* min_z,
+            const float* max_x, const float* max_y, const float* max_z,
+            size_t n,
+            const uint32_t* ids = nullptr)
+        {
+            m_nodes.clear();
+            m_items.clear();
+            m_boxes.resize(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                Box& b = m_boxes[i];
+                b.min[0] = min_x[i]; b.min[1] = min_y[i]; b.min[2] = min_z[i];
+                b.max[0] = max_x[i]; b.max[1] = max_y[i]; b.max[2] = max_z[i];
+                b.id = ids ? ids[i] : static_cast<uint32_t>(i);
+            }
+            if (n == 0) return;
+
+            m_nodes.reserve(2 * (n / MaxLeafSize + 1));
+            build_recursive(0, n);
+
+            m_items.resize(n);
+            for (size_t i = 0; i < n; i++)
+                m_items[i] = m_boxes[i].id;
+        }
+
+        void clear()
+        {
+            m_nodes.clear();
+            m_items.clear();
+            m_boxes.clear();
+        }
+
+        bool empty() const { return m_nodes.empty(); }
+
+        /// @brief Call func(id) for every box that overlaps [qmin, qmax]
+        template<class F>
+        void query(const float qmin[3], const float qmax[3], F&& func) const
+        {
+            if (m_nodes.empty()) return;
+
+            uint32_t stack[64];
+            size_t top = 0;
+            stack[top++] = 0;
+            while (top)
+            {
+                const uint32_t ni = stack[--top];
+                const Node& node = m_nodes[ni];
+                if (!overlaps(node, qmin, qmax)) continue;
+
+                if (node.is_leaf())
+                {
+                    for (uint32_t k = node.index; k < node.index + node.count; k++)
+                        if (overlaps(m_boxes[k], qmin, qmax))
+                            func(m_items[k]);
+                }
+                else
+                {
+                    stack[top++] = node.index;
+                    stack[top++] = ni + 1;
+                }
+            }
+        }
+
+        /// @brief Visit boxes hit by a ray within [0, t_max], in no particular order
+        /// @param inv_d Inverse ray direction, with zero components replaced by huge signed values
+        /// @param inflate Grows every box by this margin, for sphere-casts
+        /// @param func Function of type float(uint32_t id, float t_max) returning the new t_max,
+        /// which lets closest-hit queries shrink the ray as hits are found
+        template<class F>
+        void raycast(const float o[3], const float inv_d[3], float t_max, float inflate, F&& func) const
+        {
+            if (m_nodes.empty()) return;
+
+            uint32_t stack[64];
+            size_t top = 0;
+            stack[top++] = 0;
+            while (top)
+            {
+                const uint32_t ni = stack[--top];
+                const Node& node = m_nodes[ni];
+                if (!ray_hits(node, o, inv_d, t_max, inflate)) continue;
+
+                if (node.is_leaf())
+                {
+                    for (uint32_t k = node.index; k < node.index + node.count; k++)
+                        if (ray_hits(m_boxes[k], o, inv_d, t_max, inflate))
+                            t_max = func(m_items[k], t_max);
+                }
+                else
+                {
+                    stack[top++] = node.index;
+                    stack[top++] = ni + 1;
+                }
+            }
+        }
+
+        const std::vector<Node>& nodes() const { return m_nodes; }
+        const std::vector<uint32_t>& items() const { return m_items; }
+
+    private:
+        struct Box
+        {
+            float min[3], max[3];
+            uint32_t id;
+            float centroid(int axis) const { return min[axis] + max[axis]; }
+        };
+
+        template<class B>
+        static bool overlaps(const B& node, const float qmin[3], const float qmax[3])
+        {
+            return node.min[0] <= qmax[0] && qmin[0] <= node.max[0] &&
+                node.min[1] <= qmax[1] && qmin[1] <= node.max[1] &&
+                node.min[2] <= qmax[2] && qmin[2] <= node.max[2];
+        }
+
+        template<class B>
+        static bool ray_hits(const B& box, const float o[3], const float inv_d[3], float t_max, float inflate)
+        {
+            float t_near = 0.0f, t_far = t_max;
+            for (int a = 0; a < 3; a++)
+            {
+                const float near_plane = inv_d[a] >= 0.0f ? box.min[a] - inflate : box.max[a] + inflate;
+                const float far_plane = inv_d[a] >= 0.0f ? box.max[a] + inflate : box.min[a] - inflate;
+                t_near = std::max(t_near, (near_plane - o[a]) * inv_d[a]);
+                t_far = std::min(t_far, (far_plane - o[a]) * inv_d[a]);
+            }
+            return t_near <= t_far;
+        }
+
+        uint32_t build_recursive(size_t begin, size_t end)
+        {
+            const uint32_t ni = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+
+            float bmin[3]{ FLT_MAX, FLT_MAX, FLT_MAX }, bmax[3]{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            float cmin[3]{ FLT_MAX, FLT_MAX, FLT_MAX }, cmax[3]{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for (size_t i = begin; i < end; i++)
+            {
+                for (int a = 0; a < 3; a++)
+                {
+                    bmin[a] = std::min(bmin[a], m_boxes[i].min[a]);
+                    bmax[a] = std::max(bmax[a], m_boxes[i].max[a]);
+                    cmin[a] = std::min(cmin[a], m_boxes[i].centroid(a));
+                    cmax[a] = std::max(cmax[a], m_boxes[i].centroid(a));
+                }
+            }
+            {
+                Node& node = m_nodes[ni];
+                std::copy(bmin, bmin + 3, node.min);
+                std::copy(bmax, bmax + 3, node.max);
+            }
+
+            if (end - begin <= MaxLeafSize)
+            {
+                m_nodes[ni].index = static_cast<uint32_t>(begin);
+                m_nodes[ni].count = static_cast<uint32_t>(end - begin);
+                return ni;
+            }
+
+            int axis = 0;
+            for (int a = 1; a < 3; a++)
+                if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis]) axis = a;
+
+            const size_t mid = begin + (end - begin) / 2;
+            std::nth_element(m_boxes.begin() + begin, m_boxes.begin() + mid, m_boxes.begin() + end,
+                [axis](const Box& a, const Box& b) { return a.centroid(axis) < b.centroid(axis); });
+
+            build_recursive(begin, mid);
+            const uint32_t right = build_recursive(mid, end);
+            m_nodes[ni].index = right;
+            m_nodes[ni].count = 0;
+            return ni;
+        }
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_items;
+        std::vector<Box> m_boxes;   // Item boxes, in leaf order
+    };
+
+} // namespace eeng
+
+#endif
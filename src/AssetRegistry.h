@@ -0,0 +1,211 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_AssetRegistry_h
+#define EENG_AssetRegistry_h
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace eeng
+{
+    /// @brief 32-bit reference to an asset of type T in an AssetRegistry
+    /** The low 24 bits are a slot index, the high 8 bits the generation of the slot when the asset
+     * was added. A slot gets a new generation each time its asset is unloaded, so handles to an
+     * unloaded asset are recognized as stale even after the slot is reused. The null handle is 0.
+     */
+    template<class T>
+    struct AssetHandle
+    {
+        static constexpr uint32_t index_bits = 24;
+        static constexpr uint32_t index_mask = (1u << index_bits) - 1;
+
+        uint32_t value = 0;
+
+        uint32_t index() const { return value & index_mask; }
+        uint32_t generation() const { return value >> index_bits; }
+        bool is_null() const { return value == 0; }
+        explicit operator bool() const { return value != 0; }
+        bool operator==(const AssetHandle&) const = default;
+    };
+
+    /// @brief Owns the assets of one type and hands out generational handles to them
+    /** Assets are kept in dense arrays and reached from a handle through its slot, so a lookup is two
+     * array reads and no reference counting. Each asset has a name, under which it is loaded at most
+     * once, and an explicit reference count: load() and acquire() add a reference, release() drops
+     * one and unloads the asset when none are left. Components can thus hold a plain handle, and
+     * only code that loads and unloads pays for the bookkeeping.
+     *
+     * Unloading moves the last asset into the freed place, and replace() swaps the object behind
+     * a handle, e.g. for a streamed-in version. Handles stay valid either way; pointers returned by
+     * get() stay valid until their asset is unloaded or replaced.
+     *
+     * Lookups may run on any number of threads at once, but not concurrently with loading,
+     * unloading or replacing.
+     */
+    template<class T>
+    class AssetRegistry
+    {
+    public:
+        using Handle = AssetHandle<T>;
+
+        AssetRegistry() = default;
+        AssetRegistry(const AssetRegistry&) = delete;
+        AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+        /// @brief Add a reference to the asset called name, creating it with init(T&) if it is not loaded
+        template<class F>
+        Handle load(const std::string& name, F&& init)
+        {
+            if (Handle handle = find(name))
+            {
+                acquire(handle);
+                return handle;
+            }
+            auto asset = std::make_unique<T>();
+            init(*asset);
+            return add(name, std::move(asset));
+        }
+
+        /// @brief Take ownership of an asset under a name not yet in use, with one reference
+        Handle add(const std::string& name, std::unique_ptr<T> asset)
+        {
+            assert(asset && !m_by_name.count(name));
+            uint32_t index;
+            if (m_free_slots.empty())
+            {
+                index = uint32_t(m_slots.size());
+                assert(index <= Handle::index_mask);
+                m_slots.push_back({ 0, 1 });
+            }
+            else
+            {
+                index = m_free_slots.back();
+                m_free_slots.pop_back();
+            }
+            Slot& slot = m_slots[index];
+            slot.dense = uint32_t(m_assets.size());
+
+            m_assets.push_back(std::move(asset));
+            m_names.push_back(name);
+            m_ref_counts.push_back(1);
+            m_dense_slots.push_back(index);
+
+            const Handle handle{ (slot.generation << Handle::index_bits) | index };
+            m_by_name.emplace(name, handle);
+            return handle;
+        }
+
+        /// @brief Handle of the asset called name, or a null handle
+        Handle find(const std::string& name) const
+        {
+            auto it = m_by_name.find(name);
+            return it == m_by_name.end() ? Handle{} : it->second;
+        }
+
+        /// @brief The asset, or nullptr if the handle is null or stale
+        T* get(Handle handle) const
+        {
+            const uint32_t index = handle.index();
+            if (handle.is_null() || index >= m_slots.size() || m_slots[index].generation != handle.generation()) return nullptr;
+            return m_assets[m_slots[index].dense].get();
+        }
+
+        bool valid(Handle handle) const { return get(handle) != nullptr; }
+
+        void acquire(Handle handle)
+        {
+            assert(valid(handle));
+            m_ref_counts[m_slots[handle.index()].dense]++;
+        }
+
+        /// @brief Drop a reference, and unload the asset when it was the last one
+        /// @return True if the asset was unloaded
+        bool release(Handle handle)
+        {
+            assert(valid(handle));
+            Slot& slot = m_slots[handle.index()];
+            if (--m_ref_counts[slot.dense] > 0) return false;
+
+            // Fill the gap with the last asset
+            const uint32_t dense = slot.dense, last = uint32_t(m_assets.size() - 1);
+            m_by_name.erase(m_names[dense]);
+            if (dense != last)
+            {
+                m_assets[dense] = std::move(m_assets[last]);
+                m_names[dense] = std::move(m_names[last]);
+                m_ref_counts[dense] = m_ref_counts[last];
+                m_dense_slots[dense] = m_dense_slots[last];
+                m_slots[m_dense_slots[dense]].dense = dense;
+            }
+            m_assets.pop_back();
+            m_names.pop_back();
+            m_ref_counts.pop_back();
+            m_dense_slots.pop_back();
+
+            // Generation 0 is skipped, so that no live handle is null
+            slot.generation = (slot.generation + 1) & (~0u >> Handle::index_bits);
+            if (slot.generation == 0) slot.generation = 1;
+            m_free_slots.push_back(handle.index());
+            return true;
+        }
+
+        /// @brief Swap the object behind a handle, keeping its name and references
+        /// @return The previous object
+        std::unique_ptr<T> replace(Handle handle, std::unique_ptr<T> asset)
+        {
+            assert(valid(handle) && asset);
+            std::swap(m_assets[m_slots[handle.index()].dense], asset);
+            return asset;
+        }
+
+        uint32_t ref_count(Handle handle) const
+        {
+            return valid(handle) ? m_ref_counts[m_slots[handle.index()].dense] : 0;
+        }
+
+        const std::string& name(Handle handle) const
+        {
+            assert(valid(handle));
+            return m_names[m_slots[handle.index()].dense];
+        }
+
+        /// Number of loaded assets
+        size_t size() const { return m_assets.size(); }
+
+        /// @brief Calls func(handle, asset) for each loaded asset
+        template<class F>
+        void for_each(F&& func) const
+        {
+            for (size_t i = 0; i < m_assets.size(); i++)
+            {
+                const uint32_t index = m_dense_slots[i];
+                func(Handle{ (m_slots[index].generation << Handle::index_bits) | index }, *m_assets[i]);
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t dense;         // Position of the asset in the dense arrays while loaded
+            uint32_t generation;    // Never 0
+        };
+
+        // Per loaded asset
+        std::vector<std::unique_ptr<T>> m_assets;
+        std::vector<std::string> m_names;
+        std::vector<uint32_t> m_ref_counts;
+        std::vector<uint32_t> m_dense_slots;    // Slot of each asset
+
+        std::vector<Slot> m_slots;
+        std::vector<uint32_t> m_free_slots;
+        std::unordered_map<std::string, Handle> m_by_name;
+    };
+
+} // namespace eeng
+
+#endif
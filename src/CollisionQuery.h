@@ -0,0 +1,270 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_CollisionQuery_h
+#define EENG_CollisionQuery_h
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "CollisionSoA.h"
+
+namespace eeng
+{
+    /// Conservative advancement steps before a sphere-cast grazing a box edge is taken as a miss
+    constexpr int SphereCastMaxSteps = 32;
+
+    /// @brief A ray in the form the ray kernels consume
+    /** The direction is expected to be normalized, so that hit distances are in world units.
+     * Zero direction components get a huge, correctly signed inverse instead of infinity,
+     * which keeps the slab products free of NaNs.
+     */
+    struct RayQuery
+    {
+        float o[3];         ///< Origin
+        float d[3];         ///< Normalized direction
+        float inv_d[3];     ///< 1 / d
+        float t_max;        ///< Hits further away are ignored
+        float radius;       ///< Swept radius, 0 for plain rays
+
+        static RayQuery make(const float origin[3], const float dir[3], float t_max = FLT_MAX, float radius = 0.0f)
+        {
+            RayQuery q;
+            for (int a = 0; a < 3; a++)
+            {
+                q.o[a] = origin[a];
+                q.d[a] = dir[a];
+                q.inv_d[a] = std::abs(dir[a]) > 1e-20f ? 1.0f / dir[a] : std::copysign(FLT_MAX, dir[a]);
+            }
+            q.t_max = t_max;
+            q.radius = radius;
+            return q;
+        }
+    };
+
+    /// @brief Slab test of a ray against AABB lanes [0, W), boxes inflated by the ray radius
+    /** Near and far planes are picked from the sign of the direction rather than by min/max
+     * of the two slab distances. Empty (inverted) boxes therefore stay empty and never report
+     * a hit. Origins inside a box hit at t = 0.
+     * @param t Receives the entry distance of each lane, valid where the mask bit is set
+     * @return Bit mask of the hit lanes
+     */
+    inline uint32_t ray_aabbs_scalar(const ColliderLanes& c, const RayQuery& q, size_t W, float* t)
+    {
+        const float* lo[3]{ c.min_x, c.min_y, c.min_z };
+        const float* hi[3]{ c.max_x, c.max_y, c.max_z };
+        uint32_t mask = 0;
+        for (size_t k = 0; k < W; k++)
+        {
+            float t_near = 0.0f, t_far = q.t_max;
+            for (int a = 0; a < 3; a++)
+            {
+                const float near_plane = (q.inv_d[a] >= 0.0f ? lo[a][k] - q.radius : hi[a][k] + q.radius);
+                const float far_plane = (q.inv_d[a] >= 0.0f ? hi[a][k] + q.radius : lo[a][k] - q.radius);
+                t_near = std::max(t_near, (near_plane - q.o[a]) * q.inv_d[a]);
+                t_far = std::min(t_far, (far_plane - q.o[a]) * q.inv_d[a]);
+            }
+            t[k] = t_near;
+            if (t_near <= t_far) mask |= 1u << k;
+        }
+        return mask;
+    }
+
+    /// @brief Ray against sphere lanes [0, W), spheres inflated by the ray radius. Exact for sphere-casts.
+    /// @param t Receives the entry distance of each lane, valid where the mask bit is set
+    /// @return Bit mask of the hit lanes
+    inline uint32_t ray_spheres_scalar(const ColliderLanes& c, const RayQuery& q, size_t W, float* t)
+    {
+        uint32_t mask = 0;
+        for (size_t k = 0; k < W; k++)
+        {
+            const float mx = q.o[0] - c.cx[k], my = q.o[1] - c.cy[k], mz = q.o[2] - c.cz[k];
+            const float r = c.r[k] + q.radius;
+            const float b = mx * q.d[0] + my * q.d[1] + mz * q.d[2];
+            const float cc = mx * mx + my * my + mz * mz - r * r;
+            const float disc = b * b - cc;
+            // NaN centers (colliders without a sphere) fail every comparison below
+            if (!(disc >= 0.0f)) continue;
+            const float t_hit = cc <= 0.0f ? 0.0f : -b - std::sqrt(disc);
+            if (t_hit >= 0.0f && t_hit <= q.t_max)
+            {
+                t[k] = t_hit;
+                mask |= 1u << k;
+            }
+        }
+        return mask;
+    }
+
+    inline uint32_t ray_aabbs_4(const ColliderLanes& c, const RayQuery& q, float* t)
+    {
+#if defined(EENG_SIMD_SSE)
+        const float* lo[3]{ c.min_x, c.min_y, c.min_z };
+        const float* hi[3]{ c.max_x, c.max_y, c.max_z };
+        const __m128 rad = _mm_set1_ps(q.radius);
+        __m128 t_near = _mm_setzero_ps(), t_far = _mm_set1_ps(q.t_max);
+        for (int a = 0; a < 3; a++)
+        {
+            const bool pos = q.inv_d[a] >= 0.0f;
+            const __m128 near_plane = pos ? _mm_sub_ps(_mm_loadu_ps(lo[a]), rad) : _mm_add_ps(_mm_loadu_ps(hi[a]), rad);
+            const __m128 far_plane = pos ? _mm_add_ps(_mm_loadu_ps(hi[a]), rad) : _mm_sub_ps(_mm_loadu_ps(lo[a]), rad);
+            const __m128 o = _mm_set1_ps(q.o[a]), inv = _mm_set1_ps(q.inv_d[a]);
+            t_near = _mm_max_ps(t_near, _mm_mul_ps(_mm_sub_ps(near_plane, o), inv));
+            t_far = _mm_min_ps(t_far, _mm_mul_ps(_mm_sub_ps(far_plane, o), inv));
+        }
+        _mm_storeu_ps(t, t_near);
+        return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(t_near, t_far));
+#elif defined(EENG_SIMD_NEON)
+        const float* lo[3]{ c.min_x, c.min_y, c.min_z };
+        const float* hi[3]{ c.max_x, c.max_y, c.max_z };
+        const float32x4_t rad = vdupq_n_f32(q.radius);
+        float32x4_t t_near = vdupq_n_f32(0.0f), t_far = vdupq_n_f32(q.t_max);
+        for (int a = 0; a < 3; a++)
+        {
+            const bool pos = q.inv_d[a] >= 0.0f;
+            const float32x4_t near_plane = pos ? vsubq_f32(vld1q_f32(lo[a]), rad) : vaddq_f32(vld1q_f32(hi[a]), rad);
+            const float32x4_t far_plane = pos ? vaddq_f32(vld1q_f32(hi[a]), rad) : vsubq_f32(vld1q_f32(lo[a]), rad);
+            const float32x4_t o = vdupq_n_f32(q.o[a]), inv = vdupq_n_f32(q.inv_d[a]);
+            t_near = vmaxq_f32(t_near, vmulq_f32(vsubq_f32(near_plane, o), inv));
+            t_far = vminq_f32(t_far, vmulq_f32(vsubq_f32(far_plane, o), inv));
+        }
+        vst1q_f32(t, t_near);
+        const uint32_t bits[4]{ 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(vcleq_f32(t_near, t_far), vld1q_u32(bits)));
+#else
+        return ray_aabbs_scalar(c, q, 4, t);
+#endif
+    }
+
+    inline uint32_t ray_aabbs_8(const ColliderLanes& c, const RayQuery& q, float* t)
+    {
+#if defined(EENG_SIMD_AVX)
+        const float* lo[3]{ c.min_x, c.min_y, c.min_z };
+        const float* hi[3]{ c.max_x, c.max_y, c.max_z };
+        const __m256 rad = _mm256_set1_ps(q.radius);
+        __m256 t_near = _mm256_setzero_ps(), t_far = _mm256_set1_ps(q.t_max);
+        for (int a = 0; a < 3; a++)
+        {
+            const bool pos = q.inv_d[a] >= 0.0f;
+            const __m256 near_plane = pos ? _mm256_sub_ps(_mm256_loadu_ps(lo[a]), rad) : _mm256_add_ps(_mm256_loadu_ps(hi[a]), rad);
+            const __m256 far_plane = pos ? _mm256_add_ps(_mm256_loadu_ps(hi[a]), rad) : _mm256_sub_ps(_mm256_loadu_ps(lo[a]), rad);
+            const __m256 o = _mm256_set1_ps(q.o[a]), inv = _mm256_set1_ps(q.inv_d[a]);
+            t_near = _mm256_max_ps(t_near, _mm256_mul_ps(_mm256_sub_ps(near_plane, o), inv));
+            t_far = _mm256_min_ps(t_far, _mm256_mul_ps(_mm256_sub_ps(far_plane, o), inv));
+        }
+        _mm256_storeu_ps(t, t_near);
+        return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ));
+#else
+        return ray_aabbs_4(c, q, t) | (ray_aabbs_4(c.offset(4), q, t + 4) << 4);
+#endif
+    }
+
+    inline uint32_t ray_aabbs_16(const ColliderLanes& c, const RayQuery& q, float* t)
+    {
+        return ray_aabbs_8(c, q, t) | (ray_aabbs_8(c.offset(8), q, t + 8) << 8);
+    }
+
+    template<size_t W>
+    inline uint32_t ray_aabbs(const ColliderLanes& c, const RayQuery& q, float* t)
+    {
+        static_assert(W == 4 || W == 8 || W == 16, "Unsupported batch width");
+        if constexpr (W == 4) return ray_aabbs_4(c, q, t);
+        else if constexpr (W == 8) return ray_aabbs_8(c, q, t);
+        else return ray_aabbs_16(c, q, t);
+    }
+
+    /// @brief Ray against a single collider: its AABB if it has one, otherwise its sphere
+    /// @param t Receives the entry distance on a hit
+    inline bool ray_collider(const ColliderSoA& soa, size_t i, const RayQuery& q, float& t)
+    {
+        const ColliderLanes lane(soa, i);
+        if (soa.flags[i] & ColliderHasAABB)
+            return ray_aabbs_scalar(lane, q, 1, &t);
+        if (soa.flags[i] & ColliderHasSphere)
+            return ray_spheres_scalar(lane, q, 1, &t);
+        return false;
+    }
+
+    /// @brief Time of impact of a sphere-cast with a box, exact at its edges and corners
+    /** Starts at the entry distance into the box grown by the radius, then advances conservatively
+     * by the distance from the ray point to the box minus the radius, which only takes more than a
+     * step or two where the ray passes close to an edge or a corner. Origins within the radius of
+     * the box hit at t = 0.
+     */
+    inline bool sphere_cast_aabb(const RayQuery& q, const float min[3], const float max[3], float& t_hit)
+    {
+        float t_near = 0.0f, t_far = q.t_max;
+        for (int a = 0; a < 3; a++)
+        {
+            const float near_plane = (q.inv_d[a] >= 0.0f ? min[a] - q.radius : max[a] + q.radius);
+            const float far_plane = (q.inv_d[a] >= 0.0f ? max[a] + q.radius : min[a] - q.radius);
+            t_near = std::max(t_near, (near_plane - q.o[a]) * q.inv_d[a]);
+            t_far = std::min(t_far, (far_plane - q.o[a]) * q.inv_d[a]);
+        }
+        if (t_near > t_far) return false;
+
+        const float tolerance = 1e-4f * std::max(1.0f, q.radius);
+        float t = t_near;
+        for (int step = 0; step < SphereCastMaxSteps && t <= t_far; step++)
+        {
+            float dist2 = 0.0f;
+            for (int a = 0; a < 3; a++)
+            {
+                const float p = q.o[a] + q.d[a] * t;
+                const float outside = std::max(std::max(min[a] - p, p - max[a]), 0.0f);
+                dist2 += outside * outside;
+            }
+            const float gap = std::sqrt(dist2) - q.radius;
+            if (gap <= tolerance)
+            {
+                t_hit = t;
+                return true;
+            }
+            t += gap;
+        }
+        return false;
+    }
+
+    /// @brief Time of impact of a sphere-cast with a plane through point with unit normal, from either side
+    /** Origins within the radius of the plane hit at t = 0. */
+    inline bool sphere_cast_plane(const RayQuery& q, const float point[3], const float normal[3], float& t_hit)
+    {
+        const float dist = (q.o[0] - point[0]) * normal[0] + (q.o[1] - point[1]) * normal[1] + (q.o[2] - point[2]) * normal[2];
+        const float speed = q.d[0] * normal[0] + q.d[1] * normal[1] + q.d[2] * normal[2];
+        if (std::abs(dist) <= q.radius)
+        {
+            t_hit = 0.0f;
+            return true;
+        }
+        // Parallel to the plane or moving away from it
+        if (dist * speed >= 0.0f) return false;
+        const float t = (std::abs(dist) - q.radius) / std::abs(speed);
+        if (t > q.t_max) return false;
+        t_hit = t;
+        return true;
+    }
+
+    /// @brief Time of impact of a sphere-cast with a single collider, the earlier of its sphere and its AABB
+    inline bool sphere_cast_collider(const ColliderSoA& soa, size_t i, const RayQuery& q, float& t_hit)
+    {
+        bool hit = false;
+        float t;
+        if ((soa.flags[i] & ColliderHasSphere) && ray_spheres_scalar(ColliderLanes(soa, i), q, 1, &t))
+        {
+            t_hit = t;
+            hit = true;
+        }
+        if (soa.flags[i] & ColliderHasAABB)
+        {
+            const float mn[3]{ soa.min_x[i], soa.min_y[i], soa.min_z[i] };
+            const float mx[3]{ soa.max_x[i], soa.max_y[i], soa.max_z[i] };
+            if (sphere_cast_aabb(q, mn, mx, t) && (!hit || t < t_hit))
+            {
+                t_hit = t;
+                hit = true;
+            }
+        }
+        return hit;
+    }
+
+} // namespace eeng
+
+#endif
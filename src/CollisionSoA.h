@@ -0,0 +1,523 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_CollisionSoA_h
+#define EENG_CollisionSoA_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+#include <bit>
+#include <algorithm>
+#include <limits>
+#include "config.h"
+
+#if defined(EENG_SIMD_AVX) || defined(EENG_SIMD_AVX512)
+#include <immintrin.h>
+#elif defined(EENG_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+#if defined(EENG_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace eeng
+{
+    /// Widest batch the overlap kernels test natively on this target
+#if defined(EENG_SIMD_AVX512)
+    constexpr size_t CollisionBatchWidth = 16;
+#elif defined(EENG_SIMD_AVX)
+    constexpr size_t CollisionBatchWidth = 8;
+#else
+    constexpr size_t CollisionBatchWidth = 4;
+#endif
+
+    /// Sphere center of colliders without a sphere. Compares false against everything, itself included.
+    constexpr float NoSphere = std::numeric_limits<float>::quiet_NaN();
+
+    /// SoA arrays are padded to a multiple of this so that any kernel width can load full batches
+    constexpr size_t CollisionMaxBatchWidth = 16;
+
+    enum ColliderFlags : uint8_t
+    {
+        ColliderHasSphere = 0x1,
+        ColliderHasAABB = 0x2,
+        ColliderIsTrigger = 0x4,
+        ColliderIsAsleep = 0x8      ///< Belongs to a sleeping body, only paired with colliders that are awake
+    };
+
+    /// @brief Structure-of-arrays mirror of world-space sphere and AABB colliders
+    /** Colliders without a sphere get a NaN sphere center, and colliders without
+     * an AABB get an inverted (empty) box, so neither ever reports an overlap. The same
+     * sentinels fill the padding after the last collider.
+     */
+    struct ColliderSoA
+    {
+        std::vector<float> center_x, center_y, center_z, radius;
+        std::vector<float> min_x, min_y, min_z;
+        std::vector<float> max_x, max_y, max_z;
+        std::vector<uint32_t> owner;    ///< Opaque owner id, e.g. an entity
+        std::vector<uint8_t> flags;     ///< ColliderFlags
+        std::vector<uint32_t> layer;    ///< Layer bits the collider belongs to
+        std::vector<uint32_t> mask;     ///< Layer bits the collider tests against
+        size_t count = 0;               ///< Nbr of colliders, excluding padding
+
+        void clear()
+        {
+            for (auto* v : { &center_x, &center_y, &center_z, &radius, &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+                v->clear();
+            owner.clear();
+            flags.clear();
+            layer.clear();
+            mask.clear();
+            count = 0;
+        }
+
+        void reserve(size_t n)
+        {
+            n = padded_size(n);
+            for (auto* v : { &center_x, &center_y, &center_z, &radius, &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+                v->reserve(n);
+            owner.reserve(n);
+            flags.reserve(n);
+            layer.reserve(n);
+            mask.reserve(n);
+        }
+
+        /// @brief Append a collider. Call pad() once all colliders are added.
+        /// Two colliders are tested against each other only if each one's layer is in the other's mask.
+        /// @return Index of the collider
+        size_t push(
+            uint32_t owner_id,
+            uint8_t collider_flags,
+            const float center[3],
+            float r,
+            const float aabb_min[3],
+            const float aabb_max[3],
+            uint32_t collider_layer = ~0u,
+            uint32_t collider_mask = ~0u)
+        {
+            // Drop padding from a previous pad()
+            truncate(count);
+
+            if (collider_flags & ColliderHasSphere)
+                push_sphere(center[0], center[1], center[2], r);
+            else
+                push_sphere(NoSphere, NoSphere, NoSphere, 0.0f);
+
+            if (collider_flags & ColliderHasAABB)
+                push_aabb(aabb_min, aabb_max);
+            else
+                push_empty_aabb();
+
+            owner.push_back(owner_id);
+            flags.push_back(collider_flags);
+            layer.push_back(collider_layer);
+            mask.push_back(collider_mask);
+            return count++;
+        }
+
+        /// @brief Keep the first n colliders and drop the rest, e.g. to refill everything after a fixed prefix
+        void shrink(size_t n)
+        {
+            if (n >= count) return;
+            truncate(n);
+            count = n;
+        }
+
+        /// @brief Pad arrays with sentinels up to a multiple of CollisionMaxBatchWidth
+        void pad()
+        {
+            const size_t n = padded_size(count);
+            while (center_x.size() < n)
+            {
+                push_sphere(NoSphere, NoSphere, NoSphere, 0.0f);
+                push_empty_aabb();
+                owner.push_back(0);
+                flags.push_back(0);
+                layer.push_back(0);
+                mask.push_back(0);
+            }
+        }
+
+        /// @brief True if colliders i and j may collide according to their layers and masks
+        bool layers_interact(size_t i, size_t j) const
+        {
+            return (layer[i] & mask[j]) && (layer[j] & mask[i]);
+        }
+
+        /// @brief Bitmask of the W colliders starting at first that collider i may collide with.
+        /// Padding lanes have no layer and are never included.
+        uint32_t layer_filter(size_t i, size_t first, size_t W) const
+        {
+            const uint32_t qlayer = layer[i], qmask = mask[i];
+            uint32_t bits = 0;
+            for (size_t k = 0; k < W; k++)
+                bits |= uint32_t((layer[first + k] & qmask) != 0 && (qlayer & mask[first + k]) != 0) << k;
+            return bits;
+        }
+
+        /// @brief Box enclosing both the sphere and the AABB of collider i
+        void bounds(size_t i, float out_min[3], float out_max[3]) const
+        {
+            out_min[0] = out_min[1] = out_min[2] = FLT_MAX;
+            out_max[0] = out_max[1] = out_max[2] = -FLT_MAX;
+            if (flags[i] & ColliderHasSphere)
+            {
+                const float c[3]{ center_x[i], center_y[i], center_z[i] };
+                for (int a = 0; a < 3; a++)
+                {
+                    out_min[a] = c[a] - radius[i];
+                    out_max[a] = c[a] + radius[i];
+                }
+            }
+            if (flags[i] & ColliderHasAABB)
+            {
+                const float mn[3]{ min_x[i], min_y[i], min_z[i] }, mx[3]{ max_x[i], max_y[i], max_z[i] };
+                for (int a = 0; a < 3; a++)
+                {
+                    out_min[a] = std::min(out_min[a], mn[a]);
+                    out_max[a] = std::max(out_max[a], mx[a]);
+                }
+            }
+        }
+
+        /// @brief Move a collider, keeping sphere and AABB in sync
+        void translate(size_t i, float dx, float dy, float dz)
+        {
+            if (flags[i] & ColliderHasSphere)
+            {
+                center_x[i] += dx; center_y[i] += dy; center_z[i] += dz;
+            }
+            if (flags[i] & ColliderHasAABB)
+            {
+                min_x[i] += dx; min_y[i] += dy; min_z[i] += dz;
+                max_x[i] += dx; max_y[i] += dy; max_z[i] += dz;
+            }
+        }
+
+        /// Size of the padded arrays
+        size_t padded_count() const { return center_x.size(); }
+
+        static size_t padded_size(size_t n)
+        {
+            return (n + CollisionMaxBatchWidth - 1) / CollisionMaxBatchWidth * CollisionMaxBatchWidth;
+        }
+
+    private:
+        void push_sphere(float x, float y, float z, float r)
+        {
+            center_x.push_back(x); center_y.push_back(y); center_z.push_back(z);
+            radius.push_back(r);
+        }
+
+        void push_aabb(const float mn[3], const float mx[3])
+        {
+            min_x.push_back(mn[0]); min_y.push_back(mn[1]); min_z.push_back(mn[2]);
+            max_x.push_back(mx[0]); max_y.push_back(mx[1]); max_z.push_back(mx[2]);
+        }
+
+        void push_empty_aabb()
+        {
+            const float mn[3]{ FLT_MAX, FLT_MAX, FLT_MAX };
+            const float mx[3]{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            push_aabb(mn, mx);
+        }
+
+        void truncate(size_t n)
+        {
+            for (auto* v : { &center_x, &center_y, &center_z, &radius, &min_x, &min_y, &min_z, &max_x, &max_y, &max_z })
+                v->resize(n);
+            owner.resize(n);
+            flags.resize(n);
+            layer.resize(n);
+            mask.resize(n);
+        }
+    };
+
+    /// @brief A query collider in the form the kernels consume
+    struct ColliderQuery
+    {
+        float x, y, z, r;
+        float min[3], max[3];
+
+        static ColliderQuery from(const ColliderSoA& soa, size_t i)
+        {
+            return ColliderQuery{
+                soa.center_x[i], soa.center_y[i], soa.center_z[i], soa.radius[i],
+                { soa.min_x[i], soa.min_y[i], soa.min_z[i] },
+                { soa.max_x[i], soa.max_y[i], soa.max_z[i] } };
+        }
+    };
+
+    /// @brief Pointers to the first element of a batch of candidates
+    struct ColliderLanes
+    {
+        const float* cx, * cy, * cz, * r;
+        const float* min_x, * min_y, * min_z;
+        const float* max_x, * max_y, * max_z;
+
+        ColliderLanes(const ColliderSoA& soa, size_t first)
+            : cx(&soa.center_x[first]), cy(&soa.center_y[first]), cz(&soa.center_z[first]), r(&soa.radius[first]),
+            min_x(&soa.min_x[first]), min_y(&soa.min_y[first]), min_z(&soa.min_z[first]),
+            max_x(&soa.max_x[first]), max_y(&soa.max_y[first]), max_z(&soa.max_z[first]) {
+        }
+
+        ColliderLanes offset(size_t k) const
+        {
+            ColliderLanes l = *this;
+            for (auto* p : { &l.cx, &l.cy, &l.cz, &l.r, &l.min_x, &l.min_y, &l.min_z, &l.max_x, &l.max_y, &l.max_z })
+                *p += k;
+            return l;
+        }
+
+    private:
+        ColliderLanes() = default;
+        friend struct ColliderGather;
+    };
+
+    /// @brief Candidates gathered by index (e.g. from a broadphase leaf) into one batch
+    struct ColliderGather
+    {
+        alignas(64) float cx[CollisionMaxBatchWidth], cy[CollisionMaxBatchWidth], cz[CollisionMaxBatchWidth], r[CollisionMaxBatchWidth];
+        alignas(64) float min_x[CollisionMaxBatchWidth], min_y[CollisionMaxBatchWidth], min_z[CollisionMaxBatchWidth];
+        alignas(64) float max_x[CollisionMaxBatchWidth], max_y[CollisionMaxBatchWidth], max_z[CollisionMaxBatchWidth];
+
+        /// @brief Gather n <= CollisionMaxBatchWidth colliders, padding the rest with sentinels
+        void gather(const ColliderSoA& soa, const uint32_t* indices, size_t n)
+        {
+            for (size_t k = n; k < CollisionMaxBatchWidth; k++)
+            {
+                cx[k] = cy[k] = cz[k] = NoSphere; r[k] = 0.0f;
+                min_x[k] = min_y[k] = min_z[k] = FLT_MAX;
+                max_x[k] = max_y[k] = max_z[k] = -FLT_MAX;
+            }
+            for (size_t k = 0; k < n; k++)
+            {
+                const size_t i = indices[k];
+                cx[k] = soa.center_x[i]; cy[k] = soa.center_y[i]; cz[k] = soa.center_z[i]; r[k] = soa.radius[i];
+                min_x[k] = soa.min_x[i]; min_y[k] = soa.min_y[i]; min_z[k] = soa.min_z[i];
+                max_x[k] = soa.max_x[i]; max_y[k] = soa.max_y[i]; max_z[k] = soa.max_z[i];
+            }
+        }
+
+        /// @brief Gather sphere lanes only, for a sphere pass before exact AABB tests on the survivors
+        void gather_spheres(const ColliderSoA& soa, const uint32_t* indices, size_t n)
+        {
+            for (size_t k = n; k < CollisionMaxBatchWidth; k++)
+            {
+                cx[k] = cy[k] = cz[k] = NoSphere; r[k] = 0.0f;
+            }
+            for (size_t k = 0; k < n; k++)
+            {
+                const size_t i = indices[k];
+                cx[k] = soa.center_x[i]; cy[k] = soa.center_y[i]; cz[k] = soa.center_z[i]; r[k] = soa.radius[i];
+            }
+        }
+
+        ColliderLanes lanes() const
+        {
+            ColliderLanes l;
+            l.cx = cx; l.cy = cy; l.cz = cz; l.r = r;
+            l.min_x = min_x; l.min_y = min_y; l.min_z = min_z;
+            l.max_x = max_x; l.max_y = max_y; l.max_z = max_z;
+            return l;
+        }
+    };
+
+    // --- Scalar reference kernels ----------------------------------------------
+
+    /// Sphere overlap of the query against lanes [0, W), as a bit mask
+    inline uint32_t overlap_spheres_scalar(const ColliderLanes& c, const ColliderQuery& q, size_t W)
+    {
+        uint32_t mask = 0;
+        for (size_t k = 0; k < W; k++)
+        {
+            const float dx = c.cx[k] - q.x, dy = c.cy[k] - q.y, dz = c.cz[k] - q.z;
+            const float rs = c.r[k] + q.r;
+            if (dx * dx + dy * dy + dz * dz <= rs * rs)
+                mask |= 1u << k;
+        }
+        return mask;
+    }
+
+    /// AABB overlap of the query against lanes [0, W), as a bit mask
+    inline uint32_t overlap_aabbs_scalar(const ColliderLanes& c, const ColliderQuery& q, size_t W)
+    {
+        uint32_t mask = 0;
+        for (size_t k = 0; k < W; k++)
+        {
+            if (c.min_x[k] <= q.max[0] && q.min[0] <= c.max_x[k] &&
+                c.min_y[k] <= q.max[1] && q.min[1] <= c.max_y[k] &&
+                c.min_z[k] <= q.max[2] && q.min[2] <= c.max_z[k])
+                mask |= 1u << k;
+        }
+        return mask;
+    }
+
+    // --- 4-wide kernels (SSE, NEON or scalar) -----------------------------------
+
+    inline uint32_t overlap_spheres_4(const ColliderLanes& c, const ColliderQuery& q)
+    {
+#if defined(EENG_SIMD_SSE)
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(c.cx), _mm_set1_ps(q.x));
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(c.cy), _mm_set1_ps(q.y));
+        const __m128 dz = _mm_sub_ps(_mm_loadu_ps(c.cz), _mm_set1_ps(q.z));
+        const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        const __m128 rs = _mm_add_ps(_mm_loadu_ps(c.r), _mm_set1_ps(q.r));
+        return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(rs, rs)));
+#elif defined(EENG_SIMD_NEON)
+        const float32x4_t dx = vsubq_f32(vld1q_f32(c.cx), vdupq_n_f32(q.x));
+        const float32x4_t dy = vsubq_f32(vld1q_f32(c.cy), vdupq_n_f32(q.y));
+        const float32x4_t dz = vsubq_f32(vld1q_f32(c.cz), vdupq_n_f32(q.z));
+        const float32x4_t d2 = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+        const float32x4_t rs = vaddq_f32(vld1q_f32(c.r), vdupq_n_f32(q.r));
+        const uint32x4_t cmp = vcleq_f32(d2, vmulq_f32(rs, rs));
+        const uint32_t bits[4]{ 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(cmp, vld1q_u32(bits)));
+#else
+        return overlap_spheres_scalar(c, q, 4);
+#endif
+    }
+
+    inline uint32_t overlap_aabbs_4(const ColliderLanes& c, const ColliderQuery& q)
+    {
+#if defined(EENG_SIMD_SSE)
+        __m128 m = _mm_and_ps(
+            _mm_cmple_ps(_mm_loadu_ps(c.min_x), _mm_set1_ps(q.max[0])),
+            _mm_cmple_ps(_mm_set1_ps(q.min[0]), _mm_loadu_ps(c.max_x)));
+        m = _mm_and_ps(m, _mm_cmple_ps(_mm_loadu_ps(c.min_y), _mm_set1_ps(q.max[1])));
+        m = _mm_and_ps(m, _mm_cmple_ps(_mm_set1_ps(q.min[1]), _mm_loadu_ps(c.max_y)));
+        m = _mm_and_ps(m, _mm_cmple_ps(_mm_loadu_ps(c.min_z), _mm_set1_ps(q.max[2])));
+        m = _mm_and_ps(m, _mm_cmple_ps(_mm_set1_ps(q.min[2]), _mm_loadu_ps(c.max_z)));
+        return (uint32_t)_mm_movemask_ps(m);
+#elif defined(EENG_SIMD_NEON)
+        uint32x4_t m = vandq_u32(
+            vcleq_f32(vld1q_f32(c.min_x), vdupq_n_f32(q.max[0])),
+            vcleq_f32(vdupq_n_f32(q.min[0]), vld1q_f32(c.max_x)));
+        m = vandq_u32(m, vcleq_f32(vld1q_f32(c.min_y), vdupq_n_f32(q.max[1])));
+        m = vandq_u32(m, vcleq_f32(vdupq_n_f32(q.min[1]), vld1q_f32(c.max_y)));
+        m = vandq_u32(m, vcleq_f32(vld1q_f32(c.min_z), vdupq_n_f32(q.max[2])));
+        m = vandq_u32(m, vcleq_f32(vdupq_n_f32(q.min[2]), vld1q_f32(c.max_z)));
+        const uint32_t bits[4]{ 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(m, vld1q_u32(bits)));
+#else
+        return overlap_aabbs_scalar(c, q, 4);
+#endif
+    }
+
+    // --- 8-wide kernels (AVX, or two 4-wide) ------------------------------------
+
+    inline uint32_t overlap_spheres_8(const ColliderLanes& c, const ColliderQuery& q)
+    {
+#if defined(EENG_SIMD_AVX)
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(c.cx), _mm256_set1_ps(q.x));
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(c.cy), _mm256_set1_ps(q.y));
+        const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(c.cz), _mm256_set1_ps(q.z));
+        const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        const __m256 rs = _mm256_add_ps(_mm256_loadu_ps(c.r), _mm256_set1_ps(q.r));
+        return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(rs, rs), _CMP_LE_OQ));
+#else
+        return overlap_spheres_4(c, q) | (overlap_spheres_4(c.offset(4), q) << 4);
+#endif
+    }
+
+    inline uint32_t overlap_aabbs_8(const ColliderLanes& c, const ColliderQuery& q)
+    {
+#if defined(EENG_SIMD_AVX)
+        __m256 m = _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_loadu_ps(c.min_x), _mm256_set1_ps(q.max[0]), _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_set1_ps(q.min[0]), _mm256_loadu_ps(c.max_x), _CMP_LE_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_loadu_ps(c.min_y), _mm256_set1_ps(q.max[1]), _CMP_LE_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_set1_ps(q.min[1]), _mm256_loadu_ps(c.max_y), _CMP_LE_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_loadu_ps(c.min_z), _mm256_set1_ps(q.max[2]), _CMP_LE_OQ));
+        m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_set1_ps(q.min[2]), _mm256_loadu_ps(c.max_z), _CMP_LE_OQ));
+        return (uint32_t)_mm256_movemask_ps(m);
+#else
+        return overlap_aabbs_4(c, q) | (overlap_aabbs_4(c.offset(4), q) << 4);
+#endif
+    }
+
+    // --- 16-wide kernels (AVX-512, or two 8-wide) -------------------------------
+
+    inline uint32_t overlap_spheres_16(const ColliderLanes& c, const ColliderQuery& q)
+    {
+#if defined(EENG_SIMD_AVX512)
+        const __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(c.cx), _mm512_set1_ps(q.x));
+        const __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(c.cy), _mm512_set1_ps(q.y));
+        const __m512 dz = _mm512_sub_ps(_mm512_loadu_ps(c.cz), _mm512_set1_ps(q.z));
+        const __m512 d2 = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz));
+        const __m512 rs = _mm512_add_ps(_mm512_loadu_ps(c.r), _mm512_set1_ps(q.r));
+        return (uint32_t)_mm512_cmp_ps_mask(d2, _mm512_mul_ps(rs, rs), _CMP_LE_OQ);
+#else
+        return overlap_spheres_8(c, q) | (overlap_spheres_8(c.offset(8), q) << 8);
+#endif
+    }
+
+    inline uint32_t overlap_aabbs_16(const ColliderLanes& c, const ColliderQuery& q)
+    {
+#if defined(EENG_SIMD_AVX512)
+        __mmask16 m = _mm512_cmp_ps_mask(_mm512_loadu_ps(c.min_x), _mm512_set1_ps(q.max[0]), _CMP_LE_OQ);
+        m &= _mm512_cmp_ps_mask(_mm512_set1_ps(q.min[0]), _mm512_loadu_ps(c.max_x), _CMP_LE_OQ);
+        m &= _mm512_cmp_ps_mask(_mm512_loadu_ps(c.min_y), _mm512_set1_ps(q.max[1]), _CMP_LE_OQ);
+        m &= _mm512_cmp_ps_mask(_mm512_set1_ps(q.min[1]), _mm512_loadu_ps(c.max_y), _CMP_LE_OQ);
+        m &= _mm512_cmp_ps_mask(_mm512_loadu_ps(c.min_z), _mm512_set1_ps(q.max[2]), _CMP_LE_OQ);
+        m &= _mm512_cmp_ps_mask(_mm512_set1_ps(q.min[2]), _mm512_loadu_ps(c.max_z), _CMP_LE_OQ);
+        return (uint32_t)m;
+#else
+        return overlap_aabbs_8(c, q) | (overlap_aabbs_8(c.offset(8), q) << 8);
+#endif
+    }
+
+    /// @brief Sphere overlap against W consecutive colliders, W ∈ {4, 8, 16}
+    template<size_t W>
+    inline uint32_t overlap_spheres(const ColliderLanes& c, const ColliderQuery& q)
+    {
+        static_assert(W == 4 || W == 8 || W == 16, "Unsupported batch width");
+        if constexpr (W == 4) return overlap_spheres_4(c, q);
+        else if constexpr (W == 8) return overlap_spheres_8(c, q);
+        else return overlap_spheres_16(c, q);
+    }
+
+    /// @brief AABB overlap against W consecutive colliders, W ∈ {4, 8, 16}
+    template<size_t W>
+    inline uint32_t overlap_aabbs(const ColliderLanes& c, const ColliderQuery& q)
+    {
+        static_assert(W == 4 || W == 8 || W == 16, "Unsupported batch width");
+        if constexpr (W == 4) return overlap_aabbs_4(c, q);
+        else if constexpr (W == 8) return overlap_aabbs_8(c, q);
+        else return overlap_aabbs_16(c, q);
+    }
+
+    /// @brief Brute-force visit of all pairs (i, j), i < j, whose layers interact and that pass Test
+    /// @param Test Kernel of type uint32_t(const ColliderLanes&, const ColliderQuery&)
+    /// @param func Function of type void(size_t i, size_t j)
+    /// @param begin Only pairs with begin <= i < j are visited
+    template<size_t W = CollisionBatchWidth, class Test, class F>
+    inline void for_each_overlapping_pair(const ColliderSoA& soa, const Test& test, const F& func, size_t begin = 0)
+    {
+        for (size_t i = begin; i < soa.count; i++)
+        {
+            const auto q = ColliderQuery::from(soa, i);
+            for (size_t first = (i + 1) / W * W; first < soa.count; first += W)
+            {
+                // Layer filtering comes first so that filtered batches skip the overlap test
+                uint32_t mask = soa.layer_filter(i, first, W);
+                if (!mask) continue;
+                mask &= test(ColliderLanes(soa, first), q);
+                // Lanes at or before i were visited as queries already
+                if (first <= i)
+                    mask &= ~((2u << (i - first)) - 1);
+                while (mask)
+                {
+                    const int lane = std::countr_zero(mask);
+                    mask &= mask - 1;
+                    func(i, first + lane);
+                }
+            }
+        }
+    }
+
+} // namespace eeng
+
+#endif
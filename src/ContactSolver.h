@@ -0,0 +1,158 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_ContactSolver_h
+#define EENG_ContactSolver_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+#include "ThreadPool.hpp"
+
+namespace eeng
+{
+    /// @brief Contact between two solver bodies
+    struct SolverContact
+    {
+        uint32_t a, b;      ///< Body indices
+        float normal[3];    ///< Unit normal pointing from a to b
+        float depth;        ///< Penetration along the normal when the contact was found
+    };
+
+    /// @brief Iterative position solver that pushes overlapping bodies apart
+    /** Contacts are greedily colored into batches in which no movable body appears twice.
+     * Batches are solved one after another, and the contacts of a batch in parallel, for a
+     * number of iterations. Each contact keeps track of how far its bodies have already been
+     * moved apart along its normal, so that later contacts see the effect of earlier ones and
+     * crowded contacts settle over the iterations.
+     *
+     * The result depends on the order of the contacts given to prepare(), but not on the
+     * number of threads.
+     */
+    class ContactSolver
+    {
+    public:
+        /// Colors tracked per body. Contacts that find no free color go to one extra batch, solved serially.
+        static constexpr size_t MaxColors = 64;
+
+        struct Settings
+        {
+            int iterations = 4;         ///< Passes over all batches
+            float relaxation = 1.0f;    ///< Fraction of the remaining penetration removed per contact and pass
+            float slop = 0.0f;          ///< Penetration left unresolved
+            size_t chunk_size = 64;     ///< Contacts per parallel task
+        } settings;
+
+        /// @brief Color contacts into batches
+        /// @param inv_mass Inverse mass per body, 0 for bodies that never move. Contacts between two such bodies are dropped.
+        void prepare(const SolverContact* contacts, size_t count, const float* inv_mass, size_t body_count)
+        {
+            m_inv_mass.assign(inv_mass, inv_mass + body_count);
+
+            // Bit c of a body's mask is set once a contact of color c moves the body
+            std::vector<uint64_t> used(body_count, 0);
+            std::vector<uint8_t> colors(count);
+            size_t batch_size[MaxColors + 1]{};
+            for (size_t i = 0; i < count; i++)
+            {
+                const SolverContact& c = contacts[i];
+                if (m_inv_mass[c.a] <= 0.0f && m_inv_mass[c.b] <= 0.0f)
+                {
+                    colors[i] = UINT8_MAX;
+                    continue;
+                }
+                const uint64_t taken = (m_inv_mass[c.a] > 0.0f ? used[c.a] : 0) | (m_inv_mass[c.b] > 0.0f ? used[c.b] : 0);
+                const size_t color = std::countr_one(taken);
+                if (color < MaxColors)
+                {
+                    if (m_inv_mass[c.a] > 0.0f) used[c.a] |= uint64_t(1) << color;
+                    if (m_inv_mass[c.b] > 0.0f) used[c.b] |= uint64_t(1) << color;
+                }
+                colors[i] = static_cast<uint8_t>(color);
+                batch_size[color]++;
+            }
+
+            // Counting sort on color, keeping the given order within each batch
+            size_t offset[MaxColors + 1];
+            m_batch_begin.clear();
+            size_t total = 0;
+            for (size_t k = 0; k <= MaxColors; k++)
+            {
+                offset[k] = total;
+                if (batch_size[k] == 0) continue;
+                m_batch_begin.push_back(total);
+                total += batch_size[k];
+            }
+            m_batch_begin.push_back(total);
+            m_serial_batch = batch_size[MaxColors] > 0 ? batch_count() - 1 : SIZE_MAX;
+
+            m_contacts.resize(total);
+            for (size_t i = 0; i < count; i++)
+                if (colors[i] != UINT8_MAX)
+                    m_contacts[offset[colors[i]]++] = contacts[i];
+        }
+
+        /// @brief Run the solver over the prepared contacts
+        /// @param displacement Receives the x, y, z displacement of each body, 3 * body_count floats
+        /// @param pool Pool to solve batches on, or nullptr to solve on the calling thread
+        void solve(float* displacement, ThreadPool* pool = nullptr) const
+        {
+            std::fill(displacement, displacement + 3 * m_inv_mass.size(), 0.0f);
+
+            for (int it = 0; it < settings.iterations; it++)
+            {
+                for (size_t k = 0; k < batch_count(); k++)
+                {
+                    const size_t first = m_batch_begin[k];
+                    auto run = [&](size_t begin, size_t end, size_t)
+                    {
+                        for (size_t i = first + begin; i < first + end; i++)
+                            solve_contact(m_contacts[i], displacement);
+                    };
+                    const size_t n = m_batch_begin[k + 1] - first;
+                    if (pool && k != m_serial_batch) pool->parallel_for(n, settings.chunk_size, run);
+                    else run(0, n, 0);
+                }
+            }
+        }
+
+        size_t batch_count() const { return m_batch_begin.empty() ? 0 : m_batch_begin.size() - 1; }
+        size_t contact_count() const { return m_contacts.size(); }
+
+        /// Contacts of batch k, in the order they were given
+        const SolverContact* batch(size_t k, size_t& count) const
+        {
+            count = m_batch_begin[k + 1] - m_batch_begin[k];
+            return m_contacts.data() + m_batch_begin[k];
+        }
+
+    private:
+        void solve_contact(const SolverContact& c, float* displacement) const
+        {
+            float* da = displacement + 3 * c.a;
+            float* db = displacement + 3 * c.b;
+            const float inv_a = m_inv_mass[c.a], inv_b = m_inv_mass[c.b];
+
+            // Penetration left after what the bodies have been moved so far
+            const float moved = c.normal[0] * (db[0] - da[0]) + c.normal[1] * (db[1] - da[1]) + c.normal[2] * (db[2] - da[2]);
+            const float remaining = c.depth - moved - settings.slop;
+            if (remaining <= 0.0f) return;
+
+            const float lambda = settings.relaxation * remaining / (inv_a + inv_b);
+            // Bodies that never move may be shared between contacts of a batch, so they are not written
+            if (inv_a > 0.0f)
+                for (int i = 0; i < 3; i++) da[i] -= c.normal[i] * lambda * inv_a;
+            if (inv_b > 0.0f)
+                for (int i = 0; i < 3; i++) db[i] += c.normal[i] * lambda * inv_b;
+        }
+
+        std::vector<SolverContact> m_contacts;  // Ordered by batch
+        std::vector<size_t> m_batch_begin;      // Start of each batch in m_contacts, plus the end
+        std::vector<float> m_inv_mass;
+        size_t m_serial_batch = SIZE_MAX;
+    };
+
+} // namespace eeng
+
+#endif
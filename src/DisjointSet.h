@@ -0,0 +1,68 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_DisjointSet_h
+#define EENG_DisjointSet_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+
+namespace eeng
+{
+    /// @brief Union-find over the indices [0, n), e.g. to group bodies in contact into islands
+    /** Uses union by size and path halving, so any sequence of operations runs in
+     * near-constant amortized time per operation.
+     */
+    class DisjointSet
+    {
+    public:
+        DisjointSet() = default;
+        explicit DisjointSet(size_t n) { reset(n); }
+
+        /// @brief Make n singleton sets
+        void reset(size_t n)
+        {
+            m_parent.resize(n);
+            std::iota(m_parent.begin(), m_parent.end(), uint32_t(0));
+            m_size.assign(n, 1);
+        }
+
+        /// @brief Representative of the set containing i
+        size_t find(size_t i)
+        {
+            while (m_parent[i] != i)
+            {
+                m_parent[i] = m_parent[m_parent[i]];
+                i = m_parent[i];
+            }
+            return i;
+        }
+
+        /// @brief Merge the sets containing a and b
+        /// @return False if they already were the same set
+        bool unite(size_t a, size_t b)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b) return false;
+            if (m_size[a] < m_size[b]) std::swap(a, b);
+            m_parent[b] = uint32_t(a);
+            m_size[a] += m_size[b];
+            return true;
+        }
+
+        /// @brief Nbr of elements in the set containing i
+        size_t set_size(size_t i) { return m_size[find(i)]; }
+
+        size_t size() const { return m_parent.size(); }
+
+    private:
+        std::vector<uint32_t> m_parent;
+        std::vector<uint32_t> m_size;
+    };
+
+} // namespace eeng
+
+#endif
@@ -10,6 +10,10 @@
 #include <SDL.h>
 #include <SDL_opengl.h>
 #include <memory>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <thread>
 
 #include "InputManager.hpp"
 #include "Log.hpp"
@@ -80,43 +84,131 @@ namespace eeng {
         return true;
     }
 
+    bool Engine::init_headless(uint64_t stepLimit, bool realtime)
+    {
+        headless = true;
+        headless_step_limit = stepLimit;
+        headless_realtime = realtime;
+
+        // Never fed with events, but the game's update takes one
+        input = std::make_shared<eeng::InputManager>();
+
+        eeng::Log("Engine initialized headless.");
+        return true;
+    }
+
     void Engine::run(std::unique_ptr<GameBase> game)
     {
+        game->headless = headless;
         game->init();
 
+        if (headless)
+        {
+            run_headless(*game);
+            game->destroy();
+            return;
+        }
+
         bool running = true;
-        float time_s = 0.0f, time_ms, deltaTime_s = 0.016f;
+        bool pipelined = false;                     // render() draws the previous frame while this frame updates
+        const double frequency = double(SDL_GetPerformanceFrequency());
+        Uint64 previous = SDL_GetPerformanceCounter();
+        double time_s = 0.0;                        // Game time at the last update
+        double accumulator_s = 1.0 / simulation_hz; // Game time not yet updated, one step so that the first frame updates
+        float render_time_s = 0.0f;                 // Time and alpha of the extracted frame
 
         eeng::Log("Entering main loop...");
         while (running)
         {
-            const auto now_ms = SDL_GetTicks();
-            const auto now_s = now_ms * 0.001f;
-            deltaTime_s = now_s - time_s;
-            time_ms = now_ms;
-            time_s = now_s;
+            const Uint64 frame_start = SDL_GetPerformanceCounter();
+            accumulator_s += double(frame_start - previous) / frequency;
+            previous = frame_start;
 
             process_events(running);
             begin_frame();
 
-            game->update(time_s, deltaTime_s, input);
-            game->render(time_s, window_width, window_height);
+            // Update in fixed steps for as long as game time lags behind
+            const double step_s = 1.0 / simulation_hz;
+            const double first_step_s = time_s;
+            frame_steps = 0;
+            while (accumulator_s >= step_s && frame_steps < max_steps_per_frame)
+            {
+                time_s += step_s;
+                accumulator_s -= step_s;
+                frame_steps++;
+            }
+            // Drop whole steps that did not fit in this frame
+            if (accumulator_s >= step_s)
+                accumulator_s = std::fmod(accumulator_s, step_s);
+
+            const int steps = frame_steps;
+            auto run_updates = [&, steps]()
+            {
+                for (int i = 0; i < steps; i++)
+                    game->update(float(first_step_s + i * step_s), float(step_s), input);
+            };
+
+            if (pipelined)
+            {
+                // Submit the frame extracted last time while the game updates on
+                JobCounter updates;
+                update_thread.submit(run_updates, &updates);
+                game->render(render_time_s, frame_alpha, window_width, window_height);
+                update_thread.wait(updates);
+            }
+            else
+                run_updates();
+
+            frame_alpha = float(accumulator_s / step_s);
+            render_time_s = float(time_s + accumulator_s);
+            const bool extracted = game->extract(render_time_s, frame_alpha, window_width, window_height);
+            if (!pipelined)
+                game->render(render_time_s, frame_alpha, window_width, window_height);
+            pipelined = pipeline_updates && extracted;
 
             end_frame();
 
             SDL_GL_SwapWindow(window_);
 
             // Add a delay if frame time was shorter than the target frame time
-            const Uint32 elapsed_ms = SDL_GetTicks() - time_ms;
+            const double elapsed_ms = double(SDL_GetPerformanceCounter() - frame_start) * 1000.0 / frequency;
             if (elapsed_ms < min_frametime_ms)
-                SDL_Delay(min_frametime_ms - elapsed_ms);
+                SDL_Delay(Uint32(min_frametime_ms - elapsed_ms));
         }
 
         game->destroy();
     }
 
+    void Engine::run_headless(GameBase& game)
+    {
+        const double step_s = 1.0 / simulation_hz;
+        const auto start = std::chrono::steady_clock::now();
+
+        eeng::Log("Entering headless loop...");
+        uint64_t step = 0;
+        for (; headless_step_limit == 0 || step < headless_step_limit; step++)
+        {
+            if (headless_realtime)
+                std::this_thread::sleep_until(start + std::chrono::duration<double>(step * step_s));
+            game.update(float(step * step_s), float(step_s), input);
+        }
+
+        const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        eeng::Log("%llu updates (%.1f s of game time) in %.2f s, %.0f updates/s",
+            (unsigned long long)step, step * step_s, elapsed_s, elapsed_s > 0.0 ? step / elapsed_s : 0.0);
+    }
+
+    void Engine::set_simulation_rate(float hz, int maxStepsPerFrame)
+    {
+        simulation_hz = std::max(hz, 1.0f);
+        max_steps_per_frame = std::max(maxStepsPerFrame, 1);
+    }
+
     void Engine::shutdown()
     {
+        if (headless)
+            return;
+
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplSDL2_Shutdown();
         ImGui::DestroyContext();
@@ -333,6 +425,12 @@ namespace eeng {
             else if (currentItem == 4)
                 min_frametime_ms = 0.0f;
 
+            // Fixed update step
+            ImGui::SliderFloat("Update rate (Hz)", &simulation_hz, 10.0f, 240.0f, "%.0f");
+            ImGui::SliderInt("Max updates per frame", &max_steps_per_frame, 1, 10);
+            ImGui::Text("%i updates this frame, alpha %.2f", frame_steps, frame_alpha);
+            ImGui::Checkbox("Update while rendering", &pipeline_updates);
+
             if (ImGui::Checkbox("V-Sync", &vsync))
             {
                 SDL_GL_SetSwapInterval(vsync);
@@ -6,8 +6,10 @@
 
 #include <iostream>
 #include <memory>
+#include <cstdint>
 #include "config.h"
 #include "GameBase.h"
+#include "ThreadPool.hpp"
 
 struct SDL_Window;              // Forward declaration
 typedef void* SDL_GLContext;    // Forward declaration
@@ -37,12 +39,33 @@ public:
      */
     bool init(const char* title, int width, int height);
 
+    /**
+     * @brief Initialize the engine without SDL video, a GL context or ImGui, e.g. for simulation servers and CI.
+     *
+     * run() then only updates the game at the fixed rate, without input; nothing is extracted or rendered.
+     * @param stepLimit Updates to run before run() returns, 0 to run until the process is stopped
+     * @param realtime Pace the updates to the simulation rate. Otherwise they run back to back, as fast as possible.
+     * @return True if successful, false otherwise
+     */
+    bool init_headless(uint64_t stepLimit = 0, bool realtime = false);
+
+    /** @brief True if initialized with init_headless(). */
+    bool is_headless() const { return headless; }
+
     /**
      * @brief Start the main loop.
      * @param game Unique pointer to the initial game game
      */
     void run(std::unique_ptr<GameBase> game);
 
+    /**
+     * @brief Set the rate of the fixed update step.
+     * @param hz Updates per second of game time
+     * @param maxStepsPerFrame Most updates run in one frame. Time that would take more is dropped, so a slow
+     *        frame slows the game down instead of making the next frame slower still.
+     */
+    void set_simulation_rate(float hz, int maxStepsPerFrame = 5);
+
     /** @brief Clean up and close the engine. */
     void shutdown();
 
@@ -62,6 +85,15 @@ private:
     bool vsync = false;   ///< V-sync enabled state
     bool wireframe_mode = false; ///< Wireframe rendering state
     float min_frametime_ms = 16.67; ///< Minimum frame duration in milliseconds (default 60 FPS)
+    bool pipeline_updates = true; ///< Update the next frame while rendering this one, for games that extract
+    ThreadPool update_thread{ 1 }; ///< Runs the updates of a frame while the main thread renders the previous one
+    float simulation_hz = 60.0f;  ///< Rate of the fixed update step
+    int max_steps_per_frame = 5;  ///< Most updates per frame, see set_simulation_rate()
+    int frame_steps = 0;          ///< Updates run in the last frame
+    float frame_alpha = 0.0f;     ///< Interpolation fraction passed to the last render
+    bool headless = false;        ///< No window, GL context or ImGui, see init_headless()
+    uint64_t headless_step_limit = 0; ///< Updates run() runs when headless, 0 for no limit
+    bool headless_realtime = false;   ///< Pace headless updates to the simulation rate
 
     /** Initialize SDL library and window. */
     bool init_sdl(const char* title, int width, int height);
@@ -72,6 +104,9 @@ private:
     /** Initialize ImGui for GUI rendering. */
     bool init_imgui();
 
+    /** Update the game in fixed steps until the step limit, without events or rendering. */
+    void run_headless(GameBase& game);
+
     /** Handle SDL events. */
     void process_events(bool& running);
 
@@ -141,24 +141,43 @@ namespace eeng
     void ForwardRenderer::renderMesh(const std::shared_ptr<RenderableMesh> mesh,
                                      const glm::mat4 &WorldMatrix)
     {
+        renderMesh(*mesh, WorldMatrix, mesh->boneMatrices, nullptr);
+    }
+
+    void ForwardRenderer::renderMesh(RenderableMesh &mesh,
+                                     const glm::mat4 &WorldMatrix,
+                                     const RenderableMesh::Pose &pose)
+    {
+        renderMesh(mesh, WorldMatrix, pose.boneMatrices, pose.meshMatrices.data());
+    }
+
+    void ForwardRenderer::renderMesh(RenderableMesh &mesh,
+                                     const glm::mat4 &WorldMatrix,
+                                     const std::vector<glm::mat4> &boneMatrices,
+                                     const glm::mat4 *meshMatrices)
+    {
+        // Loaded without GL objects
+        if (!mesh.m_VAO)
+            return;
+
         // Bind bone matrices
-        if (mesh->boneMatrices.size())
+        if (boneMatrices.size())
             glUniformMatrix4fv(glGetUniformLocation(phongShader, "BoneMatrices"),
-                               (GLsizei)mesh->boneMatrices.size(),
+                               (GLsizei)boneMatrices.size(),
                                0,
-                               glm::value_ptr(mesh->boneMatrices[0]));
+                               glm::value_ptr(boneMatrices[0]));
 
-        glBindVertexArray(mesh->m_VAO);
+        glBindVertexArray(mesh.m_VAO);
 
-        for (uint i = 0; i < mesh->m_meshes.size(); i++)
+        for (uint i = 0; i < mesh.m_meshes.size(); i++)
         {
-            const auto &submesh = mesh->m_meshes[i];
-            const auto &mtl = mesh->m_materials[submesh.mtl_index];
+            const auto &submesh = mesh.m_meshes[i];
+            const auto &mtl = mesh.m_materials[submesh.mtl_index];
 
             if (submesh.node_index != EENG_NULL_INDEX && !submesh.is_skinned)
             {
                 // Append hierarchical transform to non-skinned meshes that are linked to nodes
-                const auto WorldMeshMatrix = WorldMatrix * mesh->m_nodetree.get_payload_at(submesh.node_index).global_tfm;
+                const auto WorldMeshMatrix = WorldMatrix * (meshMatrices ? meshMatrices[i] : mesh.m_nodetree.get_payload_at(submesh.node_index).global_tfm);
                 glUniformMatrix4fv(glGetUniformLocation(phongShader, "WorldMatrix"), 1, 0, glm::value_ptr(WorldMeshMatrix));
             }
             else
@@ -188,7 +207,7 @@ namespace eeng
                 if (hasTexture)
                 {
                     glActiveTexture(GL_TEXTURE0 + textureDesc.textureUnit);
-                    glBindTexture(GL_TEXTURE_2D, mesh->m_textures[textureIndex].getHandle());
+                    glBindTexture(GL_TEXTURE_2D, mesh.m_textures[textureIndex].getHandle());
                 }
                 glUniform1i(glGetUniformLocation(phongShader, textureDesc.flagName), hasTexture);
             }
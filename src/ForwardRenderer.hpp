@@ -73,6 +73,20 @@ namespace eeng
         /// @param WorldMatrix Instance world transform
         void renderMesh(const std::shared_ptr<RenderableMesh> mesh,
                         const glm::mat4 &WorldMatrix);
+
+        /// @brief Render an instance of a mesh in a pose copied from it earlier
+        /// @param mesh Mesh to render
+        /// @param WorldMatrix Instance world transform
+        /// @param pose Pose from RenderableMesh::getPose(), used instead of the current pose of the mesh
+        void renderMesh(RenderableMesh &mesh,
+                        const glm::mat4 &WorldMatrix,
+                        const RenderableMesh::Pose &pose);
+
+    private:
+        void renderMesh(RenderableMesh &mesh,
+                        const glm::mat4 &WorldMatrix,
+                        const std::vector<glm::mat4> &boneMatrices,
+                        const glm::mat4 *meshMatrices);
     };
 
 using ForwardRendererPtr = std::shared_ptr<ForwardRenderer>;
@@ -31,10 +31,10 @@ public:
     /**
      * @brief Update the game state.
      *
-     * Processes game logic and user input.
+     * Processes game logic and user input. Called zero or more times per frame, with a fixed step.
      *
-     * @param time_s The current time in seconds.
-     * @param deltaTime_s The time elapsed in seconds since the last update.
+     * @param time_s The current simulation time in seconds.
+     * @param deltaTime_s The fixed time step in seconds.
      * @param input Pointer to the input manager handling user input.
      */
     virtual void update(
@@ -42,17 +42,41 @@ public:
         float deltaTime_s,
         InputManagerPtr input) = 0;
 
+    /**
+     * @brief Copy what rendering needs out of the game state.
+     *
+     * Called on the main thread once per frame, after the frame's updates and before render(),
+     * and never while update() runs. GUI elements that show or edit game state belong here too.
+     * A game whose render() reads nothing but the copy made here returns true, which lets the
+     * engine run the updates of the next frame on another thread while render() submits this one.
+     *
+     * @param time_s The current time in seconds.
+     * @param alpha Time since the last update, as a fraction of the update step, in [0, 1).
+     * @param windowWidth The width of the window in pixels.
+     * @param windowHeight The height of the window in pixels.
+     * @return true if render() reads only the copy, false (the default) to update and render in turn.
+     */
+    virtual bool extract(
+        float time_s,
+        float alpha,
+        int windowWidth,
+        int windowHeight) { return false; }
+
     /**
      * @brief Render the game game.
      *
-     * Renders the game visuals on the screen.
+     * Renders the game visuals on the screen. The game is updated in fixed steps, so a frame
+     * usually falls between two of them; alpha tells how far, for moving things to be drawn
+     * in between their last two simulated states.
      *
      * @param time_s The current time in seconds.
+     * @param alpha Time since the last update, as a fraction of the update step, in [0, 1).
      * @param screenWidth The width of the screen in pixels.
      * @param screenHeight The height of the screen in pixels.
      */
     virtual void render(
         float time_s,
+        float alpha,
         int windowWidth,
         int windowHeight) = 0;
 
@@ -67,6 +91,18 @@ public:
      * @brief Virtual destructor.
      */
     virtual ~GameBase() noexcept = default;
+
+    /**
+     * @brief True if the engine runs without a window, GL context or ImGui.
+     *
+     * Known from init() on. A headless game only loads what its updates need, e.g. meshes without
+     * GL objects, and is updated at the fixed rate without input. extract() and render() are never called.
+     */
+    bool is_headless() const { return headless; }
+
+private:
+    friend class Engine;
+    bool headless = false;
 };
 
 } // namespace eeng
@@ -0,0 +1,187 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_Heightfield_h
+#define EENG_Heightfield_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+namespace eeng
+{
+    /// @brief Regular grid of heights over the xz-plane
+    /** Heights are sampled at the grid points origin + (column, row) * cell_size and
+     * interpolated bilinearly in between, so a height or normal lookup reads the four
+     * surrounding samples and nothing else. Positions outside the grid are clamped to its edge.
+     *
+     * The terrain is taken to be solid below the surface: rays that start below it hit at once.
+     * Height and normal lookups require a grid of at least 2 x 2 samples.
+     */
+    class Heightfield
+    {
+    public:
+        /// @brief Build from row-major heights, columns samples along x per row, rows along z
+        void build(const float* heights, size_t columns, size_t rows, float origin_x, float origin_z, float cell_size)
+        {
+            m_heights.assign(heights, heights + columns * rows);
+            m_columns = columns;
+            m_rows = rows;
+            m_origin[0] = origin_x;
+            m_origin[1] = origin_z;
+            m_cell_size = cell_size;
+            m_inv_cell_size = 1.0f / cell_size;
+            m_min_height = m_heights.empty() ? 0.0f : *std::min_element(m_heights.begin(), m_heights.end());
+            m_max_height = m_heights.empty() ? 0.0f : *std::max_element(m_heights.begin(), m_heights.end());
+        }
+
+        /// @brief Build from 8-bit image pixels, e.g. as decoded by stb_image. The first channel maps [0, 255] to [min_height, max_height].
+        void build_from_image(const uint8_t* pixels, size_t width, size_t height, size_t channels,
+            float origin_x, float origin_z, float cell_size, float min_height, float max_height)
+        {
+            std::vector<float> heights(width * height);
+            for (size_t i = 0; i < heights.size(); i++)
+                heights[i] = min_height + (max_height - min_height) * (pixels[i * channels] / 255.0f);
+            build(heights.data(), width, height, origin_x, origin_z, cell_size);
+        }
+
+        bool empty() const { return m_columns < 2 || m_rows < 2; }
+        size_t columns() const { return m_columns; }
+        size_t rows() const { return m_rows; }
+        float cell_size() const { return m_cell_size; }
+        float sample(size_t column, size_t row) const { return m_heights[row * m_columns + column]; }
+
+        /// @brief Bounds of the grid and of its heights
+        void bounds(float out_min[3], float out_max[3]) const
+        {
+            out_min[0] = m_origin[0];
+            out_min[1] = m_min_height;
+            out_min[2] = m_origin[1];
+            out_max[0] = m_origin[0] + (m_columns - 1) * m_cell_size;
+            out_max[1] = m_max_height;
+            out_max[2] = m_origin[1] + (m_rows - 1) * m_cell_size;
+        }
+
+        /// @brief True if (x, z) lies over the grid
+        bool contains(float x, float z) const
+        {
+            const float fx = (x - m_origin[0]) * m_inv_cell_size, fz = (z - m_origin[1]) * m_inv_cell_size;
+            return !empty() && fx >= 0.0f && fz >= 0.0f && fx <= float(m_columns - 1) && fz <= float(m_rows - 1);
+        }
+
+        /// @brief Bilinear height at (x, z)
+        float height(float x, float z) const
+        {
+            const Cell c = cell(x, z);
+            const float h0 = c.h00 + (c.h10 - c.h00) * c.u;
+            const float h1 = c.h01 + (c.h11 - c.h01) * c.u;
+            return h0 + (h1 - h0) * c.v;
+        }
+
+        /// @brief Unit normal of the bilinear surface at (x, z)
+        void normal(float x, float z, float n[3]) const
+        {
+            const Cell c = cell(x, z);
+            const float dx = ((c.h10 - c.h00) * (1.0f - c.v) + (c.h11 - c.h01) * c.v) * m_inv_cell_size;
+            const float dz = ((c.h01 - c.h00) * (1.0f - c.u) + (c.h11 - c.h10) * c.u) * m_inv_cell_size;
+            const float inv_len = 1.0f / std::sqrt(dx * dx + 1.0f + dz * dz);
+            n[0] = -dx * inv_len;
+            n[1] = inv_len;
+            n[2] = -dz * inv_len;
+        }
+
+        /// @brief Heights at count positions given as separate x and z arrays
+        void heights(const float* x, const float* z, size_t count, float* out) const
+        {
+            for (size_t i = 0; i < count; i++) out[i] = height(x[i], z[i]);
+        }
+
+        /// @brief First hit of a ray with the surface within [0, t_max], by marching in steps of
+        /// half a cell and refining the crossing by bisection
+        bool raycast(const float o[3], const float d[3], float t_max, float& t_hit) const
+        {
+            if (empty()) return false;
+
+            // Clip the ray to the box of the heightfield
+            float bmin[3], bmax[3];
+            bounds(bmin, bmax);
+            float t0 = 0.0f, t1 = t_max;
+            for (int a = 0; a < 3; a++)
+            {
+                if (std::abs(d[a]) < 1e-12f)
+                {
+                    if (o[a] < bmin[a] || o[a] > bmax[a]) return false;
+                    continue;
+                }
+                const float inv = 1.0f / d[a];
+                float ta = (bmin[a] - o[a]) * inv, tb = (bmax[a] - o[a]) * inv;
+                if (ta > tb) std::swap(ta, tb);
+                t0 = std::max(t0, ta);
+                t1 = std::min(t1, tb);
+            }
+            if (t0 > t1) return false;
+
+            auto above = [&](float t) { return o[1] + d[1] * t - height(o[0] + d[0] * t, o[2] + d[2] * t); };
+            float prev_t = t0;
+            float prev_f = above(t0);
+            if (prev_f <= 0.0f)
+            {
+                t_hit = t0;
+                return true;
+            }
+
+            // Steps short enough that the ray crosses at most about half a cell per step
+            const float horizontal = std::sqrt(d[0] * d[0] + d[2] * d[2]);
+            const float step = horizontal > 1e-6f ? 0.5f * m_cell_size / horizontal : t1 - t0;
+            while (prev_t < t1)
+            {
+                const float t = std::min(prev_t + step, t1);
+                const float f = above(t);
+                if (f <= 0.0f)
+                {
+                    float lo = prev_t, hi = t;
+                    for (int i = 0; i < RefineSteps; i++)
+                    {
+                        const float mid = 0.5f * (lo + hi);
+                        (above(mid) > 0.0f ? lo : hi) = mid;
+                    }
+                    t_hit = hi;
+                    return true;
+                }
+                prev_t = t;
+            }
+            return false;
+        }
+
+    private:
+        static constexpr int RefineSteps = 16;
+
+        struct Cell
+        {
+            float h00, h10, h01, h11;   // Corner heights, first index along x
+            float u, v;                 // Position within the cell, in [0, 1]
+        };
+
+        Cell cell(float x, float z) const
+        {
+            const float fx = std::clamp((x - m_origin[0]) * m_inv_cell_size, 0.0f, float(m_columns - 1));
+            const float fz = std::clamp((z - m_origin[1]) * m_inv_cell_size, 0.0f, float(m_rows - 1));
+            const size_t i = std::min(static_cast<size_t>(fx), m_columns - 2);
+            const size_t j = std::min(static_cast<size_t>(fz), m_rows - 2);
+            const float* row0 = &m_heights[j * m_columns + i];
+            const float* row1 = row0 + m_columns;
+            return { row0[0], row0[1], row1[0], row1[1], fx - float(i), fz - float(j) };
+        }
+
+        std::vector<float> m_heights;   // Row-major, rows along z
+        size_t m_columns = 0, m_rows = 0;
+        float m_origin[2]{};            // x and z of sample (0, 0)
+        float m_cell_size = 1.0f, m_inv_cell_size = 1.0f;
+        float m_min_height = 0.0f, m_max_height = 0.0f;
+    };
+
+} // namespace eeng
+
+#endif
@@ -3,10 +3,14 @@
 
 #include <iostream>
 #include <cstdarg>
+#include <mutex>
 #include "Log.hpp"
 #include "config.h"
 
 namespace {
+    // Log may be called from any thread, e.g. by an update running while the main thread renders
+    std::mutex logMutex;
+
     std::string formatString(const char* fmt, va_list args)
     {
         va_list args_copy;
@@ -31,19 +35,30 @@ void eeng::Log(const char* fmt, ...)
     std::string formattedString = formatString(fmt, args);
     va_end(args);
 
+    std::lock_guard<std::mutex> lock(logMutex);
 #ifdef EENG_PRINT_LOG_TO_COUT
     std::cout << formattedString << std::endl;
 #endif
+    // Headless, there is no ImGui context and no log window to show it in
+    if (!ImGui::GetCurrentContext())
+    {
+#ifndef EENG_PRINT_LOG_TO_COUT
+        std::cout << formattedString << std::endl;
+#endif
+        return;
+    }
     internal::LogSingleton::instance().AddLog("[frame#%i] %s\n", ImGui::GetFrameCount(), formattedString.c_str());
 }
 
 void eeng::LogDraw(const char* label, bool* p_open)
 {
+    std::lock_guard<std::mutex> lock(logMutex);
     internal::LogSingleton::instance().Draw(label, p_open);
 }
 
 void eeng::LogClear()
 {
+    std::lock_guard<std::mutex> lock(logMutex);
     internal::LogSingleton::instance().Clear();
 }
 
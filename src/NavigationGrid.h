@@ -0,0 +1,310 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_NavigationGrid_h
+#define EENG_NavigationGrid_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+namespace eeng
+{
+    /// @brief Walkable cells on a regular grid over the xz-plane, for pathfinding
+    /** Cell (column, row) covers origin + [column, column + 1) x [row, row + 1) times cell_size
+     * and is addressed by the index row * columns + column. Each cell stores whether agents may
+     * stand in it and the ground height at its center. Built once from the level geometry, e.g.
+     * when a level is loaded, and only read while searching.
+     */
+    class NavigationGrid
+    {
+    public:
+        static constexpr uint32_t InvalidCell = UINT32_MAX;
+
+        /// @brief Make an all-walkable grid at height 0
+        void build(size_t columns, size_t rows, float origin_x, float origin_z, float cell_size)
+        {
+            m_columns = columns;
+            m_rows = rows;
+            m_origin[0] = origin_x;
+            m_origin[1] = origin_z;
+            m_cell_size = cell_size;
+            m_inv_cell_size = 1.0f / cell_size;
+            m_walkable.assign(columns * rows, 1);
+            m_height.assign(columns * rows, 0.0f);
+        }
+
+        bool empty() const { return m_walkable.empty(); }
+        size_t columns() const { return m_columns; }
+        size_t rows() const { return m_rows; }
+        size_t cell_count() const { return m_walkable.size(); }
+        float cell_size() const { return m_cell_size; }
+
+        bool walkable(uint32_t cell) const { return m_walkable[cell] != 0; }
+        void set_walkable(uint32_t cell, bool walkable) { m_walkable[cell] = walkable; }
+        float height(uint32_t cell) const { return m_height[cell]; }
+        void set_height(uint32_t cell, float height) { m_height[cell] = height; }
+
+        uint32_t column(uint32_t cell) const { return uint32_t(cell % m_columns); }
+        uint32_t row(uint32_t cell) const { return uint32_t(cell / m_columns); }
+        uint32_t cell(uint32_t column, uint32_t row) const { return uint32_t(row * m_columns + column); }
+
+        /// @brief Cell containing (x, z), or InvalidCell outside the grid
+        uint32_t cell_at(float x, float z) const
+        {
+            const float fx = std::floor((x - m_origin[0]) * m_inv_cell_size);
+            const float fz = std::floor((z - m_origin[1]) * m_inv_cell_size);
+            if (fx < 0.0f || fz < 0.0f || fx >= float(m_columns) || fz >= float(m_rows)) return InvalidCell;
+            return cell(uint32_t(fx), uint32_t(fz));
+        }
+
+        /// @brief Center of a cell on the ground, as x, y, z
+        void center(uint32_t cell, float out[3]) const
+        {
+            out[0] = m_origin[0] + (column(cell) + 0.5f) * m_cell_size;
+            out[1] = m_height[cell];
+            out[2] = m_origin[1] + (row(cell) + 0.5f) * m_cell_size;
+        }
+
+        /// @brief Walkable cell nearest to cell within max_rings rings of cells around it, or InvalidCell
+        uint32_t nearest_walkable(uint32_t cell, int max_rings) const
+        {
+            if (cell == InvalidCell) return InvalidCell;
+            if (walkable(cell)) return cell;
+            const int c0 = int(column(cell)), r0 = int(row(cell));
+            for (int ring = 1; ring <= max_rings; ring++)
+            {
+                uint32_t best = InvalidCell;
+                int best_d2 = INT32_MAX;
+                for (int dr = -ring; dr <= ring; dr++)
+                    for (int dc = -ring; dc <= ring; dc++)
+                    {
+                        if (std::max(std::abs(dc), std::abs(dr)) != ring) continue;
+                        const int c = c0 + dc, r = r0 + dr;
+                        if (c < 0 || r < 0 || c >= int(m_columns) || r >= int(m_rows)) continue;
+                        const uint32_t n = this->cell(uint32_t(c), uint32_t(r));
+                        if (walkable(n) && dc * dc + dr * dr < best_d2)
+                        {
+                            best = n;
+                            best_d2 = dc * dc + dr * dr;
+                        }
+                    }
+                if (best != InvalidCell) return best;
+            }
+            return InvalidCell;
+        }
+
+        /// @brief True if the straight line between the centers of two cells crosses walkable cells only
+        /** Walks every cell the line touches, so a line passing exactly through a corner
+         * needs both cells beside the corner to be walkable.
+         */
+        bool line_walkable(uint32_t from, uint32_t to) const
+        {
+            int c = int(column(from)), r = int(row(from));
+            const int c1 = int(column(to)), r1 = int(row(to));
+            const int dc = std::abs(c1 - c), dr = std::abs(r1 - r);
+            const int sc = c1 > c ? 1 : -1, sr = r1 > r ? 1 : -1;
+            // Amanatides-Woo traversal from center to center, in units of half cells
+            int error = dc - dr;
+            for (int steps = dc + dr; ; steps--)
+            {
+                if (!walkable(cell(uint32_t(c), uint32_t(r)))) return false;
+                if (steps <= 0) return true;
+                if (error > 0)
+                {
+                    c += sc;
+                    error -= 2 * dr;
+                }
+                else if (error < 0)
+                {
+                    r += sr;
+                    error += 2 * dc;
+                }
+                else
+                {
+                    // Through a corner: both neighbors must be open
+                    if (!walkable(cell(uint32_t(c + sc), uint32_t(r))) || !walkable(cell(uint32_t(c), uint32_t(r + sr))))
+                        return false;
+                    c += sc;
+                    r += sr;
+                    error += 2 * (dc - dr);
+                    steps--;
+                }
+            }
+        }
+
+        /// @brief Memory held by the grid, in bytes
+        size_t memory_usage() const
+        {
+            return m_walkable.capacity() * sizeof(uint8_t) + m_height.capacity() * sizeof(float);
+        }
+
+    private:
+        std::vector<uint8_t> m_walkable;
+        std::vector<float> m_height;
+        size_t m_columns = 0, m_rows = 0;
+        float m_origin[2]{};
+        float m_cell_size = 1.0f, m_inv_cell_size = 1.0f;
+    };
+
+    /// @brief A* over the 8-connected cells of a NavigationGrid that can be run a slice at a time
+    /** Diagonal moves cost sqrt(2) and may not cut the corner of a blocked cell. The octile
+     * distance is the heuristic, which is exact on an empty grid, so found paths are shortest.
+     * Per-cell state is stamped with a search number instead of being cleared, which makes
+     * starting a search cost nothing in the size of the grid.
+     */
+    class GridSearch
+    {
+    public:
+        enum class Status { Idle, Running, Found, NoPath };
+
+        /// @brief Start a search. The grid must outlive it and stay unchanged until it ends.
+        void begin(const NavigationGrid& grid, uint32_t start, uint32_t goal)
+        {
+            m_grid = &grid;
+            m_goal = goal;
+            m_expanded = 0;
+            m_open.clear();
+            if (m_g.size() != grid.cell_count())
+            {
+                m_g.assign(grid.cell_count(), 0.0f);
+                m_parent.assign(grid.cell_count(), NavigationGrid::InvalidCell);
+                m_stamp.assign(grid.cell_count(), 0);
+                m_search = 0;
+            }
+            // Stamps: 2 * search for open cells, 2 * search + 1 for closed ones
+            m_search++;
+
+            if (start == NavigationGrid::InvalidCell || goal == NavigationGrid::InvalidCell || !grid.walkable(start) || !grid.walkable(goal))
+            {
+                m_status = Status::NoPath;
+                return;
+            }
+            m_start = start;
+            m_g[start] = 0.0f;
+            m_parent[start] = NavigationGrid::InvalidCell;
+            m_stamp[start] = 2 * m_search;
+            push(start, heuristic(start));
+            m_status = Status::Running;
+        }
+
+        /// @brief Expand up to max_expansions cells
+        /// @return Status after the slice
+        Status step(size_t max_expansions)
+        {
+            const NavigationGrid& grid = *m_grid;
+            const int columns = int(grid.columns()), rows = int(grid.rows());
+            for (size_t n = 0; m_status == Status::Running && n < max_expansions; n++)
+            {
+                if (m_open.empty())
+                {
+                    m_status = Status::NoPath;
+                    break;
+                }
+                std::pop_heap(m_open.begin(), m_open.end(), OpenOrder{});
+                const uint32_t current = m_open.back().cell;
+                m_open.pop_back();
+                // Stale entries of cells reached more cheaply later
+                if (m_stamp[current] == 2 * m_search + 1) continue;
+                m_stamp[current] = 2 * m_search + 1;
+                m_expanded++;
+                if (current == m_goal)
+                {
+                    m_status = Status::Found;
+                    break;
+                }
+
+                const int c = int(grid.column(current)), r = int(grid.row(current));
+                for (int dr = -1; dr <= 1; dr++)
+                    for (int dc = -1; dc <= 1; dc++)
+                    {
+                        if (!dc && !dr) continue;
+                        const int nc = c + dc, nr = r + dr;
+                        if (nc < 0 || nr < 0 || nc >= columns || nr >= rows) continue;
+                        const uint32_t next = grid.cell(uint32_t(nc), uint32_t(nr));
+                        if (!grid.walkable(next) || m_stamp[next] == 2 * m_search + 1) continue;
+                        if (dc && dr && (!grid.walkable(grid.cell(uint32_t(nc), uint32_t(r))) || !grid.walkable(grid.cell(uint32_t(c), uint32_t(nr)))))
+                            continue;
+
+                        const float g = m_g[current] + (dc && dr ? DiagonalCost : 1.0f);
+                        if (m_stamp[next] == 2 * m_search && g >= m_g[next]) continue;
+                        m_stamp[next] = 2 * m_search;
+                        m_g[next] = g;
+                        m_parent[next] = current;
+                        push(next, g + heuristic(next));
+                    }
+            }
+            return m_status;
+        }
+
+        Status status() const { return m_status; }
+        /// Cells expanded by the current search so far
+        size_t expanded() const { return m_expanded; }
+
+        /// @brief Cells of the found path from start to goal
+        void path(std::vector<uint32_t>& cells) const
+        {
+            cells.clear();
+            if (m_status != Status::Found) return;
+            for (uint32_t c = m_goal; c != NavigationGrid::InvalidCell; c = m_parent[c])
+                cells.push_back(c);
+            std::reverse(cells.begin(), cells.end());
+        }
+
+    private:
+        static constexpr float DiagonalCost = 1.41421356f;
+
+        struct OpenEntry
+        {
+            float f;
+            uint32_t cell;
+        };
+        struct OpenOrder
+        {
+            bool operator()(const OpenEntry& a, const OpenEntry& b) const { return a.f > b.f; }
+        };
+
+        void push(uint32_t cell, float f)
+        {
+            m_open.push_back({ f, cell });
+            std::push_heap(m_open.begin(), m_open.end(), OpenOrder{});
+        }
+
+        float heuristic(uint32_t cell) const
+        {
+            const float dc = std::abs(float(m_grid->column(cell)) - float(m_grid->column(m_goal)));
+            const float dr = std::abs(float(m_grid->row(cell)) - float(m_grid->row(m_goal)));
+            return std::max(dc, dr) + (DiagonalCost - 1.0f) * std::min(dc, dr);
+        }
+
+        const NavigationGrid* m_grid = nullptr;
+        uint32_t m_start = NavigationGrid::InvalidCell, m_goal = NavigationGrid::InvalidCell;
+        Status m_status = Status::Idle;
+        size_t m_expanded = 0;
+        std::vector<OpenEntry> m_open;      // Binary heap on f, may hold stale entries
+        std::vector<float> m_g;             // Cost from the start, valid where stamped
+        std::vector<uint32_t> m_parent;
+        std::vector<uint32_t> m_stamp;
+        uint32_t m_search = 0;
+    };
+
+    /// @brief Drop the cells of a grid path that the straight line between their neighbors makes unnecessary
+    inline void smooth_path(const NavigationGrid& grid, std::vector<uint32_t>& cells)
+    {
+        if (cells.size() < 3) return;
+        size_t kept = 1;
+        size_t anchor = 0;
+        for (size_t i = 2; i < cells.size(); i++)
+        {
+            if (grid.line_walkable(cells[anchor], cells[i])) continue;
+            anchor = i - 1;
+            cells[kept++] = cells[anchor];
+        }
+        cells[kept++] = cells.back();
+        cells.resize(kept);
+    }
+
+} // namespace eeng
+
+#endif
@@ -0,0 +1,204 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#include <algorithm>
+#include "PathfindingService.hpp"
+
+namespace eeng
+{
+    namespace
+    {
+        // Rings of cells searched for a walkable cell around a blocked start or goal
+        constexpr int SnapRings = 4;
+        // Cells expanded between two looks at the budget
+        constexpr size_t SliceSize = 256;
+    }
+
+    PathfindingService::PathfindingService()
+    {
+        worker = std::thread([this] { worker_loop(); });
+    }
+
+    PathfindingService::~PathfindingService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    void PathfindingService::set_grid(std::shared_ptr<const NavigationGrid> grid)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->grid = std::move(grid);
+            gridChanged = true;
+        }
+        wake.notify_all();
+    }
+
+    uint64_t PathfindingService::request(uint32_t owner, const float start[3], const float goal[3])
+    {
+        Request request;
+        request.owner = owner;
+        std::copy(start, start + 3, request.start);
+        std::copy(goal, goal + 3, request.goal);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            request.ticket = nextTicket++;
+            pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const Request& r) { return r.owner == owner; }), pending.end());
+            pending.push_back(request);
+        }
+        wake.notify_all();
+        return request.ticket;
+    }
+
+    void PathfindingService::update(std::vector<Result>& results)
+    {
+        results.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.swap(completed);
+            budget = settings.expansions_per_frame;
+            cacheCapacity = settings.cache_capacity;
+        }
+        wake.notify_all();
+    }
+
+    PathfindingService::Stats PathfindingService::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats stats = counters;
+        stats.pending = pending.size() + (searching ? 1 : 0);
+        return stats;
+    }
+
+    void PathfindingService::worker_loop()
+    {
+        GridSearch search;
+        std::vector<uint32_t> cells;
+        for (;;)
+        {
+            Request request;
+            std::shared_ptr<const NavigationGrid> searchGrid;
+            size_t capacity;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || (!pending.empty() && grid); });
+                if (stopping) return;
+                request = pending.front();
+                pending.pop_front();
+                searchGrid = grid;
+                searching = true;
+                capacity = cacheCapacity;
+                if (gridChanged)
+                {
+                    cache.clear();
+                    cacheOrder.clear();
+                    gridChanged = false;
+                }
+            }
+
+            const NavigationGrid& g = *searchGrid;
+            const uint32_t start = g.nearest_walkable(g.cell_at(request.start[0], request.start[2]), SnapRings);
+            const uint32_t goal = g.nearest_walkable(g.cell_at(request.goal[0], request.goal[2]), SnapRings);
+            const uint64_t key = (uint64_t(start) << 32) | goal;
+            const bool valid = start != NavigationGrid::InvalidCell && goal != NavigationGrid::InvalidCell;
+
+            Result result;
+            result.cached = valid && lookup_cache(key, cells);
+            size_t expanded = 0;
+            if (!result.cached)
+            {
+                search.begin(g, start, goal);
+                while (search.status() == GridSearch::Status::Running)
+                {
+                    size_t slice;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wake.wait(lock, [this] { return stopping || budget > 0; });
+                        if (stopping) return;
+                        slice = std::min(budget, SliceSize);
+                        budget -= slice;
+                    }
+                    const size_t before = search.expanded();
+                    search.step(slice);
+                    const size_t used = search.expanded() - before;
+                    expanded += used;
+
+                    // Hand back what the search did not need
+                    std::lock_guard<std::mutex> lock(mutex);
+                    budget += slice - std::min(slice, used);
+                }
+                search.path(cells);
+                if (!cells.empty())
+                {
+                    smooth_path(g, cells);
+                    store_cache(key, cells, capacity);
+                }
+            }
+            make_result(g, request, cells, result);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (result.cached) counters.cache_hits++;
+                else counters.searches++;
+                counters.expanded += expanded;
+                completed.push_back(std::move(result));
+                searching = false;
+            }
+        }
+    }
+
+    bool PathfindingService::lookup_cache(uint64_t key, std::vector<uint32_t>& cells)
+    {
+        auto it = cache.find(key);
+        if (it == cache.end()) return false;
+        cacheOrder.splice(cacheOrder.begin(), cacheOrder, it->second);
+        cells = it->second->second;
+        return true;
+    }
+
+    void PathfindingService::store_cache(uint64_t key, const std::vector<uint32_t>& cells, size_t capacity)
+    {
+        if (capacity == 0) return;
+        while (cache.size() >= capacity)
+        {
+            cache.erase(cacheOrder.back().first);
+            cacheOrder.pop_back();
+        }
+        cacheOrder.emplace_front(key, cells);
+        cache[key] = cacheOrder.begin();
+    }
+
+    void PathfindingService::make_result(const NavigationGrid& grid, const Request& request, const std::vector<uint32_t>& cells, Result& result) const
+    {
+        result.ticket = request.ticket;
+        result.owner = request.owner;
+        result.found = !cells.empty();
+        result.path.clear();
+        // The first cell is where the agent already is
+        for (size_t i = 1; i < cells.size(); i++)
+        {
+            float p[3];
+            grid.center(cells[i], p);
+            result.path.insert(result.path.end(), p, p + 3);
+        }
+        if (!result.found) return;
+
+        // End on the goal itself rather than on the center of its cell, unless the goal had to be moved
+        if (grid.cell_at(request.goal[0], request.goal[2]) == cells.back())
+        {
+            if (cells.size() == 1)
+            {
+                float p[3];
+                grid.center(cells.back(), p);
+                result.path.insert(result.path.end(), p, p + 3);
+            }
+            result.path[result.path.size() - 3] = request.goal[0];
+            result.path[result.path.size() - 1] = request.goal[2];
+        }
+    }
+
+} // namespace eeng
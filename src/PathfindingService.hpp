@@ -0,0 +1,112 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_PathfindingService_hpp
+#define EENG_PathfindingService_hpp
+
+#include <vector>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include "NavigationGrid.h"
+
+namespace eeng
+{
+    /// @brief Finds paths on a NavigationGrid on a worker thread, a budget of work per frame
+    /** Requests are queued and searched one at a time, first come first served, with A*. The
+     * worker expands at most Settings::expansions_per_frame cells between two calls to update(),
+     * so a long search is spread over several frames instead of competing with the frame for
+     * CPU, and the calling thread never waits for a search. Found paths are smoothed and cached
+     * by their start and goal cells, so agents that ask for the same trip share one search.
+     */
+    class PathfindingService
+    {
+    public:
+        struct Settings
+        {
+            size_t expansions_per_frame = 4096;     ///< Cells the worker may expand between two updates
+            size_t cache_capacity = 256;            ///< Paths kept, least recently used ones are dropped first
+        };
+
+        struct Result
+        {
+            uint64_t ticket = 0;        ///< As returned by request()
+            uint32_t owner = 0;         ///< As passed to request()
+            bool found = false;
+            bool cached = false;        ///< Served from the path cache
+            std::vector<float> path;    ///< x, y, z of each waypoint after the start, ending at the goal
+        };
+
+        struct Stats
+        {
+            size_t pending = 0;         ///< Requests waiting for or in search
+            size_t searches = 0;        ///< Searches run
+            size_t cache_hits = 0;
+            size_t expanded = 0;        ///< Cells expanded by all searches
+        };
+
+        PathfindingService();
+        ~PathfindingService();
+
+        PathfindingService(const PathfindingService&) = delete;
+        PathfindingService& operator=(const PathfindingService&) = delete;
+
+        /// @brief Search on this grid from now on. Drops the path cache. Searches already running finish on the old grid.
+        void set_grid(std::shared_ptr<const NavigationGrid> grid);
+
+        /// @brief Queue a path request. Replaces any request of the same owner that has not started yet.
+        /// Start and goal are moved to the nearest walkable cell if they are on a blocked one.
+        /// @return Ticket that the result will carry
+        uint64_t request(uint32_t owner, const float start[3], const float goal[3]);
+
+        /// @brief Call once per frame: hands over the results completed since the last call and gives
+        /// the worker a new budget
+        void update(std::vector<Result>& results);
+
+        Stats stats() const;
+
+        Settings settings;
+
+    private:
+        struct Request
+        {
+            uint64_t ticket;
+            uint32_t owner;
+            float start[3], goal[3];
+        };
+
+        void worker_loop();
+        bool lookup_cache(uint64_t key, std::vector<uint32_t>& cells);
+        void store_cache(uint64_t key, const std::vector<uint32_t>& cells, size_t capacity);
+        void make_result(const NavigationGrid& grid, const Request& request, const std::vector<uint32_t>& cells, Result& result) const;
+
+        std::thread worker;
+        mutable std::mutex mutex;
+        std::condition_variable wake;
+
+        // Shared with the worker, under the mutex
+        std::shared_ptr<const NavigationGrid> grid;
+        std::deque<Request> pending;
+        std::vector<Result> completed;
+        size_t budget = 0;
+        size_t cacheCapacity = 256;
+        bool gridChanged = false;
+        bool searching = false;
+        bool stopping = false;
+        uint64_t nextTicket = 1;
+        Stats counters;
+
+        // Worker only
+        using CacheList = std::list<std::pair<uint64_t, std::vector<uint32_t>>>;
+        CacheList cacheOrder;                                           // Most recently used first
+        std::unordered_map<uint64_t, CacheList::iterator> cache;
+    };
+
+} // namespace eeng
+
+#endif
@@ -200,11 +200,16 @@ namespace eeng
             return;
         }
 
-        glGenVertexArrays(1, &m_VAO);
-        glBindVertexArray(m_VAO);
-        glGenBuffers(numelem(m_Buffers), m_Buffers);
-        loadScene(aiscene, filepath);
-        glBindVertexArray(0);
+        if (m_cpu_only)
+            loadScene(aiscene, filepath);
+        else
+        {
+            glGenVertexArrays(1, &m_VAO);
+            glBindVertexArray(m_VAO);
+            glGenBuffers(numelem(m_Buffers), m_Buffers);
+            loadScene(aiscene, filepath);
+            glBindVertexArray(0);
+        }
 
         loadNodes(aiscene->mRootNode);
 
@@ -362,6 +367,14 @@ namespace eeng
         }
 
 #endif
+        // Without GL, materials and vertex buffers are skipped
+        if (m_cpu_only)
+        {
+            m_positions = std::move(scene_positions);
+            m_indices = std::move(scene_indices);
+            return true;
+        }
+
         loadMaterials(aiscene, filename);
 
         // Load GL buffers
@@ -409,6 +422,10 @@ namespace eeng
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[IndexBuffer]);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(scene_indices[0]) * scene_indices.size(), &scene_indices[0], GL_STATIC_DRAW);
 
+        // Keep positions and indices on the CPU, e.g. for building collision meshes
+        m_positions = std::move(scene_positions);
+        m_indices = std::move(scene_indices);
+
         CheckAndThrowGLErrors();
         return true;
     }
@@ -1035,6 +1052,20 @@ namespace eeng
         return M;
     }
 
+    void RenderableMesh::getPose(Pose& pose) const
+    {
+        pose.boneMatrices.assign(boneMatrices.begin(), boneMatrices.end());
+        pose.meshMatrices.resize(m_meshes.size());
+        for (size_t i = 0; i < m_meshes.size(); i++)
+        {
+            const auto& submesh = m_meshes[i];
+            if (submesh.node_index != EENG_NULL_INDEX && !submesh.is_skinned)
+                pose.meshMatrices[i] = m_nodetree.get_payload_at(submesh.node_index).global_tfm;
+            else
+                pose.meshMatrices[i] = glm::mat4(1.0f);
+        }
+    }
+
     void RenderableMesh::animate(
         int anim_index,
         float time,
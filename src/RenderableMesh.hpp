@@ -160,6 +160,7 @@ namespace eeng
         };
 
         GLuint m_VAO = 0;
+        bool m_cpu_only = false;
         GLuint m_Buffers[BufferCount] = { 0 };
 
     public:
@@ -179,6 +180,10 @@ namespace eeng
         std::vector<AABB> m_mesh_aabbs_pose; // Per-mesh pose AABB's – intermediary, used for visualization
         AABB m_model_aabb;                   // AABB for the entire model
 
+        // Bind-pose geometry kept after upload. Indices are relative to each submesh's base_vertex.
+        std::vector<glm::vec3> m_positions;
+        std::vector<unsigned> m_indices;
+
     public:
         unsigned m_embedded_textures_ofs = 0;
 
@@ -198,6 +203,13 @@ namespace eeng
         ~RenderableMesh();
 
 
+        /// @brief Load CPU-side data only: skeleton, animation clips, bounds and bind-pose geometry
+        /// No GL objects or textures are created, so no GL context is needed, and rendering the mesh does nothing.
+        /// Set before load().
+        void setCpuOnly(bool cpuOnly) { m_cpu_only = cpuOnly; }
+
+        bool isCpuOnly() const { return m_cpu_only; }
+
         /// @brief 
         /// @param file 
         /// @param just_animations 
@@ -247,6 +259,18 @@ namespace eeng
             AnmationTimeFormat animTimeFormat0 = AnmationTimeFormat::RealTime,
             AnmationTimeFormat animTimeFormat1 = AnmationTimeFormat::RealTime);
 
+        /// Pose left by the last animate() or animateBlend(), copied so that it can be rendered
+        /// while the mesh is animated further
+        struct Pose
+        {
+            std::vector<glm::mat4> boneMatrices;    ///< As boneMatrices
+            std::vector<glm::mat4> meshMatrices;    ///< Node transform of each submesh that follows a node, identity for the others
+        };
+
+        /// @brief Copy the current pose
+        /// @param pose Receives the pose, reusing its storage
+        void getPose(Pose& pose) const;
+
         /// @brief
         /// @return
         unsigned getNbrAnimations() const;
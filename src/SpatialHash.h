@@ -0,0 +1,102 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_SpatialHash_h
+#define EENG_SpatialHash_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+namespace eeng
+{
+    /// @brief Hashed uniform grid over points on the xz-plane, for neighbor queries
+    /** Built from scratch each frame with a counting sort of the points on their bucket, so
+     * that the points of a bucket lie next to each other in memory. The grid is unbounded:
+     * cells are hashed into a table of about twice as many buckets as points. Points keep
+     * their cell coordinates, so cells that share a bucket are told apart and queries report
+     * each point at most once.
+     *
+     * Queries only read, so any number of threads may query between builds. Buffers are
+     * kept between builds, which makes rebuilding a scene of the same size allocation free.
+     */
+    class SpatialHash
+    {
+    public:
+        /// @brief Index count points given as separate x and z arrays into cells of cell_size
+        void build(const float* x, const float* z, size_t count, float cell_size)
+        {
+            m_inv_cell_size = 1.0f / cell_size;
+            size_t buckets = 1;
+            while (buckets < 2 * count) buckets <<= 1;
+            m_bucket_mask = uint32_t(buckets - 1);
+
+            m_bucket_start.assign(buckets + 1, 0);
+            m_point_bucket.resize(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint32_t b = bucket(cell(x[i]), cell(z[i]));
+                m_point_bucket[i] = b;
+                m_bucket_start[b + 1]++;
+            }
+            for (size_t b = 0; b < buckets; b++)
+                m_bucket_start[b + 1] += m_bucket_start[b];
+
+            m_fill.assign(m_bucket_start.begin(), m_bucket_start.end() - 1);
+            m_points.resize(count);
+            for (size_t i = 0; i < count; i++)
+                m_points[m_fill[m_point_bucket[i]]++] = { x[i], z[i], cell(x[i]), cell(z[i]), uint32_t(i) };
+        }
+
+        /// @brief Calls func(index, distance_squared) for each point within radius of (x, z)
+        template<class F>
+        void query(float x, float z, float radius, F&& func) const
+        {
+            if (m_points.empty()) return;
+            const float radius2 = radius * radius;
+            const int32_t cx0 = cell(x - radius), cx1 = cell(x + radius);
+            const int32_t cz0 = cell(z - radius), cz1 = cell(z + radius);
+            for (int32_t cz = cz0; cz <= cz1; cz++)
+                for (int32_t cx = cx0; cx <= cx1; cx++)
+                {
+                    const uint32_t b = bucket(cx, cz);
+                    for (uint32_t k = m_bucket_start[b]; k < m_bucket_start[b + 1]; k++)
+                    {
+                        const Point& p = m_points[k];
+                        if (p.cx != cx || p.cz != cz) continue;
+                        const float dx = p.x - x, dz = p.z - z;
+                        const float d2 = dx * dx + dz * dz;
+                        if (d2 <= radius2) func(p.index, d2);
+                    }
+                }
+        }
+
+        size_t size() const { return m_points.size(); }
+        size_t bucket_count() const { return m_bucket_start.empty() ? 0 : m_bucket_start.size() - 1; }
+
+    private:
+        struct Point
+        {
+            float x, z;
+            int32_t cx, cz;     // Cell coordinates, to tell cells that share a bucket apart
+            uint32_t index;     // Index in the input to build()
+        };
+
+        int32_t cell(float v) const { return int32_t(std::floor(v * m_inv_cell_size)); }
+
+        uint32_t bucket(int32_t cx, int32_t cz) const
+        {
+            return ((uint32_t(cx) * 73856093u) ^ (uint32_t(cz) * 19349663u)) & m_bucket_mask;
+        }
+
+        std::vector<Point> m_points;            // Sorted on bucket
+        std::vector<uint32_t> m_bucket_start;   // Points of bucket b are [m_bucket_start[b], m_bucket_start[b + 1])
+        std::vector<uint32_t> m_point_bucket;   // Scratch, bucket of each input point
+        std::vector<uint32_t> m_fill;           // Scratch, next free slot of each bucket
+        float m_inv_cell_size = 1.0f;
+        uint32_t m_bucket_mask = 0;
+    };
+
+} // namespace eeng
+
+#endif
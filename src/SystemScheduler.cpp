@@ -0,0 +1,107 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include "SystemScheduler.hpp"
+
+namespace eeng
+{
+    namespace
+    {
+        int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        bool intersects(const std::vector<std::type_index>& a, const std::vector<std::type_index>& b)
+        {
+            for (const auto& type : a)
+                if (std::find(b.begin(), b.end(), type) != b.end()) return true;
+            return false;
+        }
+    }
+
+    bool SystemScheduler::Access::conflicts_with(const Access& other) const
+    {
+        return intersects(writeTypes, other.readTypes) || intersects(writeTypes, other.writeTypes) || intersects(readTypes, other.writeTypes);
+    }
+
+    size_t SystemScheduler::add(std::string name, Access access, SystemFunc func)
+    {
+        const size_t index = systems.size();
+        System system{ std::move(access), std::move(func), {}, {} };
+        system.info.name = std::move(name);
+
+        // Walk back from the latest system and skip the ones already waited for through another
+        // dependency, so that only the direct dependencies remain
+        std::vector<uint8_t> reached(index, 0);
+        for (size_t i = index; i-- > 0;)
+        {
+            if (reached[i] || !system.access.conflicts_with(systems[i].access)) continue;
+            system.info.dependencies.push_back(i);
+            system.info.level = std::max(system.info.level, systems[i].info.level + 1);
+            systems[i].dependents.push_back(index);
+
+            std::vector<size_t> stack{ i };
+            while (!stack.empty())
+            {
+                const size_t k = stack.back();
+                stack.pop_back();
+                reached[k] = 1;
+                for (size_t dependency : systems[k].info.dependencies)
+                    if (!reached[dependency]) stack.push_back(dependency);
+            }
+        }
+        std::reverse(system.info.dependencies.begin(), system.info.dependencies.end());
+
+        levelCount = std::max(levelCount, system.info.level + 1);
+        systems.push_back(std::move(system));
+        waitingFor = std::make_unique<std::atomic<uint32_t>[]>(systems.size());
+        warmedUp = false;
+        return index;
+    }
+
+    void SystemScheduler::run(ThreadPool& threadPool)
+    {
+        const int64_t frameStart = now_ns();
+        if (!parallel || !warmedUp || threadPool.thread_count() == 1)
+        {
+            for (size_t i = 0; i < systems.size(); i++)
+                run_system(i, frameStart);
+            warmedUp = true;
+        }
+        else
+        {
+            JobCounter frame;
+            std::function<void(size_t)> submit = [&](size_t index) {
+                threadPool.submit([&, index] {
+                    run_system(index, frameStart);
+                    // The last dependency to finish starts the system. It is counted by the frame
+                    // before this job is, so the frame cannot finish in between.
+                    for (size_t dependent : systems[index].dependents)
+                        if (waitingFor[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            submit(dependent);
+                }, &frame);
+            };
+
+            for (size_t i = 0; i < systems.size(); i++)
+                waitingFor[i].store(uint32_t(systems[i].info.dependencies.size()), std::memory_order_relaxed);
+            for (size_t i = 0; i < systems.size(); i++)
+                if (systems[i].info.dependencies.empty()) submit(i);
+            threadPool.wait(frame);
+        }
+        frameMs = float(now_ns() - frameStart) * 1e-6f;
+    }
+
+    void SystemScheduler::run_system(size_t index, int64_t frameStart)
+    {
+        System& system = systems[index];
+        const int64_t start = now_ns();
+        system.func();
+        const int64_t end = now_ns();
+        system.info.start_ms = float(start - frameStart) * 1e-6f;
+        system.info.ms = float(end - start) * 1e-6f;
+    }
+
+} // namespace eeng
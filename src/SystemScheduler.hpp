@@ -0,0 +1,103 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_SystemScheduler_hpp
+#define EENG_SystemScheduler_hpp
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <typeindex>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "ThreadPool.hpp"
+
+namespace eeng
+{
+    /// @brief Runs the systems of a frame as jobs, in parallel where their data allows it
+    /** Each system declares the component types, and any other shared state, that it reads and writes.
+     * Two systems conflict when one of them writes something the other reads or writes. A system runs
+     * after every system added before it that it conflicts with, and concurrently with the others, so
+     * the result is the same as running the systems one by one in the order they were added.
+     *
+     * Types are only compared, never inspected, so anything may be declared: component types for the
+     * data of a view, and e.g. a world struct or a quest state for data outside the registry. Adding or
+     * removing components of a type is a write of that type.
+     *
+     * The first run after systems were added is serial, so that state the systems create lazily,
+     * such as the storage of a component type, exists before they run concurrently.
+     */
+    class SystemScheduler
+    {
+    public:
+        using SystemFunc = std::function<void()>;
+
+        /// @brief The data a system reads and writes
+        class Access
+        {
+        public:
+            template<class... T>
+            Access& reads() { (readTypes.emplace_back(typeid(T)), ...); return *this; }
+
+            template<class... T>
+            Access& writes() { (writeTypes.emplace_back(typeid(T)), ...); return *this; }
+
+            /// True if the two cannot run at the same time
+            bool conflicts_with(const Access& other) const;
+
+        private:
+            std::vector<std::type_index> readTypes, writeTypes;
+        };
+
+        struct SystemInfo
+        {
+            std::string name;
+            std::vector<size_t> dependencies;   ///< Systems it waits for directly, not those they wait for in turn
+            size_t level = 0;                   ///< Length of the longest chain of systems it waits for
+            float start_ms = 0.0f;              ///< Start of the last run, from the start of the frame
+            float ms = 0.0f;                    ///< Duration of the last run
+        };
+
+        SystemScheduler() = default;
+        SystemScheduler(const SystemScheduler&) = delete;
+        SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+        /// @brief Add a system to run after the systems added so far that it conflicts with
+        /// @return Index of the system in info()
+        size_t add(std::string name, Access access, SystemFunc func);
+
+        /// @brief Run every system once. Returns when all of them are done.
+        void run(ThreadPool& threadPool);
+
+        size_t size() const { return systems.size(); }
+        const SystemInfo& info(size_t index) const { return systems[index].info; }
+        /// Number of levels, i.e. the longest chain of systems that wait for each other
+        size_t level_count() const { return levelCount; }
+        /// Wall time of the last run
+        float frame_ms() const { return frameMs; }
+
+        /// Run the systems one by one in the order they were added, e.g. to compare timings
+        bool parallel = true;
+
+    private:
+        struct System
+        {
+            Access access;
+            SystemFunc func;
+            SystemInfo info;
+            std::vector<size_t> dependents;
+        };
+
+        void run_system(size_t index, int64_t frameStart);
+
+        std::vector<System> systems;
+        std::unique_ptr<std::atomic<uint32_t>[]> waitingFor;    ///< Per system, dependencies not yet done this run
+        size_t levelCount = 0;
+        float frameMs = 0.0f;
+        bool warmedUp = false;
+    };
+
+} // namespace eeng
+
+#endif
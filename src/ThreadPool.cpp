@@ -0,0 +1,226 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#include <algorithm>
+#include "ThreadPool.hpp"
+
+namespace eeng
+{
+    struct JobCounter::Job
+    {
+        std::function<void()> func;
+        JobCounter* counter = nullptr;
+    };
+
+    namespace
+    {
+        // Pool and deque of the worker running on this thread, if any
+        thread_local ThreadPool* tlsPool = nullptr;
+        thread_local size_t tlsIndex = 0;
+        thread_local uint32_t tlsVictimSeed = 0x9e3779b9u;
+
+        // One parallel_for loop, shared by the jobs that run its chunks
+        struct Loop
+        {
+            const ThreadPool::ChunkFunc* func;
+            size_t count, chunkSize, chunkCount;
+            std::atomic<size_t> nextChunk{ 0 };
+
+            void run_chunks()
+            {
+                for (;;)
+                {
+                    const size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                    if (chunk >= chunkCount) break;
+                    const size_t begin = chunk * chunkSize;
+                    (*func)(begin, std::min(begin + chunkSize, count), chunk);
+                }
+            }
+        };
+    }
+
+    size_t ThreadPool::default_worker_count()
+    {
+        const size_t hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 0;
+    }
+
+    ThreadPool::ThreadPool(size_t workerCount)
+    {
+        // All deques exist before any worker may steal from them
+        for (size_t i = 0; i < workerCount; i++)
+            deques.push_back(std::make_unique<WorkStealingDeque<Job*>>());
+        workers.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; i++)
+            workers.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+
+        Job* job;
+        for (auto& deque : deques)
+            while (deque->pop(job)) delete job;
+        for (Job* injectedJob : injected) delete injectedJob;
+    }
+
+    void ThreadPool::submit(JobFunc func, JobCounter* counter)
+    {
+        if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+        enqueue(new Job{ std::move(func), counter });
+    }
+
+    void ThreadPool::submit_after(JobCounter& dependency, JobFunc func, JobCounter* counter)
+    {
+        if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+        Job* job = new Job{ std::move(func), counter };
+        {
+            // The last job of the dependency takes the continuations under this lock after it has
+            // counted down, so the job is either seen by it or started here
+            std::lock_guard<std::mutex> lock(dependency.mutex);
+            if (!dependency.done())
+            {
+                dependency.continuations.push_back(job);
+                return;
+            }
+        }
+        enqueue(job);
+    }
+
+    void ThreadPool::wait(JobCounter& counter)
+    {
+        while (!counter.done())
+        {
+            if (!run_one()) std::this_thread::yield();
+        }
+    }
+
+    void ThreadPool::parallel_for(size_t count, size_t chunkSize, const ChunkFunc& func)
+    {
+        if (count == 0) return;
+        chunkSize = std::max<size_t>(chunkSize, 1);
+        const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+        // Not worth a job for a single chunk
+        if (workers.empty() || chunkCount == 1)
+        {
+            for (size_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                const size_t begin = chunk * chunkSize;
+                func(begin, std::min(begin + chunkSize, count), chunk);
+            }
+            return;
+        }
+
+        // Helpers take chunks from a shared counter, so a helper that starts late finds little or nothing left
+        Loop loop{ &func, count, chunkSize, chunkCount };
+        JobCounter helpers;
+        const size_t helperCount = std::min(workers.size(), chunkCount - 1);
+        for (size_t i = 0; i < helperCount; i++)
+            submit([&loop] { loop.run_chunks(); }, &helpers);
+
+        loop.run_chunks();
+        wait(helpers);
+    }
+
+    void ThreadPool::enqueue(Job* job)
+    {
+        if (tlsPool == this)
+        {
+            deques[tlsIndex]->push(job);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(injectMutex);
+            injected.push_back(job);
+        }
+
+        // A worker going to sleep counts itself before it checks queuedJobs, so either it sees this job
+        // or this sees it sleeping and wakes it
+        queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            wake.notify_one();
+        }
+    }
+
+    ThreadPool::Job* ThreadPool::find_job()
+    {
+        Job* job = nullptr;
+        const bool isWorker = tlsPool == this;
+        if (isWorker && deques[tlsIndex]->pop(job)) return job;
+
+        // Steal from the other workers, starting at a random one
+        const size_t n = deques.size();
+        tlsVictimSeed ^= tlsVictimSeed << 13;
+        tlsVictimSeed ^= tlsVictimSeed >> 17;
+        tlsVictimSeed ^= tlsVictimSeed << 5;
+        const size_t first = n ? tlsVictimSeed % n : 0;
+        for (size_t k = 0; k < n; k++)
+        {
+            const size_t victim = (first + k) % n;
+            if (isWorker && victim == tlsIndex) continue;
+            if (deques[victim]->steal(job)) return job;
+        }
+
+        std::lock_guard<std::mutex> lock(injectMutex);
+        if (injected.empty()) return nullptr;
+        job = injected.front();
+        injected.pop_front();
+        return job;
+    }
+
+    void ThreadPool::run(Job* job)
+    {
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        job->func();
+
+        if (JobCounter* counter = job->counter)
+        {
+            std::vector<Job*> continuations;
+            {
+                // Under the lock, see submit_after()
+                std::lock_guard<std::mutex> lock(counter->mutex);
+                if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    continuations.swap(counter->continuations);
+            }
+            for (Job* next : continuations) enqueue(next);
+        }
+        delete job;
+    }
+
+    bool ThreadPool::run_one()
+    {
+        Job* job = find_job();
+        if (!job) return false;
+        run(job);
+        return true;
+    }
+
+    void ThreadPool::worker_loop(size_t index)
+    {
+        tlsPool = this;
+        tlsIndex = index;
+        tlsVictimSeed = uint32_t(index * 0x9e3779b9u + 1);
+        for (;;)
+        {
+            if (run_one()) continue;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+            wake.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_seq_cst) > 0; });
+            sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+            if (stopping) return;
+        }
+    }
+
+} // namespace eeng
@@ -0,0 +1,142 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_ThreadPool_hpp
+#define EENG_ThreadPool_hpp
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include "WorkStealingDeque.h"
+
+namespace eeng
+{
+    class ThreadPool;
+
+    /// @brief Counts the unfinished jobs of a group, to wait for them or to start other jobs after them
+    /** A counter must outlive the jobs it counts and any jobs that depend on it. It may be reused
+     * once it is done.
+     */
+    class JobCounter
+    {
+    public:
+        JobCounter() = default;
+        /// Waits for the last job to let go of the counter, which it does just after counting down
+        ~JobCounter() { std::lock_guard<std::mutex> lock(mutex); }
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        /// True when every job counted so far has finished
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class ThreadPool;
+        struct Job;
+
+        std::atomic<uint32_t> pending{ 0 };
+        std::mutex mutex;
+        std::vector<Job*> continuations;    ///< Jobs to submit when pending drops to zero
+    };
+
+    /// @brief Work-stealing job system: a fixed set of worker threads, each with its own job deque
+    /** Jobs submitted from a worker go to the bottom of its own deque, where it picks them up again
+     * last in first out; idle workers steal from the top of the other deques. Jobs submitted from any
+     * other thread go through a shared queue. Waiting on a JobCounter runs other jobs meanwhile, so
+     * jobs may submit and wait for jobs of their own, and waiting never leaves a thread idle while
+     * there is work.
+     *
+     * parallel_for() is built on the same jobs. The calling thread takes part in each loop, so a pool
+     * with zero workers runs serially.
+     */
+    class ThreadPool
+    {
+    public:
+        /// Function of type void(size_t begin, size_t end, size_t chunkIndex)
+        using ChunkFunc = std::function<void(size_t, size_t, size_t)>;
+        using JobFunc = std::function<void()>;
+
+        /// @param workerCount Threads in addition to the calling thread. Defaults to one less than the hardware concurrency.
+        explicit ThreadPool(size_t workerCount = default_worker_count());
+        /// Jobs still queued when the pool is destroyed are dropped, so wait for them first
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// Number of threads that execute a loop, the calling thread included
+        size_t thread_count() const { return workers.size() + 1; }
+
+        /// @brief Queue a job. If counter is given, it counts the job until the job has finished.
+        void submit(JobFunc func, JobCounter* counter = nullptr);
+
+        /// @brief Queue a job to start once every job counted by dependency has finished
+        void submit_after(JobCounter& dependency, JobFunc func, JobCounter* counter = nullptr);
+
+        /// @brief Run queued jobs until every job counted by counter has finished
+        void wait(JobCounter& counter);
+
+        /// @brief Split [0, count) into chunks of chunkSize and run func on each. Blocks until all chunks are done.
+        /// Chunk boundaries depend only on count and chunkSize, never on the number of threads,
+        /// so results written per chunk are the same for any pool size.
+        void parallel_for(size_t count, size_t chunkSize, const ChunkFunc& func);
+
+        /// @brief Run func(element) for each element of a range, e.g. an EnTT view or group, in chunks of chunkSize
+        /** Ranges without random access, such as multi-component views, are first copied to a vector,
+         * so func may add and remove components of other types but must not change the range itself.
+         */
+        template<class Range, class Func>
+        void parallel_for_each(const Range& range, size_t chunkSize, Func&& func)
+        {
+            using Iterator = decltype(std::begin(range));
+            if constexpr (std::random_access_iterator<Iterator>)
+            {
+                const Iterator first = std::begin(range);
+                parallel_for(size_t(std::end(range) - first), chunkSize, [&](size_t begin, size_t end, size_t) {
+                    for (size_t i = begin; i < end; i++) func(first[i]);
+                });
+            }
+            else
+            {
+                const std::vector<std::iter_value_t<Iterator>> elements(std::begin(range), std::end(range));
+                parallel_for(elements.size(), chunkSize, [&](size_t begin, size_t end, size_t) {
+                    for (size_t i = begin; i < end; i++) func(elements[i]);
+                });
+            }
+        }
+
+        static size_t default_worker_count();
+
+    private:
+        using Job = JobCounter::Job;
+
+        void worker_loop(size_t index);
+        void enqueue(Job* job);
+        Job* find_job();
+        void run(Job* job);
+        bool run_one();
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<WorkStealingDeque<Job*>>> deques;   ///< One per worker
+
+        // Jobs submitted from outside the pool
+        std::mutex injectMutex;
+        std::deque<Job*> injected;
+
+        // Sleeping workers wait for queued jobs
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::atomic<int64_t> queuedJobs{ 0 };
+        std::atomic<size_t> sleepingWorkers{ 0 };
+        bool stopping = false;
+    };
+
+} // namespace eeng
+
+#endif
@@ -0,0 +1,280 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_TransformHierarchy_h
+#define EENG_TransformHierarchy_h
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <concepts>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace eeng
+{
+    /// @brief Hierarchy of local and world transforms stored in pre-order, in flat arrays
+    /** Nodes are laid out as in VecTree: every node is directly followed by its descendants, and
+     * keeps the size of its branch (itself included) and the distance back to its parent. A
+     * parent thus always precedes its children, and a whole branch is one contiguous range.
+     *
+     * Setting a local transform marks the node dirty. propagate() visits the dirty nodes in
+     * ascending order and rebuilds the world transforms of their branches front to back, each
+     * from the already updated world transform of its parent, so that the cost is proportional to
+     * the size of the dirty branches only. Clean subtrees are never visited, and a dirty node
+     * inside a branch that was rebuilt already is skipped.
+     *
+     * Structural changes (insert, reparent, erase) shift the nodes after the change, and are
+     * linear in the size of the hierarchy. Nodes are looked up by payload, e.g. an entity.
+     */
+    template<class PayloadType, class MatrixType>
+        requires requires(MatrixType a, MatrixType b) { { a * b } -> std::convertible_to<MatrixType>; }
+    class TransformHierarchy
+    {
+    public:
+        static constexpr size_t null_index = size_t(-1);
+
+        TransformHierarchy() = default;
+
+        size_t size() const { return m_payloads.size(); }
+
+        bool contains(const PayloadType& payload) const { return m_index.count(payload) != 0; }
+
+        /// @brief Index of a node in pre-order, or null_index. Indices change with the structure.
+        size_t index_of(const PayloadType& payload) const
+        {
+            auto it = m_index.find(payload);
+            return it == m_index.end() ? null_index : it->second;
+        }
+
+        /// @brief Insert a node as the last child of parent_payload
+        /// @return False if the payload is already in the hierarchy or the parent is not
+        bool insert(const PayloadType& payload, const PayloadType& parent_payload, const MatrixType& local)
+        {
+            const size_t parent_index = index_of(parent_payload);
+            if (parent_index == null_index || contains(payload)) return false;
+            insert_branch(parent_index, &payload, &local, nullptr, 1);
+            return true;
+        }
+
+        /// @brief Insert a node without a parent, after the other nodes
+        /// @return False if the payload is already in the hierarchy
+        bool insert_as_root(const PayloadType& payload, const MatrixType& local)
+        {
+            if (contains(payload)) return false;
+            insert_branch(null_index, &payload, &local, nullptr, 1);
+            return true;
+        }
+
+        /// @brief Move a node and its descendants to the last child of parent_payload
+        /// @return False if either node is missing, or the parent lies in the branch of the node
+        bool reparent(const PayloadType& payload, const PayloadType& parent_payload)
+        {
+            const size_t index = index_of(payload);
+            const size_t parent_index = index_of(parent_payload);
+            if (index == null_index || parent_index == null_index) return false;
+            if (parent_index >= index && parent_index < index + m_branch_stride[index]) return false;
+            move_branch(index, &parent_payload);
+            return true;
+        }
+
+        /// @brief Make a node a root, keeping its descendants
+        bool unparent(const PayloadType& payload)
+        {
+            const size_t index = index_of(payload);
+            if (index == null_index) return false;
+            if (m_parent_ofs[index] == 0) return true;
+            move_branch(index, nullptr);
+            return true;
+        }
+
+        /// @brief Remove a node and all of its descendants
+        bool erase_branch(const PayloadType& payload)
+        {
+            const size_t index = index_of(payload);
+            if (index == null_index) return false;
+            for (size_t i = index; i < index + m_branch_stride[index]; i++)
+                m_index.erase(m_payloads[i]);
+            erase_branch_at(index);
+            return true;
+        }
+
+        /// @brief Set the transform of a node relative to its parent, and mark it dirty
+        void set_local(const PayloadType& payload, const MatrixType& local)
+        {
+            const size_t index = index_of(payload);
+            assert(index != null_index);
+            set_local_at(index, local);
+        }
+
+        void set_local_at(size_t index, const MatrixType& local)
+        {
+            m_local[index] = local;
+            mark_dirty(index);
+        }
+
+        /// @brief Rebuild the world transforms of all dirty branches
+        /// @return Number of world transforms rebuilt
+        size_t propagate()
+        {
+            return propagate([](size_t) {});
+        }
+
+        /// @brief Rebuild the world transforms of all dirty branches, calling func(index) for each node rebuilt
+        template<class F>
+        size_t propagate(F&& func)
+        {
+            // Ascending order makes it one forward pass, where a parent is always rebuilt before its children
+            std::sort(m_dirty_nodes.begin(), m_dirty_nodes.end());
+            size_t rebuilt = 0, branch_end = 0;
+            for (uint32_t index : m_dirty_nodes)
+            {
+                // Already rebuilt with the branch of a dirty ancestor
+                if (index < branch_end) continue;
+                branch_end = index + m_branch_stride[index];
+                for (size_t i = index; i < branch_end; i++)
+                {
+                    const uint32_t parent_ofs = m_parent_ofs[i];
+                    m_world[i] = parent_ofs ? MatrixType(m_world[i - parent_ofs] * m_local[i]) : m_local[i];
+                    m_dirty[i] = 0;
+                    func(i);
+                }
+                rebuilt += branch_end - index;
+            }
+            m_dirty_nodes.clear();
+            return rebuilt;
+        }
+
+        /// Nodes waiting for propagate(), counting each dirty node once even if an ancestor is dirty too
+        size_t dirty_count() const { return m_dirty_nodes.size(); }
+
+        const PayloadType& payload_at(size_t index) const { return m_payloads[index]; }
+        const MatrixType& local_at(size_t index) const { return m_local[index]; }
+        /// World transform as of the last propagate()
+        const MatrixType& world_at(size_t index) const { return m_world[index]; }
+        /// Size of the branch of a node, the node itself included
+        size_t branch_stride_at(size_t index) const { return m_branch_stride[index]; }
+
+        size_t parent_index_at(size_t index) const
+        {
+            return m_parent_ofs[index] ? index - m_parent_ofs[index] : null_index;
+        }
+
+        const MatrixType& world(const PayloadType& payload) const
+        {
+            const size_t index = index_of(payload);
+            assert(index != null_index);
+            return m_world[index];
+        }
+
+        void clear()
+        {
+            m_payloads.clear();
+            m_parent_ofs.clear();
+            m_branch_stride.clear();
+            m_local.clear();
+            m_world.clear();
+            m_dirty.clear();
+            m_dirty_nodes.clear();
+            m_index.clear();
+        }
+
+    private:
+        void mark_dirty(size_t index)
+        {
+            if (m_dirty[index]) return;
+            m_dirty[index] = 1;
+            m_dirty_nodes.push_back(uint32_t(index));
+        }
+
+        // Copy a branch out, remove it and insert it again under its new parent, or as a root if there is none
+        void move_branch(size_t index, const PayloadType* parent_payload)
+        {
+            const size_t stride = m_branch_stride[index];
+            const std::vector<PayloadType> payloads(m_payloads.begin() + index, m_payloads.begin() + index + stride);
+            const std::vector<MatrixType> locals(m_local.begin() + index, m_local.begin() + index + stride);
+            const std::vector<uint32_t> parent_ofs(m_parent_ofs.begin() + index, m_parent_ofs.begin() + index + stride);
+
+            erase_branch_at(index);
+            const size_t parent_index = parent_payload ? index_of(*parent_payload) : null_index;
+            insert_branch(parent_index, payloads.data(), locals.data(), parent_ofs.data(), stride);
+        }
+
+        // Insert count nodes in pre-order as the last child of parent_index, or as a root. Offsets
+        // within the branch are kept, the branch root gets its new one. The whole branch is dirty.
+        void insert_branch(size_t parent_index, const PayloadType* payloads, const MatrixType* locals, const uint32_t* parent_ofs, size_t count)
+        {
+            const size_t n = size();
+            const size_t pos = parent_index == null_index ? n : parent_index + m_branch_stride[parent_index];
+
+            // Later nodes whose parent stays in front of the insertion move away from it
+            for (size_t i = pos; i < n; i++)
+                if (m_parent_ofs[i] && i - m_parent_ofs[i] < pos) m_parent_ofs[i] += uint32_t(count);
+            for (size_t a = parent_index; a != null_index; a = parent_index_at(a))
+                m_branch_stride[a] += uint32_t(count);
+
+            std::vector<uint32_t> strides(count, 1), offsets(count, 0);
+            for (size_t i = count; i-- > 1;)
+            {
+                offsets[i] = parent_ofs ? parent_ofs[i] : 0;
+                strides[i - offsets[i]] += strides[i];
+            }
+            offsets[0] = parent_index == null_index ? 0 : uint32_t(pos - parent_index);
+
+            m_payloads.insert(m_payloads.begin() + pos, payloads, payloads + count);
+            m_local.insert(m_local.begin() + pos, locals, locals + count);
+            m_world.insert(m_world.begin() + pos, locals, locals + count);
+            m_parent_ofs.insert(m_parent_ofs.begin() + pos, offsets.begin(), offsets.end());
+            m_branch_stride.insert(m_branch_stride.begin() + pos, strides.begin(), strides.end());
+            m_dirty.insert(m_dirty.begin() + pos, count, 0);
+
+            structure_changed(pos);
+            mark_dirty(pos);
+        }
+
+        void erase_branch_at(size_t index)
+        {
+            const size_t n = size();
+            const size_t count = m_branch_stride[index];
+
+            // Later nodes whose parent is in front of the branch move closer to it
+            for (size_t i = index + count; i < n; i++)
+                if (m_parent_ofs[i] && i - m_parent_ofs[i] < index) m_parent_ofs[i] -= uint32_t(count);
+            for (size_t a = parent_index_at(index); a != null_index; a = parent_index_at(a))
+                m_branch_stride[a] -= uint32_t(count);
+
+            m_payloads.erase(m_payloads.begin() + index, m_payloads.begin() + index + count);
+            m_local.erase(m_local.begin() + index, m_local.begin() + index + count);
+            m_world.erase(m_world.begin() + index, m_world.begin() + index + count);
+            m_parent_ofs.erase(m_parent_ofs.begin() + index, m_parent_ofs.begin() + index + count);
+            m_branch_stride.erase(m_branch_stride.begin() + index, m_branch_stride.begin() + index + count);
+            m_dirty.erase(m_dirty.begin() + index, m_dirty.begin() + index + count);
+
+            structure_changed(index);
+        }
+
+        // Nodes from first on have new indices
+        void structure_changed(size_t first)
+        {
+            for (size_t i = first; i < size(); i++)
+                m_index[m_payloads[i]] = i;
+            m_dirty_nodes.clear();
+            for (size_t i = 0; i < size(); i++)
+                if (m_dirty[i]) m_dirty_nodes.push_back(uint32_t(i));
+        }
+
+        // Per node, in pre-order
+        std::vector<PayloadType> m_payloads;
+        std::vector<uint32_t> m_parent_ofs;     // Distance back to the parent, 0 for roots
+        std::vector<uint32_t> m_branch_stride;  // Branch size including the node
+        std::vector<MatrixType> m_local;        // Relative to the parent
+        std::vector<MatrixType> m_world;
+        std::vector<uint8_t> m_dirty;           // Local transform set since the last propagate()
+
+        std::vector<uint32_t> m_dirty_nodes;    // Indices of the dirty nodes, in the order they were marked
+        std::unordered_map<PayloadType, size_t> m_index;
+    };
+
+} // namespace eeng
+
+#endif
@@ -0,0 +1,648 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_TriangleMeshBVH_h
+#define EENG_TriangleMeshBVH_h
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+namespace eeng
+{
+    /// @brief Closest ray hit on a triangle mesh
+    struct TriangleHit
+    {
+        float t = FLT_MAX;          ///< Distance along the ray, in units of the ray direction
+        uint32_t triangle = 0;      ///< Index of the triangle in the input to build()
+        float normal[3]{};          ///< Unit geometric normal, facing the ray origin
+    };
+
+    /// @brief Bounding volume hierarchy over the triangles of a static mesh
+    /** Built with the surface area heuristic over binned centroids. Nodes are stored
+     * depth-first, with the left child directly after its parent, either as 32-byte float
+     * nodes or, with the quantized option, as 16-byte nodes whose bounds are 16-bit offsets
+     * within the mesh bounds, rounded outwards. Quantized nodes halve the memory of the tree
+     * at the cost of slightly looser boxes.
+     *
+     * Triangle vertices are copied into leaf order so that a leaf reads one contiguous block.
+     * All queries are const and may run concurrently.
+     */
+    class TriangleMeshBVH
+    {
+    public:
+        /// 32-byte node
+        struct Node
+        {
+            float min[3];
+            uint32_t index;     ///< Internal node: right child. Leaf: first triangle in leaf order.
+            float max[3];
+            uint32_t count;     ///< Nbr of triangles in a leaf, 0 for internal nodes
+        };
+        static_assert(sizeof(Node) == 32);
+
+        /// 16-byte node with bounds quantized to the mesh bounds
+        struct QuantizedNode
+        {
+            uint16_t qmin[3];
+            uint16_t qmax[3];
+            uint32_t data;      ///< (index << 4) | count, with index and count as in Node
+        };
+        static_assert(sizeof(QuantizedNode) == 16);
+
+        static constexpr size_t MaxLeafSize = 4;
+        static constexpr size_t SahBins = 12;
+
+        /// @brief Build over an indexed triangle list
+        /// @param positions x, y, z per vertex
+        /// @param indices Three vertex indices per triangle
+        /// @param quantized Store 16-byte quantized nodes instead of 32-byte float nodes
+        void build(const float* positions, const uint32_t* indices, size_t triangle_count, bool quantized = false)
+        {
+            clear();
+            m_quantized = quantized;
+            if (triangle_count == 0) return;
+
+            std::vector<BuildTriangle> tris(triangle_count);
+            for (size_t i = 0; i < triangle_count; i++)
+            {
+                BuildTriangle& t = tris[i];
+                t.id = static_cast<uint32_t>(i);
+                for (int a = 0; a < 3; a++)
+                {
+                    t.min[a] = FLT_MAX;
+                    t.max[a] = -FLT_MAX;
+                }
+                for (int v = 0; v < 3; v++)
+                {
+                    const float* p = positions + 3 * size_t(indices[3 * i + v]);
+                    for (int a = 0; a < 3; a++)
+                    {
+                        t.min[a] = std::min(t.min[a], p[a]);
+                        t.max[a] = std::max(t.max[a], p[a]);
+                    }
+                }
+                for (int a = 0; a < 3; a++) t.centroid[a] = 0.5f * (t.min[a] + t.max[a]);
+            }
+
+            std::vector<Node> nodes;
+            nodes.reserve(2 * (triangle_count / MaxLeafSize + 1));
+            build_recursive(nodes, tris, 0, triangle_count);
+            std::copy(nodes[0].min, nodes[0].min + 3, m_min);
+            std::copy(nodes[0].max, nodes[0].max + 3, m_max);
+
+            m_vertices.resize(9 * triangle_count);
+            m_ids.resize(triangle_count);
+            for (size_t i = 0; i < triangle_count; i++)
+            {
+                m_ids[i] = tris[i].id;
+                for (int v = 0; v < 3; v++)
+                {
+                    const float* p = positions + 3 * size_t(indices[3 * size_t(tris[i].id) + v]);
+                    std::copy(p, p + 3, &m_vertices[9 * i + 3 * v]);
+                }
+            }
+
+            if (!m_quantized)
+            {
+                m_nodes = std::move(nodes);
+                return;
+            }
+
+            for (int a = 0; a < 3; a++)
+            {
+                const float extent = m_max[a] - m_min[a];
+                m_step[a] = extent > 0.0f ? extent / 65535.0f : 1.0f;
+            }
+            m_qnodes.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); i++)
+            {
+                QuantizedNode& q = m_qnodes[i];
+                for (int a = 0; a < 3; a++)
+                {
+                    q.qmin[a] = quantize(std::floor((nodes[i].min[a] - m_min[a]) / m_step[a]));
+                    q.qmax[a] = quantize(std::ceil((nodes[i].max[a] - m_min[a]) / m_step[a]));
+                }
+                q.data = (nodes[i].index << 4) | nodes[i].count;
+            }
+        }
+
+        void clear()
+        {
+            m_nodes.clear();
+            m_qnodes.clear();
+            m_vertices.clear();
+            m_ids.clear();
+        }
+
+        bool empty() const { return m_ids.empty(); }
+        bool quantized() const { return m_quantized; }
+        size_t triangle_count() const { return m_ids.size(); }
+        size_t node_count() const { return m_quantized ? m_qnodes.size() : m_nodes.size(); }
+
+        /// Bytes used by nodes and triangle data
+        size_t memory_usage() const
+        {
+            return m_nodes.size() * sizeof(Node) + m_qnodes.size() * sizeof(QuantizedNode) +
+                m_vertices.size() * sizeof(float) + m_ids.size() * sizeof(uint32_t);
+        }
+
+        /// @brief Bounds of the whole mesh
+        void bounds(float out_min[3], float out_max[3]) const
+        {
+            std::copy(m_min, m_min + 3, out_min);
+            std::copy(m_max, m_max + 3, out_max);
+        }
+
+        /// @brief Closest hit along a ray within [0, t_max]. Triangles are hit from both sides.
+        bool raycast(const float o[3], const float d[3], float t_max, TriangleHit& hit) const
+        {
+            float inv_d[3];
+            inverse_direction(d, inv_d);
+            bool found = false;
+            float best = t_max;
+
+            traverse_ray(o, inv_d, best, [&](size_t k)
+                {
+                    float t;
+                    if (ray_triangle(o, d, k, best, t))
+                    {
+                        best = t;
+                        found = true;
+                        hit.t = t;
+                        hit.triangle = m_ids[k];
+                        face_normal(k, d, hit.normal);
+                    }
+                    return false;
+                });
+            return found;
+        }
+
+        /// @brief True if anything blocks the ray within [0, t_max], e.g. for line-of-sight tests. Stops at the first hit.
+        bool any_hit(const float o[3], const float d[3], float t_max) const
+        {
+            float inv_d[3];
+            inverse_direction(d, inv_d);
+            bool found = false;
+            traverse_ray(o, inv_d, t_max, [&](size_t k)
+                {
+                    float t;
+                    found = ray_triangle(o, d, k, t_max, t);
+                    return found;
+                });
+            return found;
+        }
+
+        /// @brief Call func(triangle, closest) for each triangle within radius of center,
+        /// closest being the point of the triangle nearest to center
+        template<class F>
+        void query_sphere(const float center[3], float radius, F&& func) const
+        {
+            const float qmin[3]{ center[0] - radius, center[1] - radius, center[2] - radius };
+            const float qmax[3]{ center[0] + radius, center[1] + radius, center[2] + radius };
+            traverse_box(qmin, qmax, [&](size_t k)
+                {
+                    float closest[3];
+                    closest_point(k, center, closest);
+                    const float dx = closest[0] - center[0], dy = closest[1] - center[1], dz = closest[2] - center[2];
+                    if (dx * dx + dy * dy + dz * dz <= radius * radius)
+                        func(m_ids[k], static_cast<const float*>(closest));
+                    return false;
+                });
+        }
+
+        /// @brief Call func(triangle) for each triangle that overlaps the box [qmin, qmax]
+        template<class F>
+        void query_aabb(const float qmin[3], const float qmax[3], F&& func) const
+        {
+            traverse_box(qmin, qmax, [&](size_t k)
+                {
+                    if (triangle_overlaps_box(k, qmin, qmax)) func(m_ids[k]);
+                    return false;
+                });
+        }
+
+        bool overlaps_sphere(const float center[3], float radius) const
+        {
+            const float qmin[3]{ center[0] - radius, center[1] - radius, center[2] - radius };
+            const float qmax[3]{ center[0] + radius, center[1] + radius, center[2] + radius };
+            bool found = false;
+            traverse_box(qmin, qmax, [&](size_t k)
+                {
+                    float closest[3];
+                    closest_point(k, center, closest);
+                    const float dx = closest[0] - center[0], dy = closest[1] - center[1], dz = closest[2] - center[2];
+                    found = dx * dx + dy * dy + dz * dz <= radius * radius;
+                    return found;
+                });
+            return found;
+        }
+
+        bool overlaps_aabb(const float qmin[3], const float qmax[3]) const
+        {
+            bool found = false;
+            traverse_box(qmin, qmax, [&](size_t k) { return found = triangle_overlaps_box(k, qmin, qmax); });
+            return found;
+        }
+
+        /// @brief Vertices of a triangle as 9 floats, looked up by its index in the input to build()
+        /// Linear in the triangle count; meant for debugging and tests.
+        const float* triangle_vertices(uint32_t triangle) const
+        {
+            const auto it = std::find(m_ids.begin(), m_ids.end(), triangle);
+            return it == m_ids.end() ? nullptr : &m_vertices[9 * size_t(it - m_ids.begin())];
+        }
+
+    private:
+        struct BuildTriangle
+        {
+            float min[3], max[3], centroid[3];
+            uint32_t id;
+        };
+
+        struct Bin
+        {
+            float min[3]{ FLT_MAX, FLT_MAX, FLT_MAX }, max[3]{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            size_t count = 0;
+
+            void grow(const float* bmin, const float* bmax)
+            {
+                for (int a = 0; a < 3; a++)
+                {
+                    min[a] = std::min(min[a], bmin[a]);
+                    max[a] = std::max(max[a], bmax[a]);
+                }
+            }
+            float half_area() const
+            {
+                if (count == 0) return 0.0f;
+                const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+                return dx * dy + dy * dz + dz * dx;
+            }
+        };
+
+        static uint16_t quantize(float v)
+        {
+            return static_cast<uint16_t>(std::clamp(v, 0.0f, 65535.0f));
+        }
+
+        static void inverse_direction(const float d[3], float inv_d[3])
+        {
+            for (int a = 0; a < 3; a++)
+                inv_d[a] = std::abs(d[a]) > 1e-20f ? 1.0f / d[a] : std::copysign(FLT_MAX, d[a]);
+        }
+
+        uint32_t build_recursive(std::vector<Node>& nodes, std::vector<BuildTriangle>& tris, size_t begin, size_t end)
+        {
+            const uint32_t ni = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+
+            Bin box, centroids;
+            for (size_t i = begin; i < end; i++)
+            {
+                box.grow(tris[i].min, tris[i].max);
+                centroids.grow(tris[i].centroid, tris[i].centroid);
+            }
+            std::copy(box.min, box.min + 3, nodes[ni].min);
+            std::copy(box.max, box.max + 3, nodes[ni].max);
+
+            const size_t n = end - begin;
+            if (n <= 1)
+            {
+                make_leaf(nodes[ni], begin, n);
+                return ni;
+            }
+
+            // Cheapest split over all axes and bin boundaries, by the surface area heuristic
+            int best_axis = -1;
+            size_t best_split = 0;
+            float best_cost = FLT_MAX;
+            for (int a = 0; a < 3; a++)
+            {
+                const float extent = centroids.max[a] - centroids.min[a];
+                if (extent <= 0.0f) continue;
+                const float scale = SahBins / extent;
+
+                Bin bins[SahBins];
+                for (size_t i = begin; i < end; i++)
+                {
+                    Bin& bin = bins[bin_index(tris[i].centroid[a], centroids.min[a], scale)];
+                    bin.grow(tris[i].min, tris[i].max);
+                    bin.count++;
+                }
+
+                // Sweep from the right to get the cost of everything above each boundary
+                float right_cost[SahBins];
+                Bin right;
+                for (size_t b = SahBins - 1; b > 0; b--)
+                {
+                    right.grow(bins[b].min, bins[b].max);
+                    right.count += bins[b].count;
+                    right_cost[b] = right.half_area() * float(right.count);
+                }
+                Bin left;
+                for (size_t b = 0; b + 1 < SahBins; b++)
+                {
+                    left.grow(bins[b].min, bins[b].max);
+                    left.count += bins[b].count;
+                    const float cost = left.half_area() * float(left.count) + right_cost[b + 1];
+                    if (left.count > 0 && left.count < n && cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = a;
+                        best_split = b + 1;
+                    }
+                }
+            }
+
+            // A leaf is cheaper when intersecting all of its triangles costs less than traversing
+            // one node and then the children's triangles
+            const float leaf_cost = box.half_area() * float(n);
+            if (n <= MaxLeafSize && (best_axis < 0 || best_cost + box.half_area() >= leaf_cost))
+            {
+                make_leaf(nodes[ni], begin, n);
+                return ni;
+            }
+
+            size_t mid;
+            if (best_axis >= 0)
+            {
+                const float scale = SahBins / (centroids.max[best_axis] - centroids.min[best_axis]);
+                const float cmin = centroids.min[best_axis];
+                mid = std::partition(tris.begin() + begin, tris.begin() + end, [&](const BuildTriangle& t)
+                    {
+                        return bin_index(t.centroid[best_axis], cmin, scale) < best_split;
+                    }) - tris.begin();
+            }
+            else
+            {
+                // All centroids coincide: split in the middle
+                mid = begin + n / 2;
+            }
+
+            build_recursive(nodes, tris, begin, mid);
+            const uint32_t right = build_recursive(nodes, tris, mid, end);
+            nodes[ni].index = right;
+            nodes[ni].count = 0;
+            return ni;
+        }
+
+        static size_t bin_index(float c, float cmin, float scale)
+        {
+            return std::min(SahBins - 1, static_cast<size_t>((c - cmin) * scale));
+        }
+
+        static void make_leaf(Node& node, size_t first, size_t count)
+        {
+            node.index = static_cast<uint32_t>(first);
+            node.count = static_cast<uint32_t>(count);
+        }
+
+        // Node access, common to both node formats
+        void node_bounds(size_t i, float bmin[3], float bmax[3]) const
+        {
+            if (m_quantized)
+            {
+                const QuantizedNode& q = m_qnodes[i];
+                for (int a = 0; a < 3; a++)
+                {
+                    bmin[a] = m_min[a] + q.qmin[a] * m_step[a];
+                    bmax[a] = m_min[a] + q.qmax[a] * m_step[a];
+                }
+            }
+            else
+            {
+                std::copy(m_nodes[i].min, m_nodes[i].min + 3, bmin);
+                std::copy(m_nodes[i].max, m_nodes[i].max + 3, bmax);
+            }
+        }
+        uint32_t node_index(size_t i) const { return m_quantized ? m_qnodes[i].data >> 4 : m_nodes[i].index; }
+        uint32_t node_count(size_t i) const { return m_quantized ? m_qnodes[i].data & 0xfu : m_nodes[i].count; }
+
+        /// Visits triangles in leaves whose boxes overlap [qmin, qmax]. leaf(k) returns true to stop.
+        template<class F>
+        void traverse_box(const float qmin[3], const float qmax[3], F&& leaf) const
+        {
+            if (empty()) return;
+            uint32_t stack[64];
+            size_t top = 0;
+            stack[top++] = 0;
+            while (top)
+            {
+                const uint32_t ni = stack[--top];
+                float bmin[3], bmax[3];
+                node_bounds(ni, bmin, bmax);
+                if (bmin[0] > qmax[0] || qmin[0] > bmax[0] || bmin[1] > qmax[1] ||
+                    qmin[1] > bmax[1] || bmin[2] > qmax[2] || qmin[2] > bmax[2])
+                    continue;
+
+                if (const uint32_t count = node_count(ni))
+                {
+                    for (uint32_t k = node_index(ni); k < node_index(ni) + count; k++)
+                        if (leaf(k)) return;
+                }
+                else
+                {
+                    stack[top++] = node_index(ni);
+                    stack[top++] = ni + 1;
+                }
+            }
+        }
+
+        /// Visits leaves hit by the ray, nearer child first. t_max may shrink as leaf(k) finds hits.
+        template<class F>
+        void traverse_ray(const float o[3], const float inv_d[3], const float& t_max, F&& leaf) const
+        {
+            if (empty()) return;
+            uint32_t stack[64];
+            size_t top = 0;
+            float t;
+            if (!ray_box(0, o, inv_d, t_max, t)) return;
+            stack[top++] = 0;
+            while (top)
+            {
+                const uint32_t ni = stack[--top];
+                if (const uint32_t count = node_count(ni))
+                {
+                    for (uint32_t k = node_index(ni); k < node_index(ni) + count; k++)
+                        if (leaf(k)) return;
+                    continue;
+                }
+
+                const uint32_t left = ni + 1, right = node_index(ni);
+                float tl, tr;
+                const bool hit_left = ray_box(left, o, inv_d, t_max, tl);
+                const bool hit_right = ray_box(right, o, inv_d, t_max, tr);
+                if (hit_left && hit_right)
+                {
+                    // Push the far child first so the near one is visited first
+                    stack[top++] = tl <= tr ? right : left;
+                    stack[top++] = tl <= tr ? left : right;
+                }
+                else if (hit_left) stack[top++] = left;
+                else if (hit_right) stack[top++] = right;
+            }
+        }
+
+        bool ray_box(size_t ni, const float o[3], const float inv_d[3], float t_max, float& t_entry) const
+        {
+            float bmin[3], bmax[3];
+            node_bounds(ni, bmin, bmax);
+            float t_near = 0.0f, t_far = t_max;
+            for (int a = 0; a < 3; a++)
+            {
+                const float near_plane = inv_d[a] >= 0.0f ? bmin[a] : bmax[a];
+                const float far_plane = inv_d[a] >= 0.0f ? bmax[a] : bmin[a];
+                t_near = std::max(t_near, (near_plane - o[a]) * inv_d[a]);
+                t_far = std::min(t_far, (far_plane - o[a]) * inv_d[a]);
+            }
+            t_entry = t_near;
+            return t_near <= t_far;
+        }
+
+        // Moller-Trumbore, two-sided
+        bool ray_triangle(const float o[3], const float d[3], size_t k, float t_max, float& t) const
+        {
+            const float* v = &m_vertices[9 * k];
+            const float e1[3]{ v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+            const float e2[3]{ v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+            float p[3];
+            cross(d, e2, p);
+            const float det = dot(e1, p);
+            if (std::abs(det) < 1e-12f) return false;
+            const float inv_det = 1.0f / det;
+            const float s[3]{ o[0] - v[0], o[1] - v[1], o[2] - v[2] };
+            const float u = dot(s, p) * inv_det;
+            if (u < 0.0f || u > 1.0f) return false;
+            float q[3];
+            cross(s, e1, q);
+            const float w = dot(d, q) * inv_det;
+            if (w < 0.0f || u + w > 1.0f) return false;
+            t = dot(e2, q) * inv_det;
+            return t >= 0.0f && t <= t_max;
+        }
+
+        void face_normal(size_t k, const float d[3], float n[3]) const
+        {
+            const float* v = &m_vertices[9 * k];
+            const float e1[3]{ v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+            const float e2[3]{ v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+            cross(e1, e2, n);
+            float len = std::sqrt(dot(n, n));
+            if (dot(n, d) > 0.0f) len = -len;
+            for (int a = 0; a < 3; a++) n[a] /= len;
+        }
+
+        // Closest point on triangle k to p, by Voronoi regions (Ericson, Real-Time Collision Detection 5.1.5)
+        void closest_point(size_t k, const float p[3], float out[3]) const
+        {
+            const float* a = &m_vertices[9 * k];
+            const float* b = a + 3;
+            const float* c = a + 6;
+            const float ab[3]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            const float ac[3]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            const float ap[3]{ p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+            auto set = [&](const float* base, float s, const float* e1, float t, const float* e2)
+                {
+                    for (int i = 0; i < 3; i++) out[i] = base[i] + s * e1[i] + t * e2[i];
+                };
+            const float zero[3]{};
+
+            const float d1 = dot(ab, ap), d2 = dot(ac, ap);
+            if (d1 <= 0.0f && d2 <= 0.0f) return set(a, 0.0f, zero, 0.0f, zero);
+
+            const float bp[3]{ p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+            const float d3 = dot(ab, bp), d4 = dot(ac, bp);
+            if (d3 >= 0.0f && d4 <= d3) return set(b, 0.0f, zero, 0.0f, zero);
+
+            const float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return set(a, d1 / (d1 - d3), ab, 0.0f, zero);
+
+            const float cp[3]{ p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+            const float d5 = dot(ab, cp), d6 = dot(ac, cp);
+            if (d6 >= 0.0f && d5 <= d6) return set(c, 0.0f, zero, 0.0f, zero);
+
+            const float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return set(a, 0.0f, zero, d2 / (d2 - d6), ac);
+
+            const float va = d3 * d6 - d5 * d4;
+            if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            {
+                const float bc[3]{ c[0] - b[0], c[1] - b[1], c[2] - b[2] };
+                return set(b, (d4 - d3) / ((d4 - d3) + (d5 - d6)), bc, 0.0f, zero);
+            }
+
+            const float denom = 1.0f / (va + vb + vc);
+            set(a, vb * denom, ab, vc * denom, ac);
+        }
+
+        // Separating axis test of triangle k against a box (Akenine-Moller)
+        bool triangle_overlaps_box(size_t k, const float bmin[3], const float bmax[3]) const
+        {
+            float center[3], half[3], v[3][3];
+            for (int a = 0; a < 3; a++)
+            {
+                center[a] = 0.5f * (bmin[a] + bmax[a]);
+                half[a] = 0.5f * (bmax[a] - bmin[a]);
+            }
+            for (int i = 0; i < 3; i++)
+                for (int a = 0; a < 3; a++)
+                    v[i][a] = m_vertices[9 * k + 3 * i + a] - center[a];
+
+            // Box face normals
+            for (int a = 0; a < 3; a++)
+            {
+                const float lo = std::min({ v[0][a], v[1][a], v[2][a] });
+                const float hi = std::max({ v[0][a], v[1][a], v[2][a] });
+                if (lo > half[a] || hi < -half[a]) return false;
+            }
+
+            const float e[3][3]{
+                { v[1][0] - v[0][0], v[1][1] - v[0][1], v[1][2] - v[0][2] },
+                { v[2][0] - v[1][0], v[2][1] - v[1][1], v[2][2] - v[1][2] },
+                { v[0][0] - v[2][0], v[0][1] - v[2][1], v[0][2] - v[2][2] } };
+
+            // Triangle normal
+            float n[3];
+            cross(e[0], e[1], n);
+            const float r = half[0] * std::abs(n[0]) + half[1] * std::abs(n[1]) + half[2] * std::abs(n[2]);
+            if (std::abs(dot(n, v[0])) > r) return false;
+
+            // Cross products of box axes and triangle edges
+            for (int i = 0; i < 3; i++)
+            {
+                for (int a = 0; a < 3; a++)
+                {
+                    const float unit[3]{ float(a == 0), float(a == 1), float(a == 2) };
+                    float axis[3];
+                    cross(unit, e[i], axis);
+                    const float p0 = dot(axis, v[0]), p1 = dot(axis, v[1]), p2 = dot(axis, v[2]);
+                    const float rad = half[0] * std::abs(axis[0]) + half[1] * std::abs(axis[1]) + half[2] * std::abs(axis[2]);
+                    if (std::min({ p0, p1, p2 }) > rad || std::max({ p0, p1, p2 }) < -rad) return false;
+                }
+            }
+            return true;
+        }
+
+        static float dot(const float a[3], const float b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+        static void cross(const float a[3], const float b[3], float out[3])
+        {
+            out[0] = a[1] * b[2] - a[2] * b[1];
+            out[1] = a[2] * b[0] - a[0] * b[2];
+            out[2] = a[0] * b[1] - a[1] * b[0];
+        }
+
+        bool m_quantized = false;
+        float m_min[3]{}, m_max[3]{};
+        float m_step[3]{ 1.0f, 1.0f, 1.0f };    // Size of one quantization step per axis
+        std::vector<Node> m_nodes;
+        std::vector<QuantizedNode> m_qnodes;
+        std::vector<float> m_vertices;          // 9 floats per triangle, in leaf order
+        std::vector<uint32_t> m_ids;            // Input index per triangle, in leaf order
+    };
+
+} // namespace eeng
+
+#endif
@@ -0,0 +1,131 @@
+// Licensed under the MIT License. See LICENSE file for details.
+
+#ifndef EENG_WorkStealingDeque_h
+#define EENG_WorkStealingDeque_h
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+
+namespace eeng
+{
+    /// @brief Chase-Lev work-stealing deque of pointers
+    /** One owner thread pushes and pops at the bottom, last in first out, which keeps recently
+     * pushed work and its data warm in the owner's cache. Any other thread may steal from the
+     * top, first in first out, taking the oldest and typically largest pieces of work. Pops and
+     * steals only contend on the last item.
+     *
+     * Follows Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+     * Memory Models" (PPoPP 2013). The ring grows when full; arrays it outgrows are kept until
+     * the deque is destroyed, since a thief may still be reading one.
+     */
+    template<class T>
+    class WorkStealingDeque
+    {
+        static_assert(std::is_pointer_v<T>, "Items are pointers");
+
+    public:
+        explicit WorkStealingDeque(int64_t capacity = 256)
+        {
+            int64_t c = 1;
+            while (c < capacity) c <<= 1;
+            m_arrays.push_back(std::make_unique<Array>(c));
+            m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /// @brief Owner only
+        void push(T item)
+        {
+            const int64_t b = m_bottom.load(std::memory_order_relaxed);
+            const int64_t t = m_top.load(std::memory_order_acquire);
+            Array* a = m_array.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1) a = grow(a, t, b);
+            a->put(b, item);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /// @brief Owner only. Takes the most recently pushed item.
+        bool pop(T& item)
+        {
+            const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+            Array* a = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = m_top.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                // Empty
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            item = a->get(b);
+            if (t == b)
+            {
+                // Last item: race the thieves for it
+                const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /// @brief Any thread. Takes the oldest item. May fail spuriously when racing another thread for it.
+        bool steal(T& item)
+        {
+            int64_t t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t b = m_bottom.load(std::memory_order_acquire);
+            if (t >= b) return false;
+
+            Array* a = m_array.load(std::memory_order_acquire);
+            T x = a->get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return false;
+            item = x;
+            return true;
+        }
+
+        /// @brief Approximate, for heuristics only
+        bool empty() const
+        {
+            return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Array
+        {
+            explicit Array(int64_t c) : capacity(c), mask(c - 1), items(new std::atomic<T>[size_t(c)]) {}
+
+            T get(int64_t i) const { return items[i & mask].load(std::memory_order_relaxed); }
+            void put(int64_t i, T item) { items[i & mask].store(item, std::memory_order_relaxed); }
+
+            const int64_t capacity, mask;
+            std::unique_ptr<std::atomic<T>[]> items;
+        };
+
+        Array* grow(Array* a, int64_t t, int64_t b)
+        {
+            auto bigger = std::make_unique<Array>(a->capacity * 2);
+            for (int64_t i = t; i < b; i++) bigger->put(i, a->get(i));
+            Array* result = bigger.get();
+            m_arrays.push_back(std::move(bigger));
+            m_array.store(result, std::memory_order_release);
+            return result;
+        }
+
+        alignas(64) std::atomic<int64_t> m_top{ 0 };
+        alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+        std::atomic<Array*> m_array{ nullptr };
+        std::vector<std::unique_ptr<Array>> m_arrays;   // Owner only, every array ever used
+    };
+
+} // namespace eeng
+
+#endif
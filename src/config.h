@@ -51,6 +51,20 @@
 #define EENG_COMPILER_GCC
 #endif
 
+/// SIMD instruction sets available at compile time
+#if defined(__AVX512F__)
+#define EENG_SIMD_AVX512
+#endif
+#if defined(__AVX__)
+#define EENG_SIMD_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EENG_SIMD_SSE
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define EENG_SIMD_NEON
+#endif
+
 /// Debug
 #if !defined(NDEBUG) || defined(_DEBUG)
 #define EENG_DEBUG
@@ -0,0 +1,67 @@
+#include "AABBTree.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    struct Boxes
+    {
+        std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+
+        void add(float x, float y, float z, float h)
+        {
+            min_x.push_back(x - h); min_y.push_back(y - h); min_z.push_back(z - h);
+            max_x.push_back(x + h); max_y.push_back(y + h); max_z.push_back(z + h);
+        }
+        size_t size() const { return min_x.size(); }
+    };
+}
+
+TEST(AABBTreeTest, EmptyTreeReportsNothing) {
+    eeng::AABBTree tree;
+    tree.build(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0);
+    EXPECT_TRUE(tree.empty());
+    const float qmin[3]{ -1, -1, -1 }, qmax[3]{ 1, 1, 1 };
+    size_t hits = 0;
+    tree.query(qmin, qmax, [&](uint32_t) { hits++; });
+    EXPECT_EQ(hits, 0u);
+}
+
+TEST(AABBTreeTest, QueryMatchesBruteForce) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> size(0.2f, 3.0f);
+
+    Boxes boxes;
+    for (int i = 0; i < 500; i++)
+        boxes.add(pos(rng), pos(rng) * 0.1f, pos(rng), size(rng));
+
+    std::vector<uint32_t> ids(boxes.size());
+    for (size_t i = 0; i < ids.size(); i++) ids[i] = uint32_t(1000 + i);
+
+    eeng::AABBTree tree;
+    tree.build(boxes.min_x.data(), boxes.min_y.data(), boxes.min_z.data(),
+        boxes.max_x.data(), boxes.max_y.data(), boxes.max_z.data(), boxes.size(), ids.data());
+
+    for (int q = 0; q < 100; q++)
+    {
+        const float c[3]{ pos(rng), pos(rng) * 0.1f, pos(rng) };
+        const float h = size(rng) * 2.0f;
+        const float qmin[3]{ c[0] - h, c[1] - h, c[2] - h }, qmax[3]{ c[0] + h, c[1] + h, c[2] + h };
+
+        std::vector<uint32_t> found;
+        tree.query(qmin, qmax, [&](uint32_t id) { found.push_back(id); });
+
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < boxes.size(); i++)
+            if (boxes.min_x[i] <= qmax[0] && qmin[0] <= boxes.max_x[i] &&
+                boxes.min_y[i] <= qmax[1] && qmin[1] <= boxes.max_y[i] &&
+                boxes.min_z[i] <= qmax[2] && qmin[2] <= boxes.max_z[i])
+                expected.push_back(ids[i]);
+
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    }
+}
@@ -0,0 +1,84 @@
+#include "AssetRegistry.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    struct Mesh
+    {
+        std::string path;
+        int loads = 0;
+    };
+
+    using Registry = eeng::AssetRegistry<Mesh>;
+}
+
+TEST(AssetRegistryTest, LoadsOnceAndCountsReferences) {
+    static_assert(std::is_trivially_copyable_v<Registry::Handle>);
+    static_assert(sizeof(Registry::Handle) == 4);
+
+    Registry registry;
+    int inits = 0;
+    auto init = [&](Mesh& mesh) { mesh.path = "horse.fbx"; mesh.loads = ++inits; };
+
+    const auto a = registry.load("horse", init);
+    const auto b = registry.load("horse", init);
+    EXPECT_TRUE(a);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(inits, 1);
+    EXPECT_EQ(registry.ref_count(a), 2u);
+    EXPECT_EQ(registry.get(a)->path, "horse.fbx");
+    EXPECT_EQ(registry.name(a), "horse");
+    EXPECT_EQ(registry.find("horse"), a);
+    EXPECT_FALSE(registry.find("grass"));
+
+    EXPECT_FALSE(registry.release(a));
+    EXPECT_TRUE(registry.valid(a));
+    EXPECT_TRUE(registry.release(b));
+    EXPECT_FALSE(registry.valid(a));
+    EXPECT_EQ(registry.get(a), nullptr);
+    EXPECT_EQ(registry.ref_count(a), 0u);
+    EXPECT_EQ(registry.size(), 0u);
+
+    // Loading again creates a new asset, and the old handle stays stale although the slot is reused
+    const auto c = registry.load("horse", init);
+    EXPECT_EQ(inits, 2);
+    EXPECT_EQ(c.index(), a.index());
+    EXPECT_NE(c, a);
+    EXPECT_EQ(registry.get(a), nullptr);
+    EXPECT_EQ(registry.get(c)->loads, 2);
+
+    EXPECT_EQ(registry.get(Registry::Handle{}), nullptr);
+}
+
+TEST(AssetRegistryTest, HandlesSurviveCompactionAndReplacement) {
+    Registry registry;
+    std::vector<Registry::Handle> handles;
+    for (int i = 0; i < 100; i++)
+        handles.push_back(registry.add("mesh" + std::to_string(i), std::make_unique<Mesh>(Mesh{ std::to_string(i) })));
+
+    // Unloading moves assets from the back into the gaps
+    for (int i = 0; i < 100; i += 3)
+        EXPECT_TRUE(registry.release(handles[i]));
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 3 == 0) EXPECT_EQ(registry.get(handles[i]), nullptr);
+        else EXPECT_EQ(registry.get(handles[i])->path, std::to_string(i));
+    }
+
+    size_t visited = 0;
+    registry.for_each([&](Registry::Handle handle, const Mesh& mesh) {
+        EXPECT_EQ(registry.get(handle), &mesh);
+        visited++;
+    });
+    EXPECT_EQ(visited, registry.size());
+
+    // A streamed-in version takes the place of the old one under the same handle
+    auto old = registry.replace(handles[1], std::make_unique<Mesh>(Mesh{ "1 (high detail)" }));
+    EXPECT_EQ(old->path, "1");
+    EXPECT_EQ(registry.get(handles[1])->path, "1 (high detail)");
+    EXPECT_EQ(registry.ref_count(handles[1]), 1u);
+}
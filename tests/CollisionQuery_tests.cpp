@@ -0,0 +1,207 @@
+#include "CollisionQuery.h"
+#include "AABBTree.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    using namespace eeng;
+
+    ColliderSoA make_random_colliders(size_t n, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> size(0.2f, 2.0f);
+        std::uniform_int_distribution<int> kind(0, 2);
+
+        ColliderSoA soa;
+        for (size_t i = 0; i < n; i++)
+        {
+            const float c[3]{ pos(rng), pos(rng), pos(rng) };
+            const float h = size(rng);
+            const float mn[3]{ c[0] - h, c[1] - h, c[2] - h };
+            const float mx[3]{ c[0] + h, c[1] + h, c[2] + h };
+            const uint8_t flags = kind(rng) == 0 ? ColliderHasSphere : ColliderHasSphere | ColliderHasAABB;
+            soa.push((uint32_t)i, flags, c, h, mn, mx);
+        }
+        soa.pad();
+        return soa;
+    }
+
+    RayQuery random_ray(std::mt19937& rng, float radius = 0.0f)
+    {
+        std::uniform_real_distribution<float> pos(-25.0f, 25.0f);
+        std::normal_distribution<float> dir(0.0f, 1.0f);
+        const float o[3]{ pos(rng), pos(rng), pos(rng) };
+        float d[3]{ dir(rng), dir(rng), dir(rng) };
+        const float len = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        for (auto& v : d) v /= len;
+        return RayQuery::make(o, d, 60.0f, radius);
+    }
+}
+
+TEST(CollisionQueryTest, RayHitsBoxAtEntryDistance) {
+    ColliderSoA soa;
+    const float c[3]{ 5.0f, 0.0f, 0.0f }, mn[3]{ 4.0f, -1.0f, -1.0f }, mx[3]{ 6.0f, 1.0f, 1.0f };
+    soa.push(0, ColliderHasSphere | ColliderHasAABB, c, 1.0f, mn, mx);
+    soa.pad();
+
+    const float o[3]{ 0.0f, 0.0f, 0.0f }, d[3]{ 1.0f, 0.0f, 0.0f }, back[3]{ -1.0f, 0.0f, 0.0f };
+    float t[16];
+    EXPECT_EQ(ray_aabbs<16>(ColliderLanes(soa, 0), RayQuery::make(o, d), t), 1u);
+    EXPECT_FLOAT_EQ(t[0], 4.0f);
+    EXPECT_EQ(ray_aabbs<16>(ColliderLanes(soa, 0), RayQuery::make(o, back), t), 0u);
+    EXPECT_EQ(ray_aabbs<16>(ColliderLanes(soa, 0), RayQuery::make(o, d, 3.0f), t), 0u);
+
+    // Sphere-cast along the box edge
+    const float above[3]{ 0.0f, 1.4f, 0.0f };
+    EXPECT_EQ(ray_aabbs<16>(ColliderLanes(soa, 0), RayQuery::make(above, d), t), 0u);
+    EXPECT_EQ(ray_aabbs<16>(ColliderLanes(soa, 0), RayQuery::make(above, d, FLT_MAX, 0.5f), t), 1u);
+    EXPECT_FLOAT_EQ(t[0], 3.5f);
+
+    float ts;
+    EXPECT_EQ(ray_spheres_scalar(ColliderLanes(soa, 0), RayQuery::make(o, d), 1, &ts), 1u);
+    EXPECT_FLOAT_EQ(ts, 4.0f);
+}
+
+TEST(CollisionQueryTest, SlabKernelsMatchScalar) {
+    ColliderSoA soa = make_random_colliders(100, 11);
+    std::mt19937 rng(12);
+    for (int r = 0; r < 200; r++)
+    {
+        const RayQuery q = random_ray(rng, r % 2 ? 0.3f : 0.0f);
+        for (size_t first = 0; first < soa.count; first += 16)
+        {
+            const ColliderLanes lanes(soa, first);
+            float t_ref[16], t4[16], t8[16], t16[16];
+            const uint32_t ref = ray_aabbs_scalar(lanes, q, 16, t_ref);
+            const uint32_t m4 = ray_aabbs<4>(lanes, q, t4) | (ray_aabbs<4>(lanes.offset(4), q, t4 + 4) << 4) |
+                (ray_aabbs<4>(lanes.offset(8), q, t4 + 8) << 8) | (ray_aabbs<4>(lanes.offset(12), q, t4 + 12) << 12);
+            const uint32_t m8 = ray_aabbs<8>(lanes, q, t8) | (ray_aabbs<8>(lanes.offset(8), q, t8 + 8) << 8);
+            const uint32_t m16 = ray_aabbs<16>(lanes, q, t16);
+            EXPECT_EQ(m4, ref);
+            EXPECT_EQ(m8, ref);
+            EXPECT_EQ(m16, ref);
+            for (int k = 0; k < 16; k++)
+                if (ref >> k & 1u)
+                {
+                    EXPECT_FLOAT_EQ(t4[k], t_ref[k]);
+                    EXPECT_FLOAT_EQ(t16[k], t_ref[k]);
+                }
+        }
+    }
+}
+
+TEST(CollisionQueryTest, EmptyBoxesAreNeverHit) {
+    ColliderSoA soa = make_random_colliders(64, 13);
+    std::mt19937 rng(14);
+    for (int r = 0; r < 100; r++)
+    {
+        const RayQuery q = random_ray(rng);
+        for (size_t first = 0; first < soa.padded_count(); first += 16)
+        {
+            float t[16];
+            const uint32_t hits = ray_aabbs<16>(ColliderLanes(soa, first), q, t);
+            for (int k = 0; k < 16; k++)
+                if (hits >> k & 1u)
+                {
+                    EXPECT_TRUE(first + k < soa.count && (soa.flags[first + k] & ColliderHasAABB));
+                }
+        }
+    }
+}
+
+TEST(CollisionQueryTest, TreeRaycastMatchesBruteForce) {
+    ColliderSoA soa = make_random_colliders(300, 15);
+    std::vector<uint32_t> boxed;
+    for (size_t i = 0; i < soa.count; i++)
+        if (soa.flags[i] & ColliderHasAABB) boxed.push_back((uint32_t)i);
+
+    // Tree over the boxed colliders only
+    std::vector<float> b[6];
+    for (uint32_t i : boxed)
+    {
+        b[0].push_back(soa.min_x[i]); b[1].push_back(soa.min_y[i]); b[2].push_back(soa.min_z[i]);
+        b[3].push_back(soa.max_x[i]); b[4].push_back(soa.max_y[i]); b[5].push_back(soa.max_z[i]);
+    }
+    AABBTree tree;
+    tree.build(b[0].data(), b[1].data(), b[2].data(), b[3].data(), b[4].data(), b[5].data(), boxed.size(), boxed.data());
+
+    std::mt19937 rng(16);
+    for (int r = 0; r < 200; r++)
+    {
+        const RayQuery q = random_ray(rng);
+
+        float closest = q.t_max;
+        tree.raycast(q.o, q.inv_d, q.t_max, 0.0f, [&](uint32_t i, float t_max) {
+            float t;
+            if (ray_aabbs_scalar(ColliderLanes(soa, i), q, 1, &t) && t < t_max)
+                closest = t_max = t;
+            return t_max;
+        });
+
+        float expected = q.t_max;
+        for (uint32_t i : boxed)
+        {
+            float t;
+            if (ray_aabbs_scalar(ColliderLanes(soa, i), q, 1, &t))
+                expected = std::min(expected, t);
+        }
+        EXPECT_FLOAT_EQ(closest, expected);
+    }
+}
+
+TEST(CollisionQueryTest, SphereCastRoundsBoxEdges) {
+    const float mn[3]{ 0.0f, 0.0f, 0.0f }, mx[3]{ 1.0f, 1.0f, 1.0f }, d[3]{ 1.0f, 0.0f, 0.0f };
+    float t;
+
+    // Passes over the top face and meets the edge at x = 0, y = 1 where x^2 + 0.3^2 = 0.5^2
+    const float over_edge[3]{ -5.0f, 1.3f, 0.5f };
+    ASSERT_TRUE(sphere_cast_aabb(RayQuery::make(over_edge, d, 10.0f, 0.5f), mn, mx, t));
+    EXPECT_NEAR(t, 4.6f, 1e-3f);
+
+    // Clears the corner edge, which the box grown by the radius would not
+    const float past_corner[3]{ -5.0f, 1.4f, 1.4f };
+    EXPECT_FALSE(sphere_cast_aabb(RayQuery::make(past_corner, d, 10.0f, 0.5f), mn, mx, t));
+    ColliderSoA soa;
+    soa.push(0, ColliderHasAABB, mn, 0.0f, mn, mx);
+    soa.pad();
+    EXPECT_TRUE(ray_aabbs_scalar(ColliderLanes(soa, 0), RayQuery::make(past_corner, d, 10.0f, 0.5f), 1, &t));
+
+    // Origins within the radius hit at once
+    const float touching[3]{ -0.4f, 0.5f, 0.5f };
+    ASSERT_TRUE(sphere_cast_aabb(RayQuery::make(touching, d, 10.0f, 0.5f), mn, mx, t));
+    EXPECT_EQ(t, 0.0f);
+}
+
+TEST(CollisionQueryTest, SphereCastFindsTimeOfImpact) {
+    float t;
+
+    // Plane y = 0, from above and from below
+    const float point[3]{ 0.0f, 0.0f, 0.0f }, up[3]{ 0.0f, 1.0f, 0.0f }, down[3]{ 0.0f, -1.0f, 0.0f };
+    const float above[3]{ 0.0f, 5.0f, 0.0f }, below[3]{ 0.0f, -3.0f, 0.0f };
+    ASSERT_TRUE(sphere_cast_plane(RayQuery::make(above, down, 10.0f, 1.0f), point, up, t));
+    EXPECT_FLOAT_EQ(t, 4.0f);
+    ASSERT_TRUE(sphere_cast_plane(RayQuery::make(below, up, 10.0f, 1.0f), point, up, t));
+    EXPECT_FLOAT_EQ(t, 2.0f);
+    EXPECT_FALSE(sphere_cast_plane(RayQuery::make(above, up, 10.0f, 1.0f), point, up, t));
+    EXPECT_FALSE(sphere_cast_plane(RayQuery::make(above, down, 3.0f, 1.0f), point, up, t));
+
+    // A fast sphere against a wall much thinner than its step, and against a sphere behind it
+    ColliderSoA soa;
+    const float wall_c[3]{ 0.025f, 0.0f, 0.0f }, wall_min[3]{ 0.0f, -1.0f, -1.0f }, wall_max[3]{ 0.05f, 1.0f, 1.0f };
+    const float ball_c[3]{ 3.0f, 0.0f, 0.0f };
+    soa.push(0, ColliderHasAABB, wall_c, 0.0f, wall_min, wall_max);
+    soa.push(1, ColliderHasSphere, ball_c, 0.5f, ball_c, ball_c);
+    soa.pad();
+
+    const float o[3]{ -5.0f, 0.0f, 0.0f }, d[3]{ 1.0f, 0.0f, 0.0f };
+    const RayQuery q = RayQuery::make(o, d, 10.0f, 0.2f);
+    ASSERT_TRUE(sphere_cast_collider(soa, 0, q, t));
+    EXPECT_NEAR(t, 4.8f, 1e-4f);
+    ASSERT_TRUE(sphere_cast_collider(soa, 1, q, t));
+    EXPECT_NEAR(t, 7.3f, 1e-4f);
+}
@@ -0,0 +1,199 @@
+#include "CollisionSoA.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace
+{
+    using namespace eeng;
+
+    ColliderSoA make_random_colliders(size_t n, unsigned seed, float extent)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-extent, extent);
+        std::uniform_real_distribution<float> size(0.1f, 2.0f);
+        std::uniform_int_distribution<int> kind(0, 3);
+
+        ColliderSoA soa;
+        for (size_t i = 0; i < n; i++)
+        {
+            const float c[3]{ pos(rng), pos(rng), pos(rng) };
+            const float h = size(rng);
+            const float mn[3]{ c[0] - h, c[1] - h, c[2] - h };
+            const float mx[3]{ c[0] + h, c[1] + h, c[2] + h };
+            uint8_t flags = 0;
+            switch (kind(rng))
+            {
+            case 0: flags = ColliderHasSphere; break;
+            case 1: flags = ColliderHasAABB; break;
+            default: flags = ColliderHasSphere | ColliderHasAABB; break;
+            }
+            soa.push((uint32_t)i, flags, c, h, mn, mx);
+        }
+        soa.pad();
+        return soa;
+    }
+
+    template<class Test>
+    std::vector<std::pair<size_t, size_t>> brute_force_pairs(const ColliderSoA& soa, const Test& test)
+    {
+        std::vector<std::pair<size_t, size_t>> pairs;
+        for (size_t i = 0; i < soa.count; i++)
+        {
+            const auto q = ColliderQuery::from(soa, i);
+            for (size_t j = i + 1; j < soa.count; j++)
+                if (test(ColliderLanes(soa, j), q, 1) & 1u)
+                    pairs.push_back({ i, j });
+        }
+        return pairs;
+    }
+}
+
+TEST(CollisionSoATest, PaddingUsesSentinels) {
+    ColliderSoA soa = make_random_colliders(5, 1, 10.0f);
+    EXPECT_EQ(soa.count, 5u);
+    EXPECT_EQ(soa.padded_count(), CollisionMaxBatchWidth);
+
+    const auto q = ColliderQuery::from(soa, 0);
+    const ColliderLanes lanes(soa, 0);
+    // Lanes beyond the last collider never overlap
+    EXPECT_EQ(overlap_spheres<16>(lanes, q) >> 5, 0u);
+    EXPECT_EQ(overlap_aabbs<16>(lanes, q) >> 5, 0u);
+}
+
+TEST(CollisionSoATest, PushAfterPadKeepsOrder) {
+    ColliderSoA soa = make_random_colliders(3, 2, 10.0f);
+    const float c[3]{ 1.0f, 2.0f, 3.0f };
+    soa.push(42, ColliderHasSphere | ColliderHasAABB, c, 0.5f, c, c);
+    soa.pad();
+    EXPECT_EQ(soa.count, 4u);
+    EXPECT_EQ(soa.owner[3], 42u);
+    EXPECT_FLOAT_EQ(soa.center_y[3], 2.0f);
+    EXPECT_EQ(soa.padded_count(), CollisionMaxBatchWidth);
+}
+
+TEST(CollisionSoATest, SphereKernelsMatchScalar) {
+    ColliderSoA soa = make_random_colliders(200, 3, 10.0f);
+    for (size_t i = 0; i < soa.count; i++)
+    {
+        const auto q = ColliderQuery::from(soa, i);
+        for (size_t first = 0; first < soa.count; first += 16)
+        {
+            const ColliderLanes lanes(soa, first);
+            const uint32_t ref = overlap_spheres_scalar(lanes, q, 16);
+            EXPECT_EQ(overlap_spheres<4>(lanes, q), ref & 0xFu);
+            EXPECT_EQ(overlap_spheres<8>(lanes, q), ref & 0xFFu);
+            EXPECT_EQ(overlap_spheres<16>(lanes, q), ref);
+        }
+    }
+}
+
+TEST(CollisionSoATest, AABBKernelsMatchScalar) {
+    ColliderSoA soa = make_random_colliders(200, 4, 10.0f);
+    for (size_t i = 0; i < soa.count; i++)
+    {
+        const auto q = ColliderQuery::from(soa, i);
+        for (size_t first = 0; first < soa.count; first += 16)
+        {
+            const ColliderLanes lanes(soa, first);
+            const uint32_t ref = overlap_aabbs_scalar(lanes, q, 16);
+            EXPECT_EQ(overlap_aabbs<4>(lanes, q), ref & 0xFu);
+            EXPECT_EQ(overlap_aabbs<8>(lanes, q), ref & 0xFFu);
+            EXPECT_EQ(overlap_aabbs<16>(lanes, q), ref);
+        }
+    }
+}
+
+TEST(CollisionSoATest, PairVisitMatchesBruteForce) {
+    ColliderSoA soa = make_random_colliders(300, 5, 8.0f);
+
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for_each_overlapping_pair(soa, overlap_spheres<CollisionBatchWidth>,
+        [&](size_t i, size_t j) { pairs.push_back({ i, j }); });
+    EXPECT_EQ(pairs, brute_force_pairs(soa, overlap_spheres_scalar));
+
+    pairs.clear();
+    for_each_overlapping_pair<4>(soa, overlap_aabbs<4>,
+        [&](size_t i, size_t j) { pairs.push_back({ i, j }); });
+    EXPECT_EQ(pairs, brute_force_pairs(soa, overlap_aabbs_scalar));
+}
+
+TEST(CollisionSoATest, GatherMatchesDirect) {
+    ColliderSoA soa = make_random_colliders(64, 6, 5.0f);
+    const std::vector<uint32_t> indices{ 3, 17, 40, 41, 9, 63, 0 };
+
+    ColliderGather batch;
+    batch.gather(soa, indices.data(), indices.size());
+
+    const auto q = ColliderQuery::from(soa, 20);
+    const uint32_t sphere_mask = overlap_spheres<16>(batch.lanes(), q);
+    const uint32_t aabb_mask = overlap_aabbs<16>(batch.lanes(), q);
+    for (size_t k = 0; k < indices.size(); k++)
+    {
+        const ColliderLanes lane(soa, indices[k]);
+        EXPECT_EQ((sphere_mask >> k) & 1u, overlap_spheres_scalar(lane, q, 1));
+        EXPECT_EQ((aabb_mask >> k) & 1u, overlap_aabbs_scalar(lane, q, 1));
+    }
+    EXPECT_EQ(sphere_mask >> indices.size(), 0u);
+    EXPECT_EQ(aabb_mask >> indices.size(), 0u);
+
+    ColliderGather spheres_only;
+    spheres_only.gather_spheres(soa, indices.data(), indices.size());
+    EXPECT_EQ(overlap_spheres<16>(spheres_only.lanes(), q), sphere_mask);
+}
+
+TEST(CollisionSoATest, LayerMaskFiltersPairs) {
+    // Three overlapping colliders: two static props and one player
+    constexpr uint32_t Static = 1, Player = 2;
+    ColliderSoA soa;
+    const float c[3]{ 0.0f, 0.0f, 0.0f };
+    const float mn[3]{ -1.0f, -1.0f, -1.0f }, mx[3]{ 1.0f, 1.0f, 1.0f };
+    soa.push(0, ColliderHasSphere | ColliderHasAABB, c, 1.0f, mn, mx, Static, Player);
+    soa.push(1, ColliderHasSphere | ColliderHasAABB, c, 1.0f, mn, mx, Static, Player);
+    soa.push(2, ColliderHasSphere | ColliderHasAABB, c, 1.0f, mn, mx, Player, Static | Player);
+    soa.pad();
+
+    EXPECT_FALSE(soa.layers_interact(0, 1));
+    EXPECT_TRUE(soa.layers_interact(0, 2));
+    EXPECT_EQ(soa.layer_filter(0, 0, 16), 0b100u);
+
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for_each_overlapping_pair(soa, overlap_spheres<CollisionBatchWidth>,
+        [&](size_t i, size_t j) { pairs.push_back({ i, j }); });
+    const std::vector<std::pair<size_t, size_t>> expected{ { 0, 2 }, { 1, 2 } };
+    EXPECT_EQ(pairs, expected);
+}
+
+TEST(CollisionSoATest, ShrinkKeepsPrefix) {
+    ColliderSoA soa = make_random_colliders(40, 8, 5.0f);
+    const float x = soa.min_x[9];
+    soa.shrink(10);
+    EXPECT_EQ(soa.count, 10u);
+    EXPECT_EQ(soa.owner[9], 9u);
+    EXPECT_FLOAT_EQ(soa.min_x[9], x);
+
+    // Pairs restricted to the range after a prefix never include a prefix collider
+    soa = make_random_colliders(100, 9, 4.0f);
+    for_each_overlapping_pair(soa, overlap_aabbs<CollisionBatchWidth>,
+        [&](size_t i, size_t j) { EXPECT_GE(i, 30u); EXPECT_GT(j, i); }, 30);
+}
+
+TEST(CollisionSoATest, BoundsEncloseSphereAndAABB) {
+    ColliderSoA soa;
+    const float c[3]{ 0, 0, 0 }, mn[3]{ 1, -1, -1 }, mx[3]{ 3, 1, 2 };
+    soa.push(0, ColliderHasSphere, c, 1.5f, mn, mx);
+    soa.push(1, ColliderHasAABB, c, 1.5f, mn, mx);
+    soa.push(2, ColliderHasSphere | ColliderHasAABB, c, 1.5f, mn, mx);
+    soa.pad();
+
+    float bmin[3], bmax[3];
+    soa.bounds(0, bmin, bmax);
+    EXPECT_FLOAT_EQ(bmin[0], -1.5f); EXPECT_FLOAT_EQ(bmax[2], 1.5f);
+    soa.bounds(1, bmin, bmax);
+    EXPECT_FLOAT_EQ(bmin[0], 1.0f); EXPECT_FLOAT_EQ(bmax[0], 3.0f);
+    soa.bounds(2, bmin, bmax);
+    EXPECT_FLOAT_EQ(bmin[0], -1.5f); EXPECT_FLOAT_EQ(bmax[0], 3.0f);
+    EXPECT_FLOAT_EQ(bmin[1], -1.5f); EXPECT_FLOAT_EQ(bmax[2], 2.0f);
+}
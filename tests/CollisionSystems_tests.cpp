@@ -0,0 +1,40 @@
+#include "CollisionSystems.h"
+#include <gtest/gtest.h>
+#include <vector>
+#include <unordered_map>
+
+namespace
+{
+    using namespace eeng;
+    using Pairs = std::vector<std::pair<uint32_t, uint32_t>>;
+
+    // A static prop set up like the stress scene's, at index 0, and an NPC overlapping it at index 1
+    Pairs prop_and_npc_pairs(uint32_t npc_mask)
+    {
+        ColliderSoA soa;
+        const float prop_c[3]{ 0.0f, 1.0f, 0.0f }, prop_min[3]{ -1.0f, 0.0f, -1.0f }, prop_max[3]{ 1.0f, 2.0f, 1.0f };
+        soa.push(0, ColliderHasSphere | ColliderHasAABB, prop_c, 1.0f, prop_min, prop_max,
+            LayerStatic, LayerPlayer | LayerNPC | LayerAnimal);
+        const float npc_c[3]{ 1.5f, 1.1f, 0.0f }, npc_min[3]{ 0.4f, 0.0f, -1.1f }, npc_max[3]{ 2.6f, 2.2f, 1.1f };
+        soa.push(1, ColliderHasSphere | ColliderHasAABB, npc_c, 1.1f, npc_min, npc_max, LayerNPC, npc_mask);
+        soa.pad();
+
+        StaticCollisionWorld staticWorld;
+        staticWorld.Build(soa, 1, {});
+        DynamicColliderTree dynamicTree;
+        BuildDynamicTree(soa, staticWorld.StaticCount(), dynamicTree);
+
+        std::unordered_map<entt::entity, int> candidateCounts;
+        Pairs pairs;
+        CollectCandidatePairs(soa, staticWorld, dynamicTree, candidateCounts, pairs);
+        return pairs;
+    }
+}
+
+TEST(CollisionSystemsTest, NPCPairsWithStaticProp) {
+    EXPECT_EQ(prop_and_npc_pairs(NPCCollisionMask), Pairs({ { 0u, 1u } }));
+}
+
+TEST(CollisionSystemsTest, MaskWithoutStaticLayerSkipsProps) {
+    EXPECT_TRUE(prop_and_npc_pairs(NPCCollisionMask & ~LayerStatic).empty());
+}
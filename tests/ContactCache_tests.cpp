@@ -0,0 +1,102 @@
+#include "ContactCache.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace
+{
+    entt::entity entity(uint32_t index, uint32_t version = 0)
+    {
+        return static_cast<entt::entity>(index | (version << 20));
+    }
+
+    // Runs one frame with the given contacts
+    const std::vector<ContactEvent>& frame(ContactPairCache& cache, const std::vector<std::pair<entt::entity, entt::entity>>& pairs)
+    {
+        cache.BeginFrame();
+        for (const auto& [a, b] : pairs) cache.Add(a, b);
+        cache.EndFrame();
+        return cache.Events();
+    }
+
+    void expect_event(const ContactEvent& event, entt::entity a, entt::entity b, ContactPhase phase)
+    {
+        EXPECT_EQ(event.a, a);
+        EXPECT_EQ(event.b, b);
+        EXPECT_EQ(event.phase, phase);
+    }
+}
+
+TEST(ContactCacheTest, EventsAreSortedOnThePair) {
+    ContactPairCache cache;
+    frame(cache, { { entity(5), entity(6) }, { entity(1), entity(2) } });
+    const auto& events = frame(cache, { { entity(3), entity(4) }, { entity(5), entity(6) } });
+
+    ASSERT_EQ(events.size(), 3u);
+    expect_event(events[0], entity(1), entity(2), ContactPhase::End);
+    expect_event(events[1], entity(3), entity(4), ContactPhase::Begin);
+    expect_event(events[2], entity(5), entity(6), ContactPhase::Stay);
+    EXPECT_EQ(cache.PairCount(), 2u);
+}
+
+TEST(ContactCacheTest, PairAddedInBothOrdersIsOnePair) {
+    ContactPairCache cache;
+    const auto& events = frame(cache, { { entity(7), entity(3) }, { entity(3), entity(7) }, { entity(7), entity(3) } });
+
+    ASSERT_EQ(events.size(), 1u);
+    expect_event(events[0], entity(3), entity(7), ContactPhase::Begin);
+    EXPECT_EQ(cache.PairCount(), 1u);
+
+    const auto& next = frame(cache, { { entity(3), entity(7) } });
+    ASSERT_EQ(next.size(), 1u);
+    expect_event(next[0], entity(3), entity(7), ContactPhase::Stay);
+}
+
+TEST(ContactCacheTest, DestroyedEntityEndsItsPairs) {
+    ContactPairCache cache;
+    frame(cache, { { entity(1), entity(2) }, { entity(2), entity(3) } });
+
+    // Entity 2 is destroyed and its index reused with a new version, which is a different entity
+    const auto& events = frame(cache, { { entity(1), entity(2, 1) } });
+    ASSERT_EQ(events.size(), 3u);
+    expect_event(events[0], entity(1), entity(2), ContactPhase::End);
+    expect_event(events[1], entity(1), entity(2, 1), ContactPhase::Begin);
+    expect_event(events[2], entity(2), entity(3), ContactPhase::End);
+}
+
+TEST(ContactCacheTest, CarriedOverPairsStay) {
+    ContactPairCache cache;
+    frame(cache, { { entity(1), entity(2) }, { entity(3), entity(4) } });
+
+    // Neither pair is tested this frame, and only the first is carried over
+    cache.BeginFrame();
+    cache.CarryOver([](entt::entity a, entt::entity) { return a == entity(1); });
+    cache.EndFrame();
+    const auto& events = cache.Events();
+    ASSERT_EQ(events.size(), 2u);
+    expect_event(events[0], entity(1), entity(2), ContactPhase::Stay);
+    expect_event(events[1], entity(3), entity(4), ContactPhase::End);
+
+    // Carried over and found again in the same frame, e.g. when one side wakes up
+    cache.BeginFrame();
+    cache.Add(entity(2), entity(1));
+    cache.CarryOver([](entt::entity, entt::entity) { return true; });
+    cache.EndFrame();
+    ASSERT_EQ(cache.Events().size(), 1u);
+    expect_event(cache.Events()[0], entity(1), entity(2), ContactPhase::Stay);
+}
+
+TEST(ContactCacheTest, ForEachPairVisitsLastFramesPairs) {
+    ContactPairCache cache;
+    frame(cache, { { entity(4), entity(1) }, { entity(2), entity(3) } });
+
+    std::vector<std::pair<entt::entity, entt::entity>> pairs;
+    cache.ForEachPair([&](entt::entity a, entt::entity b) { pairs.emplace_back(a, b); });
+    const std::vector<std::pair<entt::entity, entt::entity>> expected{ { entity(1), entity(4) }, { entity(2), entity(3) } };
+    EXPECT_EQ(pairs, expected);
+
+    cache.Clear();
+    EXPECT_EQ(cache.PairCount(), 0u);
+    const auto& events = frame(cache, { { entity(1), entity(4) } });
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].phase, ContactPhase::Begin);
+}
@@ -0,0 +1,91 @@
+#include "ContactSolver.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <set>
+
+namespace
+{
+    eeng::SolverContact make_contact(uint32_t a, uint32_t b, float nx, float nz, float depth)
+    {
+        return eeng::SolverContact{ a, b, { nx, 0.0f, nz }, depth };
+    }
+}
+
+TEST(ContactSolverTest, BatchesShareNoMovableBody) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint32_t> body(0, 39);
+    std::vector<float> inv_mass(40, 1.0f);
+    inv_mass[0] = inv_mass[1] = 0.0f;
+
+    std::vector<eeng::SolverContact> contacts;
+    for (int i = 0; i < 300; i++)
+    {
+        const uint32_t a = body(rng), b = body(rng);
+        if (a != b) contacts.push_back(make_contact(a, b, 1.0f, 0.0f, 0.1f));
+    }
+
+    eeng::ContactSolver solver;
+    solver.prepare(contacts.data(), contacts.size(), inv_mass.data(), inv_mass.size());
+    EXPECT_GT(solver.batch_count(), 1u);
+
+    size_t total = 0;
+    for (size_t k = 0; k < solver.batch_count(); k++)
+    {
+        size_t n;
+        const eeng::SolverContact* batch = solver.batch(k, n);
+        std::set<uint32_t> bodies;
+        for (size_t i = 0; i < n; i++)
+            for (uint32_t id : { batch[i].a, batch[i].b })
+                if (inv_mass[id] > 0.0f) { EXPECT_TRUE(bodies.insert(id).second); }
+        total += n;
+    }
+    // Only contacts between two static bodies are dropped
+    size_t static_pairs = 0;
+    for (auto& c : contacts) static_pairs += (c.a < 2 && c.b < 2);
+    EXPECT_EQ(total, contacts.size() - static_pairs);
+}
+
+TEST(ContactSolverTest, SplitsCorrectionByInverseMass) {
+    const float inv_mass[3]{ 1.0f, 1.0f, 0.0f };
+    const eeng::SolverContact contacts[2]{ make_contact(0, 1, 1.0f, 0.0f, 1.0f), make_contact(2, 0, 0.0f, 1.0f, 0.5f) };
+
+    eeng::ContactSolver solver;
+    solver.settings.iterations = 1;
+    solver.prepare(contacts, 2, inv_mass, 3);
+    float d[9];
+    solver.solve(d);
+
+    EXPECT_FLOAT_EQ(d[0], -0.5f);   // Body 0 moves half of the first contact
+    EXPECT_FLOAT_EQ(d[3], 0.5f);
+    EXPECT_FLOAT_EQ(d[2], 0.5f);    // ... and all of the second, against the static body
+    EXPECT_FLOAT_EQ(d[6], 0.0f);
+    EXPECT_FLOAT_EQ(d[8], 0.0f);
+}
+
+TEST(ContactSolverTest, ChainSettlesAndIgnoresThreadCount) {
+    // Bodies in a row along x, each overlapping the next, with a wall at each end
+    const size_t n = 12;
+    std::vector<float> inv_mass(n, 1.0f);
+    inv_mass.front() = inv_mass.back() = 0.0f;
+    std::vector<eeng::SolverContact> contacts;
+    for (uint32_t i = 0; i + 1 < n; i++)
+        contacts.push_back(make_contact(i, i + 1, 1.0f, 0.0f, i == 5 ? 0.4f : 0.0f));
+
+    eeng::ContactSolver solver;
+    solver.settings.iterations = 200;
+    solver.settings.chunk_size = 1;
+    solver.prepare(contacts.data(), contacts.size(), inv_mass.data(), n);
+
+    std::vector<float> serial(3 * n), parallel(3 * n);
+    solver.solve(serial.data());
+    eeng::ThreadPool pool(4);
+    solver.solve(parallel.data(), &pool);
+    EXPECT_EQ(serial, parallel);
+
+    // The walls hold, so the overlap can only be pushed into the neighbouring gaps
+    EXPECT_FLOAT_EQ(serial[0], 0.0f);
+    EXPECT_FLOAT_EQ(serial[3 * (n - 1)], 0.0f);
+    EXPECT_LT(serial[3 * 5], 0.0f);
+    EXPECT_GT(serial[3 * 6], 0.0f);
+}
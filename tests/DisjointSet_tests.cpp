@@ -0,0 +1,27 @@
+#include "DisjointSet.h"
+#include <gtest/gtest.h>
+
+TEST(DisjointSetTest, StartsAsSingletons) {
+    eeng::DisjointSet sets(5);
+    for (size_t i = 0; i < 5; i++)
+    {
+        EXPECT_EQ(sets.find(i), i);
+        EXPECT_EQ(sets.set_size(i), 1u);
+    }
+}
+
+TEST(DisjointSetTest, UniteMergesTransitively) {
+    eeng::DisjointSet sets(8);
+    EXPECT_TRUE(sets.unite(0, 1));
+    EXPECT_TRUE(sets.unite(2, 3));
+    EXPECT_TRUE(sets.unite(1, 3));
+    EXPECT_FALSE(sets.unite(0, 2));
+
+    EXPECT_EQ(sets.find(0), sets.find(3));
+    EXPECT_EQ(sets.set_size(2), 4u);
+    EXPECT_NE(sets.find(0), sets.find(4));
+    EXPECT_EQ(sets.set_size(7), 1u);
+
+    sets.reset(8);
+    EXPECT_NE(sets.find(0), sets.find(1));
+}
@@ -0,0 +1,112 @@
+#include "Heightfield.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <cmath>
+
+namespace
+{
+    // Samples of a smooth surface on a columns x rows grid
+    std::vector<float> wave_samples(size_t columns, size_t rows, float origin_x, float origin_z, float cell_size)
+    {
+        std::vector<float> heights(columns * rows);
+        for (size_t j = 0; j < rows; j++)
+            for (size_t i = 0; i < columns; i++)
+            {
+                const float x = origin_x + i * cell_size, z = origin_z + j * cell_size;
+                heights[j * columns + i] = 2.0f * std::sin(x * 0.2f) * std::cos(z * 0.15f);
+            }
+        return heights;
+    }
+}
+
+TEST(HeightfieldTest, InterpolatesBilinearly) {
+    const float heights[]{ 0, 1,  2, 5 };   // 2 x 2, first row along x
+    eeng::Heightfield field;
+    field.build(heights, 2, 2, 10.0f, 20.0f, 2.0f);
+
+    EXPECT_FLOAT_EQ(field.height(10.0f, 20.0f), 0.0f);
+    EXPECT_FLOAT_EQ(field.height(12.0f, 20.0f), 1.0f);
+    EXPECT_FLOAT_EQ(field.height(10.0f, 22.0f), 2.0f);
+    EXPECT_FLOAT_EQ(field.height(12.0f, 22.0f), 5.0f);
+    EXPECT_FLOAT_EQ(field.height(11.0f, 21.0f), 2.0f);
+
+    // Clamped outside the grid
+    EXPECT_FALSE(field.contains(13.0f, 21.0f));
+    EXPECT_FLOAT_EQ(field.height(13.0f, 20.0f), 1.0f);
+}
+
+TEST(HeightfieldTest, NormalOfPlane) {
+    // The plane y = 0.5 x
+    std::vector<float> heights;
+    for (int j = 0; j < 4; j++)
+        for (int i = 0; i < 4; i++) heights.push_back(0.5f * i);
+    eeng::Heightfield field;
+    field.build(heights.data(), 4, 4, 0.0f, 0.0f, 1.0f);
+
+    float n[3];
+    field.normal(1.3f, 2.7f, n);
+    const float len = std::sqrt(1.0f + 0.25f);
+    EXPECT_NEAR(n[0], -0.5f / len, 1e-6f);
+    EXPECT_NEAR(n[1], 1.0f / len, 1e-6f);
+    EXPECT_NEAR(n[2], 0.0f, 1e-6f);
+}
+
+TEST(HeightfieldTest, BatchedHeightsMatchSingleLookups) {
+    const auto samples = wave_samples(33, 17, -16.0f, -8.0f, 1.0f);
+    eeng::Heightfield field;
+    field.build(samples.data(), 33, 17, -16.0f, -8.0f, 1.0f);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> x(-20.0f, 20.0f), z(-10.0f, 10.0f);
+    std::vector<float> xs(200), zs(200), out(200);
+    for (size_t i = 0; i < xs.size(); i++) { xs[i] = x(rng); zs[i] = z(rng); }
+    field.heights(xs.data(), zs.data(), xs.size(), out.data());
+    for (size_t i = 0; i < xs.size(); i++)
+        EXPECT_EQ(out[i], field.height(xs[i], zs[i]));
+}
+
+TEST(HeightfieldTest, RaycastLandsOnSurface) {
+    const auto samples = wave_samples(65, 65, -32.0f, -32.0f, 1.0f);
+    eeng::Heightfield field;
+    field.build(samples.data(), 65, 65, -32.0f, -32.0f, 1.0f);
+
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> pos(-25.0f, 25.0f), dir(-1.0f, 1.0f);
+    int hits = 0;
+    for (int r = 0; r < 200; r++)
+    {
+        const float o[3]{ pos(rng), 5.0f, pos(rng) };
+        float d[3]{ dir(rng), -std::abs(dir(rng)) - 0.05f, dir(rng) };
+        const float len = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        for (float& v : d) v /= len;
+
+        float t;
+        if (!field.raycast(o, d, 100.0f, t)) continue;
+        hits++;
+        const float p[3]{ o[0] + d[0] * t, o[1] + d[1] * t, o[2] + d[2] * t };
+        EXPECT_NEAR(p[1], field.height(p[0], p[2]), 1e-3f);
+    }
+    EXPECT_GT(hits, 100);
+
+    // Straight down
+    const float o[3]{ 3.3f, 10.0f, -4.1f }, down[3]{ 0.0f, -1.0f, 0.0f };
+    float t;
+    ASSERT_TRUE(field.raycast(o, down, 20.0f, t));
+    EXPECT_NEAR(10.0f - t, field.height(3.3f, -4.1f), 1e-4f);
+    EXPECT_FALSE(field.raycast(o, down, 5.0f, t));
+
+    // Upwards from above the surface
+    const float up[3]{ 0.0f, 1.0f, 0.0f };
+    EXPECT_FALSE(field.raycast(o, up, 20.0f, t));
+}
+
+TEST(HeightfieldTest, BuildsFromImagePixels) {
+    const uint8_t pixels[]{ 0, 9, 255, 9,  255, 9, 0, 9 };  // 2 x 2, two channels
+    eeng::Heightfield field;
+    field.build_from_image(pixels, 2, 2, 2, 0.0f, 0.0f, 1.0f, -1.0f, 3.0f);
+    EXPECT_FLOAT_EQ(field.sample(0, 0), -1.0f);
+    EXPECT_FLOAT_EQ(field.sample(1, 0), 3.0f);
+    EXPECT_FLOAT_EQ(field.sample(0, 1), 3.0f);
+    EXPECT_FLOAT_EQ(field.sample(1, 1), -1.0f);
+}
@@ -0,0 +1,144 @@
+#include "NavigationGrid.h"
+#include <gtest/gtest.h>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using namespace eeng;
+
+    float path_cost(const NavigationGrid& grid, const std::vector<uint32_t>& cells)
+    {
+        float cost = 0.0f;
+        for (size_t i = 1; i < cells.size(); i++)
+        {
+            const int dc = std::abs(int(grid.column(cells[i])) - int(grid.column(cells[i - 1])));
+            const int dr = std::abs(int(grid.row(cells[i])) - int(grid.row(cells[i - 1])));
+            EXPECT_LE(std::max(dc, dr), 1);
+            EXPECT_TRUE(grid.walkable(cells[i]));
+            cost += dc && dr ? 1.41421356f : 1.0f;
+        }
+        return cost;
+    }
+
+    // Reference costs by Dijkstra, with the same moves as the search
+    float dijkstra_cost(const NavigationGrid& grid, uint32_t start, uint32_t goal)
+    {
+        std::vector<float> dist(grid.cell_count(), 1e30f);
+        using Entry = std::pair<float, uint32_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        dist[start] = 0.0f;
+        open.push({ 0.0f, start });
+        while (!open.empty())
+        {
+            const auto [d, cell] = open.top();
+            open.pop();
+            if (d > dist[cell]) continue;
+            const int c = int(grid.column(cell)), r = int(grid.row(cell));
+            for (int dr = -1; dr <= 1; dr++)
+                for (int dc = -1; dc <= 1; dc++)
+                {
+                    const int nc = c + dc, nr = r + dr;
+                    if ((!dc && !dr) || nc < 0 || nr < 0 || nc >= int(grid.columns()) || nr >= int(grid.rows())) continue;
+                    const uint32_t next = grid.cell(nc, nr);
+                    if (!grid.walkable(next)) continue;
+                    if (dc && dr && (!grid.walkable(grid.cell(nc, r)) || !grid.walkable(grid.cell(c, nr)))) continue;
+                    const float nd = d + (dc && dr ? 1.41421356f : 1.0f);
+                    if (nd < dist[next])
+                    {
+                        dist[next] = nd;
+                        open.push({ nd, next });
+                    }
+                }
+        }
+        return dist[goal];
+    }
+}
+
+TEST(NavigationGridTest, MapsPositionsToCells) {
+    NavigationGrid grid;
+    grid.build(10, 5, -5.0f, 0.0f, 0.5f);
+    EXPECT_EQ(grid.cell_at(-5.0f, 0.0f), 0u);
+    EXPECT_EQ(grid.cell_at(-4.3f, 1.2f), grid.cell(1, 2));
+    EXPECT_EQ(grid.cell_at(-5.1f, 0.0f), NavigationGrid::InvalidCell);
+    EXPECT_EQ(grid.cell_at(0.0f, 0.0f), NavigationGrid::InvalidCell);
+
+    float c[3];
+    grid.set_height(grid.cell(1, 2), 3.0f);
+    grid.center(grid.cell(1, 2), c);
+    EXPECT_FLOAT_EQ(c[0], -4.25f);
+    EXPECT_FLOAT_EQ(c[1], 3.0f);
+    EXPECT_FLOAT_EQ(c[2], 1.25f);
+
+    grid.set_walkable(grid.cell(1, 2), false);
+    EXPECT_EQ(grid.nearest_walkable(grid.cell(1, 2), 1), grid.cell(1, 1));
+}
+
+TEST(NavigationGridTest, FindsShortestPathsOnRandomGrids) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    GridSearch search;
+    std::vector<uint32_t> cells;
+    for (int g = 0; g < 20; g++)
+    {
+        NavigationGrid grid;
+        grid.build(40, 30, 0.0f, 0.0f, 1.0f);
+        for (uint32_t i = 0; i < grid.cell_count(); i++)
+            grid.set_walkable(i, unit(rng) > 0.3f);
+        const uint32_t start = grid.nearest_walkable(grid.cell(1, 1), 5), goal = grid.nearest_walkable(grid.cell(38, 28), 5);
+
+        search.begin(grid, start, goal);
+        const auto status = search.step(SIZE_MAX);
+        const float expected = dijkstra_cost(grid, start, goal);
+        if (expected >= 1e30f)
+        {
+            EXPECT_EQ(status, GridSearch::Status::NoPath);
+            continue;
+        }
+        ASSERT_EQ(status, GridSearch::Status::Found);
+        search.path(cells);
+        ASSERT_FALSE(cells.empty());
+        EXPECT_EQ(cells.front(), start);
+        EXPECT_EQ(cells.back(), goal);
+        EXPECT_NEAR(path_cost(grid, cells), expected, 1e-3f);
+
+        // Smoothed paths keep their ends and only have clear lines between waypoints
+        smooth_path(grid, cells);
+        EXPECT_EQ(cells.front(), start);
+        EXPECT_EQ(cells.back(), goal);
+        for (size_t i = 1; i < cells.size(); i++)
+            EXPECT_TRUE(grid.line_walkable(cells[i - 1], cells[i]));
+    }
+}
+
+TEST(NavigationGridTest, SlicedSearchMatchesSingleStep) {
+    NavigationGrid grid;
+    grid.build(20, 20, 0.0f, 0.0f, 1.0f);
+    // Wall along column 10 with a gap at the top
+    for (uint32_t r = 0; r < 19; r++) grid.set_walkable(grid.cell(10, r), false);
+
+    GridSearch search;
+    std::vector<uint32_t> whole, sliced;
+    search.begin(grid, grid.cell(0, 0), grid.cell(19, 0));
+    ASSERT_EQ(search.step(SIZE_MAX), GridSearch::Status::Found);
+    search.path(whole);
+
+    search.begin(grid, grid.cell(0, 0), grid.cell(19, 0));
+    int slices = 0;
+    while (search.step(8) == GridSearch::Status::Running) slices++;
+    ASSERT_EQ(search.status(), GridSearch::Status::Found);
+    EXPECT_GT(slices, 1);
+    search.path(sliced);
+    EXPECT_EQ(whole, sliced);
+
+    // The smoothed path turns at the gap only
+    smooth_path(grid, sliced);
+    EXPECT_EQ(sliced.size(), 4u);
+    EXPECT_FALSE(grid.line_walkable(grid.cell(0, 0), grid.cell(19, 0)));
+
+    // Closing the gap leaves no path
+    grid.set_walkable(grid.cell(10, 19), false);
+    search.begin(grid, grid.cell(0, 0), grid.cell(19, 0));
+    EXPECT_EQ(search.step(SIZE_MAX), GridSearch::Status::NoPath);
+}
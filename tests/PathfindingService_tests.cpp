@@ -0,0 +1,89 @@
+#include "PathfindingService.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace eeng;
+
+    // Calls update() once per simulated frame until a result arrives
+    PathfindingService::Result wait_for_result(PathfindingService& service, int& frames)
+    {
+        std::vector<PathfindingService::Result> results;
+        for (frames = 0; frames < 10000; frames++)
+        {
+            service.update(results);
+            if (!results.empty()) return results.front();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        ADD_FAILURE() << "No result";
+        return {};
+    }
+
+    std::shared_ptr<NavigationGrid> make_wall_grid()
+    {
+        // 64 x 64 cells of 0.5, with a wall along column 32 open at the top row only
+        auto grid = std::make_shared<NavigationGrid>();
+        grid->build(64, 64, 0.0f, 0.0f, 0.5f);
+        for (uint32_t r = 0; r < 63; r++) grid->set_walkable(grid->cell(32, r), false);
+        return grid;
+    }
+}
+
+TEST(PathfindingServiceTest, SpreadsSearchesOverFramesAndCachesPaths) {
+    PathfindingService service;
+    service.settings.expansions_per_frame = 64;
+    service.set_grid(make_wall_grid());
+
+    const float start[3]{ 1.0f, 0.0f, 1.0f }, goal[3]{ 30.1f, 0.0f, 1.2f };
+    const uint64_t ticket = service.request(7, start, goal);
+    int frames = 0;
+    const auto result = wait_for_result(service, frames);
+    EXPECT_EQ(result.ticket, ticket);
+    EXPECT_EQ(result.owner, 7u);
+    ASSERT_TRUE(result.found);
+    EXPECT_FALSE(result.cached);
+    EXPECT_GT(frames, 2);
+
+    // Through the gap at the far end of the wall, ending exactly on the goal
+    ASSERT_GE(result.path.size(), 6u);
+    bool throughGap = false;
+    for (size_t i = 0; i < result.path.size(); i += 3)
+        throughGap |= result.path[i + 2] > 31.0f;
+    EXPECT_TRUE(throughGap);
+    EXPECT_FLOAT_EQ(result.path[result.path.size() - 3], goal[0]);
+    EXPECT_FLOAT_EQ(result.path[result.path.size() - 1], goal[2]);
+
+    // Same cells, other positions within them: served from the cache
+    const float nearStart[3]{ 1.1f, 0.0f, 1.1f }, nearGoal[3]{ 30.2f, 0.0f, 1.4f };
+    service.request(8, nearStart, nearGoal);
+    const auto again = wait_for_result(service, frames);
+    EXPECT_TRUE(again.cached);
+    EXPECT_EQ(again.path.size(), result.path.size());
+    EXPECT_FLOAT_EQ(again.path[again.path.size() - 1], nearGoal[2]);
+
+    const auto stats = service.stats();
+    EXPECT_EQ(stats.searches, 1u);
+    EXPECT_EQ(stats.cache_hits, 1u);
+    EXPECT_EQ(stats.pending, 0u);
+}
+
+TEST(PathfindingServiceTest, ReportsUnreachableGoals) {
+    auto grid = make_wall_grid();
+    grid->set_walkable(grid->cell(32, 63), false);
+    PathfindingService service;
+    service.set_grid(grid);
+
+    const float start[3]{ 1.0f, 0.0f, 1.0f }, goal[3]{ 30.0f, 0.0f, 1.0f }, outside[3]{ -50.0f, 0.0f, 0.0f };
+    int frames = 0;
+    service.request(1, start, goal);
+    auto result = wait_for_result(service, frames);
+    EXPECT_FALSE(result.found);
+    EXPECT_TRUE(result.path.empty());
+
+    service.request(1, start, outside);
+    result = wait_for_result(service, frames);
+    EXPECT_FALSE(result.found);
+}
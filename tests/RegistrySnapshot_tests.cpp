@@ -0,0 +1,201 @@
+#include "RegistrySnapshot.h"
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    struct Scene
+    {
+        entt::registry registry;
+        entt::entity a, b, c;
+    };
+
+    // Three entities: a with a transform and a velocity, b with a transform and the player tag, c with a transform
+    void populate(Scene& scene)
+    {
+        auto& r = scene.registry;
+        scene.a = r.create();
+        scene.b = r.create();
+        scene.c = r.create();
+        r.emplace<TransformComponent>(scene.a, glm::vec3(1.0f, 2.0f, 3.0f));
+        r.emplace<LinearVelocityComponent>(scene.a, glm::vec3(0.5f, 0.0f, 0.0f));
+        r.emplace<TransformComponent>(scene.b, glm::vec3(4.0f, 5.0f, 6.0f));
+        r.emplace<PlayerTag>(scene.b);
+        r.emplace<TransformComponent>(scene.c, glm::vec3(7.0f, 8.0f, 9.0f));
+    }
+
+    std::vector<entt::entity> alive(const entt::registry& registry)
+    {
+        std::vector<entt::entity> entities;
+        for (auto [entity] : registry.storage<entt::entity>()->each()) entities.push_back(entity);
+        std::sort(entities.begin(), entities.end());
+        return entities;
+    }
+
+    template<class T>
+    bool has(const entt::registry& registry, entt::entity entity)
+    {
+        const auto* storage = registry.storage<T>();
+        return storage && storage->contains(entity);
+    }
+
+    glm::vec3 position(const entt::registry& registry, entt::entity entity)
+    {
+        return registry.storage<TransformComponent>()->get(entity).position;
+    }
+
+    // Same entities, and same bytes for each of their transforms and velocities, and the same tags
+    void expect_same(const entt::registry& x, const entt::registry& y)
+    {
+        const auto entities = alive(x);
+        ASSERT_EQ(entities, alive(y));
+        for (auto entity : entities)
+        {
+            ASSERT_EQ(has<TransformComponent>(x, entity), has<TransformComponent>(y, entity));
+            if (has<TransformComponent>(x, entity))
+            {
+                EXPECT_EQ(std::memcmp(&x.storage<TransformComponent>()->get(entity), &y.storage<TransformComponent>()->get(entity),
+                    sizeof(TransformComponent)), 0);
+            }
+            ASSERT_EQ(has<LinearVelocityComponent>(x, entity), has<LinearVelocityComponent>(y, entity));
+            if (has<LinearVelocityComponent>(x, entity))
+            {
+                EXPECT_EQ(std::memcmp(&x.storage<LinearVelocityComponent>()->get(entity), &y.storage<LinearVelocityComponent>()->get(entity),
+                    sizeof(LinearVelocityComponent)), 0);
+            }
+            EXPECT_EQ(has<PlayerTag>(x, entity), has<PlayerTag>(y, entity));
+        }
+    }
+}
+
+TEST(RegistrySnapshotTest, FullRestoreUndoesChanges) {
+    Scene scene;
+    populate(scene);
+    Scene expected;
+    populate(expected);
+    auto& r = scene.registry;
+
+    RegistrySnapshot snapshot;
+    TakeSnapshot(r, snapshot);
+    ASSERT_FALSE(snapshot.Empty());
+
+    r.get<TransformComponent>(scene.a).position = glm::vec3(-1.0f);
+    r.emplace<LinearVelocityComponent>(scene.c);
+    r.remove<PlayerTag>(scene.b);
+    r.destroy(scene.b);
+    const entt::entity extra = r.create();
+    r.emplace<TransformComponent>(extra);
+
+    ASSERT_TRUE(RestoreSnapshot(r, snapshot));
+    expect_same(r, expected.registry);
+
+    // Restoring again changes nothing
+    ASSERT_TRUE(RestoreSnapshot(r, snapshot));
+    expect_same(r, expected.registry);
+}
+
+TEST(RegistrySnapshotTest, DeltaRestoreAppliesAddedChangedAndRemovedComponents) {
+    Scene scene;
+    populate(scene);
+    auto& r = scene.registry;
+
+    RegistrySnapshot base, delta;
+    TakeSnapshot(r, base);
+
+    r.emplace<LinearVelocityComponent>(scene.c, glm::vec3(0.0f, 0.0f, 2.0f));    // Added
+    r.get<TransformComponent>(scene.a).position = glm::vec3(10.0f, 0.0f, 0.0f);  // Changed
+    r.remove<LinearVelocityComponent>(scene.a);                                  // Removed
+    r.remove<PlayerTag>(scene.b);                                                // Tag removed
+    r.emplace<PlayerTag>(scene.c);                                               // Tag added
+    TakeDeltaSnapshot(r, base, delta);
+
+    // Diverge further, then go back to the base and forward to the delta
+    r.get<TransformComponent>(scene.b).position = glm::vec3(-5.0f);
+    r.destroy(scene.c);
+
+    ASSERT_TRUE(RestoreSnapshot(r, base));
+    Scene original;
+    populate(original);
+    expect_same(r, original.registry);
+
+    ASSERT_TRUE(RestoreSnapshot(r, delta));
+    EXPECT_EQ(position(r, scene.a), glm::vec3(10.0f, 0.0f, 0.0f));
+    EXPECT_EQ(position(r, scene.b), glm::vec3(4.0f, 5.0f, 6.0f));
+    EXPECT_FALSE(has<LinearVelocityComponent>(r, scene.a));
+    ASSERT_TRUE(has<LinearVelocityComponent>(r, scene.c));
+    EXPECT_EQ(r.get<LinearVelocityComponent>(scene.c).velocity, glm::vec3(0.0f, 0.0f, 2.0f));
+    EXPECT_FALSE(has<PlayerTag>(r, scene.b));
+    EXPECT_TRUE(has<PlayerTag>(r, scene.c));
+}
+
+TEST(RegistrySnapshotTest, DeltaTracksEntityRecreatedOnSameIndex) {
+    Scene scene;
+    populate(scene);
+    auto& r = scene.registry;
+
+    RegistrySnapshot base, delta;
+    TakeSnapshot(r, base);
+
+    // b is destroyed and its index reused by a new entity with a bumped version
+    r.destroy(scene.b);
+    const entt::entity reborn = r.create();
+    ASSERT_EQ(entt::to_entity(reborn), entt::to_entity(scene.b));
+    ASSERT_NE(reborn, scene.b);
+    r.emplace<TransformComponent>(reborn, glm::vec3(-4.0f));
+    TakeDeltaSnapshot(r, base, delta);
+
+    ASSERT_TRUE(RestoreSnapshot(r, base));
+    EXPECT_TRUE(r.valid(scene.b));
+    EXPECT_FALSE(r.valid(reborn));
+    EXPECT_EQ(position(r, scene.b), glm::vec3(4.0f, 5.0f, 6.0f));
+    EXPECT_TRUE(has<PlayerTag>(r, scene.b));
+
+    ASSERT_TRUE(RestoreSnapshot(r, delta));
+    EXPECT_FALSE(r.valid(scene.b));
+    ASSERT_TRUE(r.valid(reborn));
+    EXPECT_EQ(position(r, reborn), glm::vec3(-4.0f));
+    EXPECT_FALSE(has<PlayerTag>(r, reborn));
+    EXPECT_EQ(alive(r).size(), 3u);
+}
+
+TEST(RegistrySnapshotTest, RejectsTruncatedOrForeignSnapshot) {
+    Scene scene;
+    populate(scene);
+    auto& r = scene.registry;
+
+    RegistrySnapshot snapshot;
+    TakeSnapshot(r, snapshot);
+
+    // State that a restore of the snapshot would undo
+    r.get<TransformComponent>(scene.a).position = glm::vec3(-1.0f);
+    r.destroy(scene.c);
+    const entt::entity extra = r.create();
+    r.emplace<TransformComponent>(extra, glm::vec3(3.0f));
+    Scene changed;
+    populate(changed);
+    changed.registry.get<TransformComponent>(changed.a).position = glm::vec3(-1.0f);
+    changed.registry.destroy(changed.c);
+    changed.registry.emplace<TransformComponent>(changed.registry.create(), glm::vec3(3.0f));
+
+    for (size_t size : { snapshot.bytes.size() - 1, snapshot.bytes.size() / 2, size_t(8), size_t(0) })
+    {
+        RegistrySnapshot truncated;
+        truncated.bytes.assign(snapshot.bytes.begin(), snapshot.bytes.begin() + size);
+        EXPECT_FALSE(RestoreSnapshot(r, truncated)) << size << " bytes";
+        expect_same(r, changed.registry);
+    }
+
+    RegistrySnapshot foreign = snapshot;
+    const uint32_t typeCount = SnapshotTypeCount(SnapshotComponents{}) + 1;
+    std::memcpy(foreign.bytes.data() + sizeof(uint32_t), &typeCount, sizeof(typeCount));
+    EXPECT_FALSE(RestoreSnapshot(r, foreign));
+    expect_same(r, changed.registry);
+
+    // The untouched snapshot still restores
+    ASSERT_TRUE(RestoreSnapshot(r, snapshot));
+    Scene original;
+    populate(original);
+    expect_same(r, original.registry);
+}
@@ -0,0 +1,248 @@
+#include "SceneQuery.h"
+#include "ThreadPool.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+    using namespace eeng;
+
+    const entt::entity WallEntity = static_cast<entt::entity>(100000u);
+
+    // A 60 x 60 m mesh wall in the plane x = 12
+    StaticCollisionWorld::StaticMesh make_wall()
+    {
+        const float positions[]{ 12.0f, -30.0f, -30.0f, 12.0f, 30.0f, -30.0f, 12.0f, 30.0f, 30.0f, 12.0f, -30.0f, 30.0f };
+        const uint32_t indices[]{ 0, 1, 2, 0, 2, 3 };
+        auto bvh = std::make_shared<TriangleMeshBVH>();
+        bvh->build(positions, indices, 2);
+
+        StaticCollisionWorld::StaticMesh mesh;
+        mesh.entity = WallEntity;
+        mesh.bvh = bvh;
+        return mesh;
+    }
+
+    struct Scene
+    {
+        ColliderSoA soa;
+        StaticCollisionWorld staticWorld;
+    };
+
+    // Random static and dynamic colliders on a few layers, owned by their SoA index, plus the wall
+    std::unique_ptr<Scene> make_scene(size_t static_count, size_t dynamic_count, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-20.0f, 20.0f);
+        std::uniform_real_distribution<float> size(0.2f, 2.0f);
+        std::uniform_int_distribution<int> kind(0, 2);
+        const uint32_t layers[3]{ LayerDefault, LayerNPC, LayerStatic };
+
+        auto scene = std::make_unique<Scene>();
+        for (size_t i = 0; i < static_count + dynamic_count; i++)
+        {
+            const float c[3]{ pos(rng), pos(rng), pos(rng) };
+            const float h = size(rng);
+            const float mn[3]{ c[0] - h, c[1] - h, c[2] - h };
+            const float mx[3]{ c[0] + h, c[1] + h, c[2] + h };
+            const uint8_t flags = kind(rng) == 0 ? ColliderHasSphere : ColliderHasSphere | ColliderHasAABB;
+            scene->soa.push((uint32_t)i, flags, c, h, mn, mx, layers[kind(rng)]);
+        }
+        scene->soa.pad();
+
+        scene->staticWorld.Build(scene->soa, static_count, {}, { make_wall() });
+        return scene;
+    }
+
+    std::vector<SceneRay> random_rays(size_t n, unsigned seed, float radius = 0.0f)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(-25.0f, 25.0f);
+        std::normal_distribution<float> dir(0.0f, 1.0f);
+        const uint32_t masks[3]{ LayerAll, LayerStatic, LayerDefault | LayerNPC };
+
+        std::vector<SceneRay> rays(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            const glm::vec3 d(dir(rng), dir(rng), dir(rng));
+            rays[i] = { glm::vec3(pos(rng), pos(rng), pos(rng)), d / glm::length(d), 60.0f, radius, masks[i % 3] };
+        }
+        return rays;
+    }
+
+    // Every collider and the wall along the ray, in SoA order
+    std::vector<SceneHit> brute_hits(const Scene& scene, const SceneRay& ray)
+    {
+        const float o[3]{ ray.origin.x, ray.origin.y, ray.origin.z }, d[3]{ ray.dir.x, ray.dir.y, ray.dir.z };
+        const RayQuery query = RayQuery::make(o, d, ray.maxDistance, ray.radius);
+        std::vector<SceneHit> hits;
+        for (size_t i = 0; i < scene.soa.count; i++)
+        {
+            float t;
+            if ((scene.soa.layer[i] & ray.mask) && ray_collider(scene.soa, i, query, t))
+                hits.push_back({ static_cast<entt::entity>(scene.soa.owner[i]), t });
+        }
+        TriangleHit wall_hit;
+        if (ray.radius <= 0.0f && (LayerStatic & ray.mask) && scene.staticWorld.Meshes()[0].bvh->raycast(o, d, ray.maxDistance, wall_hit))
+            hits.push_back({ WallEntity, wall_hit.t });
+        return hits;
+    }
+
+    bool brute_closest(const Scene& scene, const SceneRay& ray, SceneHit& closest)
+    {
+        const auto hits = brute_hits(scene, ray);
+        if (hits.empty()) return false;
+        closest = *std::min_element(hits.begin(), hits.end(), [](const SceneHit& a, const SceneHit& b) { return a.distance < b.distance; });
+        return true;
+    }
+
+    void sort_by_entity(std::vector<SceneHit>& hits)
+    {
+        std::sort(hits.begin(), hits.end(), [](const SceneHit& a, const SceneHit& b) { return a.entity < b.entity; });
+    }
+}
+
+TEST(SceneQueryTest, RaycastMatchesBruteForce) {
+    const auto scene = make_scene(300, 400, 1);
+    const SceneQuery query(scene->soa, scene->staticWorld);
+
+    for (const auto& ray : random_rays(500, 2))
+    {
+        SceneHit hit, expected;
+        const bool found = query.Raycast(ray, hit);
+        ASSERT_EQ(found, brute_closest(*scene, ray, expected));
+        if (!found) continue;
+        EXPECT_EQ(hit.entity, expected.entity);
+        EXPECT_NEAR(hit.distance, expected.distance, 1e-4f);
+    }
+}
+
+TEST(SceneQueryTest, RaycastBatchMatchesRaycast) {
+    const auto scene = make_scene(300, 400, 3);
+    const SceneQuery query(scene->soa, scene->staticWorld);
+    ThreadPool pool(3);
+
+    // Rays and sphere-casts, with a count that leaves a partial packet
+    for (const float radius : { 0.0f, 0.5f })
+    {
+        const auto rays = random_rays(1001, 4, radius);
+        for (ThreadPool* threadPool : { (ThreadPool*)nullptr, &pool })
+        {
+            std::vector<SceneHit> hits(rays.size());
+            std::vector<uint8_t> found(rays.size());
+            query.RaycastBatch(rays.data(), rays.size(), hits.data(), found.data(), threadPool);
+
+            size_t wall_hits = 0;
+            for (size_t i = 0; i < rays.size(); i++)
+            {
+                SceneHit expected;
+                ASSERT_EQ(found[i] != 0, query.Raycast(rays[i], expected)) << "ray " << i;
+                if (!found[i]) continue;
+                EXPECT_EQ(hits[i].entity, expected.entity) << "ray " << i;
+                EXPECT_NEAR(hits[i].distance, expected.distance, 1e-4f) << "ray " << i;
+                EXPECT_NEAR(glm::distance(hits[i].point, expected.point), 0.0f, 1e-3f) << "ray " << i;
+                wall_hits += hits[i].entity == WallEntity;
+            }
+            // Sphere-casts skip meshes, rays must have taken the surface-hit path
+            if (radius > 0.0f) { EXPECT_EQ(wall_hits, 0u); }
+            else { EXPECT_GT(wall_hits, 0u); }
+        }
+    }
+}
+
+TEST(SceneQueryTest, RaycastBatchPrefersNearerColliderOverWall) {
+    ColliderSoA soa;
+    const float front[3]{ 8.0f, 0.0f, 0.0f }, behind[3]{ 16.0f, 0.0f, 0.0f }, unused[3]{};
+    soa.push(0, ColliderHasSphere, front, 1.0f, unused, unused);
+    soa.push(1, ColliderHasSphere, behind, 1.0f, unused, unused);
+    soa.pad();
+
+    StaticCollisionWorld staticWorld;
+    staticWorld.Build(soa, 0, {}, { make_wall() });
+    const SceneQuery query(soa, staticWorld);
+
+    // Through the front sphere, past it into the wall, and beside both
+    const SceneRay rays[3]{
+        { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f },
+        { glm::vec3(10.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f },
+        { glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f } };
+    SceneHit hits[3];
+    uint8_t found[3];
+    query.RaycastBatch(rays, 3, hits, found);
+
+    ASSERT_TRUE(found[0] && found[1] && found[2]);
+    EXPECT_EQ(hits[0].entity, static_cast<entt::entity>(0u));
+    EXPECT_FLOAT_EQ(hits[0].distance, 7.0f);
+    EXPECT_EQ(hits[1].entity, WallEntity);
+    EXPECT_FLOAT_EQ(hits[1].distance, 2.0f);
+    EXPECT_FLOAT_EQ(hits[1].point.x, 12.0f);
+    EXPECT_EQ(hits[2].entity, WallEntity);
+    EXPECT_FLOAT_EQ(hits[2].distance, 12.0f);
+}
+
+TEST(SceneQueryTest, RaycastAllMatchesBruteForce) {
+    const auto scene = make_scene(300, 400, 5);
+    const SceneQuery query(scene->soa, scene->staticWorld);
+
+    std::vector<SceneHit> hits;
+    for (const float radius : { 0.0f, 0.5f })
+    {
+        for (const auto& ray : random_rays(300, 6, radius))
+        {
+            query.RaycastAll(ray, hits);
+            for (size_t i = 1; i < hits.size(); i++)
+                EXPECT_LE(hits[i - 1].distance, hits[i].distance);
+
+            auto expected = brute_hits(*scene, ray);
+            ASSERT_EQ(hits.size(), expected.size());
+            sort_by_entity(hits);
+            sort_by_entity(expected);
+            for (size_t i = 0; i < hits.size(); i++)
+            {
+                EXPECT_EQ(hits[i].entity, expected[i].entity);
+                EXPECT_NEAR(hits[i].distance, expected[i].distance, 1e-4f);
+            }
+        }
+    }
+}
+
+TEST(SceneQueryTest, OverlapMatchesBruteForce) {
+    const auto scene = make_scene(300, 400, 7);
+    const SceneQuery query(scene->soa, scene->staticWorld);
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<float> pos(-25.0f, 25.0f), size(0.1f, 4.0f);
+    const uint32_t masks[3]{ LayerAll, LayerStatic, LayerDefault | LayerNPC };
+
+    std::vector<entt::entity> entities, expected;
+    for (int n = 0; n < 300; n++)
+    {
+        const glm::vec3 c(pos(rng), pos(rng), pos(rng));
+        const float r = size(rng);
+        const uint32_t mask = masks[n % 3];
+        query.Overlap(c, r, entities, mask);
+
+        // Boxes are tested against the box around the sphere, as in the collision stage
+        expected.clear();
+        const auto& soa = scene->soa;
+        for (size_t i = 0; i < soa.count; i++)
+        {
+            if (!(soa.layer[i] & mask)) continue;
+            bool hit;
+            if (soa.flags[i] & ColliderHasAABB)
+                hit = soa.min_x[i] <= c.x + r && c.x - r <= soa.max_x[i] && soa.min_y[i] <= c.y + r && c.y - r <= soa.max_y[i] &&
+                    soa.min_z[i] <= c.z + r && c.z - r <= soa.max_z[i];
+            else
+                hit = glm::distance(c, glm::vec3(soa.center_x[i], soa.center_y[i], soa.center_z[i])) <= soa.radius[i] + r;
+            if (hit) expected.push_back(static_cast<entt::entity>(soa.owner[i]));
+        }
+        if ((LayerStatic & mask) && std::abs(c.x - 12.0f) <= r) expected.push_back(WallEntity);
+
+        std::sort(entities.begin(), entities.end());
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(entities, expected);
+    }
+}
@@ -0,0 +1,55 @@
+#include "SpatialHash.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+TEST(SpatialHashTest, QueryMatchesBruteForce) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(-30.0f, 30.0f), radius(0.1f, 6.0f);
+    std::vector<float> x(2000), z(2000);
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = pos(rng);
+        z[i] = pos(rng);
+    }
+
+    eeng::SpatialHash hash;
+    hash.build(x.data(), z.data(), x.size(), 2.0f);
+    EXPECT_EQ(hash.size(), x.size());
+
+    for (int q = 0; q < 200; q++)
+    {
+        const float qx = pos(rng), qz = pos(rng), r = radius(rng);
+        std::vector<uint32_t> found;
+        hash.query(qx, qz, r, [&](uint32_t i, float d2) {
+            EXPECT_NEAR(d2, (x[i] - qx) * (x[i] - qx) + (z[i] - qz) * (z[i] - qz), 1e-3f);
+            found.push_back(i);
+        });
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < x.size(); i++)
+            if ((x[i] - qx) * (x[i] - qx) + (z[i] - qz) * (z[i] - qz) <= r * r) expected.push_back(i);
+
+        // Sorting also exposes points reported twice
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+    }
+}
+
+TEST(SpatialHashTest, RebuildsAndHandlesEmptyInput) {
+    eeng::SpatialHash hash;
+    hash.build(nullptr, nullptr, 0, 1.0f);
+    size_t calls = 0;
+    hash.query(0.0f, 0.0f, 10.0f, [&](uint32_t, float) { calls++; });
+    EXPECT_EQ(calls, 0u);
+
+    // Points in the same cell and in cells far apart
+    const float x[]{ 0.1f, 0.2f, -1000.5f, 1000.5f }, z[]{ 0.1f, 0.3f, 0.0f, -1000.5f };
+    hash.build(x, z, 4, 1.0f);
+    hash.query(0.0f, 0.0f, 0.5f, [&](uint32_t i, float) { EXPECT_LT(i, 2u); calls++; });
+    EXPECT_EQ(calls, 2u);
+    calls = 0;
+    hash.query(1000.5f, -1000.5f, 0.1f, [&](uint32_t i, float) { EXPECT_EQ(i, 3u); calls++; });
+    EXPECT_EQ(calls, 1u);
+}
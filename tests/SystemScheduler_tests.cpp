@@ -0,0 +1,72 @@
+#include "SystemScheduler.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace eeng;
+    using Access = SystemScheduler::Access;
+
+    struct Position {};
+    struct Velocity {};
+    struct Pose {};
+}
+
+TEST(SystemSchedulerTest, DependsOnlyOnDirectConflicts) {
+    SystemScheduler scheduler;
+    auto noop = [] {};
+    scheduler.add("steer", Access().writes<Velocity>(), noop);                          // 0
+    scheduler.add("move", Access().reads<Velocity>().writes<Position>(), noop);         // 1
+    scheduler.add("animate", Access().writes<Pose>(), noop);                            // 2
+    scheduler.add("collide", Access().writes<Position, Velocity>(), noop);              // 3
+    scheduler.add("render", Access().reads<Position, Pose>(), noop);                    // 4
+
+    EXPECT_TRUE(scheduler.info(0).dependencies.empty());
+    EXPECT_EQ(scheduler.info(1).dependencies, std::vector<size_t>({ 0 }));
+    EXPECT_TRUE(scheduler.info(2).dependencies.empty());
+    // Waits for steer through move, so only move is listed
+    EXPECT_EQ(scheduler.info(3).dependencies, std::vector<size_t>({ 1 }));
+    EXPECT_EQ(scheduler.info(4).dependencies, std::vector<size_t>({ 2, 3 }));
+    EXPECT_EQ(scheduler.info(4).level, 3u);
+    EXPECT_EQ(scheduler.level_count(), 4u);
+
+    // Readers of the same data do not conflict
+    EXPECT_FALSE(Access().reads<Position>().conflicts_with(Access().reads<Position>()));
+    EXPECT_TRUE(Access().reads<Position>().conflicts_with(Access().writes<Position>()));
+}
+
+TEST(SystemSchedulerTest, RunsInDependencyOrder) {
+    ThreadPool pool(3);
+    SystemScheduler scheduler;
+    std::mutex mutex;
+    std::vector<std::string> order;
+    std::atomic<int> runs{ 0 };
+    auto log = [&](const char* name) {
+        return [&, name] {
+            runs++;
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+    };
+    scheduler.add("a", Access().writes<Position>(), log("a"));
+    scheduler.add("b", Access().writes<Pose>(), log("b"));
+    scheduler.add("c", Access().reads<Position>(), log("c"));
+    scheduler.add("d", Access().reads<Position>().writes<Pose>(), log("d"));
+
+    // The first run is serial, the others in parallel
+    for (int frame = 0; frame < 100; frame++)
+    {
+        order.clear();
+        scheduler.run(pool);
+        ASSERT_EQ(order.size(), 4u);
+        auto position = [&](const char* name) { return std::find(order.begin(), order.end(), name) - order.begin(); };
+        EXPECT_LT(position("a"), position("c"));
+        EXPECT_LT(position("a"), position("d"));
+        EXPECT_LT(position("b"), position("d"));
+    }
+    EXPECT_EQ(runs.load(), 400);
+}
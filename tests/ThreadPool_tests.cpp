@@ -0,0 +1,103 @@
+#include "ThreadPool.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+#include <list>
+#include <thread>
+#include <atomic>
+
+TEST(ThreadPoolTest, VisitsEveryIndexOnce) {
+    eeng::ThreadPool pool(3);
+    std::vector<std::atomic<int>> visits(1000);
+    pool.parallel_for(visits.size(), 7, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) visits[i]++;
+    });
+    for (auto& v : visits) EXPECT_EQ(v.load(), 1);
+}
+
+TEST(ThreadPoolTest, ChunksIndependentOfThreadCount) {
+    auto chunk_bounds = [](size_t workers) {
+        eeng::ThreadPool pool(workers);
+        std::vector<std::pair<size_t, size_t>> bounds(10);
+        for (int repeat = 0; repeat < 20; repeat++)
+            pool.parallel_for(95, 10, [&](size_t begin, size_t end, size_t chunk) {
+                bounds[chunk] = { begin, end };
+            });
+        return bounds;
+    };
+    const auto serial = chunk_bounds(0);
+    EXPECT_EQ(serial.back(), std::make_pair(size_t(90), size_t(95)));
+    EXPECT_EQ(chunk_bounds(1), serial);
+    EXPECT_EQ(chunk_bounds(5), serial);
+}
+
+TEST(ThreadPoolTest, DequeHandsOutEveryItemOnce) {
+    // The owner pushes and pops while thieves steal, through several growths of the ring
+    constexpr int N = 200000;
+    std::vector<int> items(N);
+    std::vector<std::atomic<int>> taken(N);
+    eeng::WorkStealingDeque<int*> deque(4);
+    std::atomic<bool> done{ false };
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++)
+        thieves.emplace_back([&] {
+            int* item;
+            while (!done.load())
+                if (deque.steal(item)) taken[item - items.data()]++;
+        });
+
+    int* item;
+    for (int i = 0; i < N; i++)
+    {
+        deque.push(&items[i]);
+        if (i % 3 == 0 && deque.pop(item)) taken[item - items.data()]++;
+    }
+    while (deque.pop(item)) taken[item - items.data()]++;
+    done = true;
+    for (auto& thief : thieves) thief.join();
+
+    for (auto& t : taken) EXPECT_EQ(t.load(), 1);
+}
+
+TEST(ThreadPoolTest, JobsRunAfterTheirDependencies) {
+    eeng::ThreadPool pool(3);
+    std::atomic<int> first{ 0 };
+    std::atomic<int> secondSawAllFirst{ 0 };
+    eeng::JobCounter firstJobs, secondJobs;
+
+    for (int i = 0; i < 64; i++)
+        pool.submit([&] { first++; }, &firstJobs);
+    for (int i = 0; i < 16; i++)
+        pool.submit_after(firstJobs, [&] { if (first.load() == 64) secondSawAllFirst++; }, &secondJobs);
+
+    pool.wait(secondJobs);
+    EXPECT_TRUE(firstJobs.done());
+    EXPECT_EQ(secondSawAllFirst.load(), 16);
+
+    // A dependency that is already done starts the job at once
+    pool.submit_after(firstJobs, [&] { first++; }, &secondJobs);
+    pool.wait(secondJobs);
+    EXPECT_EQ(first.load(), 65);
+}
+
+TEST(ThreadPoolTest, NestedLoopsAndViewsRunInJobs) {
+    eeng::ThreadPool pool(3);
+    std::vector<std::atomic<int>> visits(64 * 64);
+    eeng::JobCounter jobs;
+    for (int row = 0; row < 64; row++)
+        pool.submit([&, row] {
+            pool.parallel_for(64, 8, [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) visits[row * 64 + i]++;
+            });
+        }, &jobs);
+    pool.wait(jobs);
+    for (auto& v : visits) EXPECT_EQ(v.load(), 1);
+
+    // Random-access ranges are chunked in place, others copied first
+    std::vector<int> values(1000, 1);
+    std::list<int> listed(values.begin(), values.end());
+    std::atomic<int> sum{ 0 };
+    pool.parallel_for_each(values, 64, [&](int v) { sum += v; });
+    pool.parallel_for_each(listed, 64, [&](int v) { sum += v; });
+    EXPECT_EQ(sum.load(), 2000);
+}
@@ -0,0 +1,164 @@
+#include "TransformHierarchy.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // 1D scale and translation. Composition does not commute, so it exposes parent and child mixed up.
+    struct Affine
+    {
+        double scale = 1.0, offset = 0.0;
+
+        Affine operator*(const Affine& local) const { return { scale * local.scale, scale * local.offset + offset }; }
+    };
+
+    using Hierarchy = eeng::TransformHierarchy<int, Affine>;
+
+    // World transform by walking up the parents of a node
+    Affine reference_world(const Hierarchy& h, size_t index)
+    {
+        Affine world = h.local_at(index);
+        for (size_t p = h.parent_index_at(index); p != Hierarchy::null_index; p = h.parent_index_at(p))
+            world = h.local_at(p) * world;
+        return world;
+    }
+
+    // Pre-order invariants: each branch holds exactly the nodes whose ancestor chain reaches its root
+    void expect_consistent(const Hierarchy& h)
+    {
+        for (size_t i = 0; i < h.size(); i++)
+        {
+            EXPECT_EQ(h.index_of(h.payload_at(i)), i);
+            size_t stride = 1;
+            for (size_t j = i + 1; j < h.size(); j++)
+            {
+                size_t p = h.parent_index_at(j);
+                while (p != Hierarchy::null_index && p > i) p = h.parent_index_at(p);
+                if (p != i) break;
+                stride++;
+            }
+            EXPECT_EQ(h.branch_stride_at(i), stride);
+            const size_t parent = h.parent_index_at(i);
+            if (parent != Hierarchy::null_index)
+            {
+                EXPECT_LT(i, parent + h.branch_stride_at(parent));
+            }
+        }
+    }
+
+    void expect_worlds(const Hierarchy& h)
+    {
+        for (size_t i = 0; i < h.size(); i++)
+        {
+            const Affine expected = reference_world(h, i);
+            EXPECT_NEAR(h.world_at(i).scale, expected.scale, 1e-9);
+            EXPECT_NEAR(h.world_at(i).offset, expected.offset, 1e-9);
+        }
+    }
+}
+
+TEST(TransformHierarchyTest, PropagatesLargeRandomHierarchy) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> scale(0.9, 1.1), offset(-1.0, 1.0);
+
+    // 20k nodes, each a root or a child of a random earlier node
+    Hierarchy h;
+    const int n = 20000;
+    for (int id = 0; id < n; id++)
+    {
+        const Affine local{ scale(rng), offset(rng) };
+        if (id == 0 || rng() % 8 == 0)
+            EXPECT_TRUE(h.insert_as_root(id, local));
+        else
+            EXPECT_TRUE(h.insert(id, int(rng() % id), local));
+    }
+    EXPECT_EQ(h.size(), size_t(n));
+    EXPECT_EQ(h.propagate(), size_t(n));
+    expect_consistent(h);
+    expect_worlds(h);
+
+    // A few edits rebuild only their branches
+    for (int round = 0; round < 5; round++)
+    {
+        for (int k = 0; k < 50; k++)
+            h.set_local(int(rng() % n), { scale(rng), offset(rng) });
+        EXPECT_LE(h.propagate(), size_t(n));
+        expect_worlds(h);
+    }
+}
+
+TEST(TransformHierarchyTest, RebuildsOnlyDirtyBranches) {
+    // Root 0 with children 1 and 2, 1 with children 3 and 4; root 5 alone
+    Hierarchy h;
+    h.insert_as_root(0, { 2.0, 1.0 });
+    h.insert(1, 0, { 1.0, 1.0 });
+    h.insert(2, 0, { 1.0, 2.0 });
+    h.insert(3, 1, { 1.0, 3.0 });
+    h.insert(4, 1, { 3.0, 0.0 });
+    h.insert_as_root(5, { 1.0, 5.0 });
+    EXPECT_EQ(h.propagate(), 6u);
+    EXPECT_EQ(h.propagate(), 0u);
+    EXPECT_DOUBLE_EQ(h.world(3).offset, 2.0 * (1.0 + 3.0) + 1.0);
+
+    // Leaf only
+    h.set_local(4, { 1.0, 4.0 });
+    EXPECT_EQ(h.propagate(), 1u);
+    EXPECT_DOUBLE_EQ(h.world(4).offset, 2.0 * (1.0 + 4.0) + 1.0);
+
+    // Branch of 1, with a dirty node inside it visited once
+    h.set_local(3, { 1.0, 0.0 });
+    h.set_local(1, { 1.0, 0.0 });
+    EXPECT_EQ(h.dirty_count(), 2u);
+    std::vector<size_t> visited;
+    EXPECT_EQ(h.propagate([&](size_t i) { visited.push_back(i); }), 3u);
+    EXPECT_EQ(visited, (std::vector<size_t>{ h.index_of(1), h.index_of(3), h.index_of(4) }));
+    EXPECT_DOUBLE_EQ(h.world(3).offset, 1.0);
+
+    // Unrelated root
+    h.set_local(5, { 1.0, 6.0 });
+    EXPECT_EQ(h.propagate(), 1u);
+    expect_worlds(h);
+}
+
+TEST(TransformHierarchyTest, ReparentUnparentAndErase) {
+    Hierarchy h;
+    h.insert_as_root(0, { 2.0, 0.0 });
+    h.insert(1, 0, { 1.0, 1.0 });
+    h.insert(2, 1, { 1.0, 1.0 });
+    h.insert(3, 2, { 1.0, 1.0 });
+    h.insert_as_root(4, { 1.0, 10.0 });
+    h.insert(5, 4, { 1.0, 1.0 });
+    h.propagate();
+
+    EXPECT_FALSE(h.insert(1, 4, {}));           // Already present
+    EXPECT_FALSE(h.insert(6, 7, {}));           // Missing parent
+    EXPECT_FALSE(h.reparent(1, 3));             // Own descendant
+
+    // Move the branch of 1 under 5. The branch is rebuilt, the rest is not.
+    EXPECT_TRUE(h.reparent(1, 5));
+    expect_consistent(h);
+    EXPECT_EQ(h.branch_stride_at(h.index_of(0)), 1u);
+    EXPECT_EQ(h.branch_stride_at(h.index_of(4)), 5u);
+    EXPECT_EQ(h.parent_index_at(h.index_of(1)), h.index_of(5));
+    EXPECT_EQ(h.propagate(), 3u);
+    expect_worlds(h);
+    EXPECT_DOUBLE_EQ(h.world(3).offset, 10.0 + 4.0);
+
+    EXPECT_TRUE(h.unparent(2));
+    expect_consistent(h);
+    EXPECT_EQ(h.parent_index_at(h.index_of(2)), Hierarchy::null_index);
+    EXPECT_EQ(h.propagate(), 2u);
+    expect_worlds(h);
+
+    // Dirty nodes behind an erased branch keep their mark
+    h.set_local(3, { 1.0, 2.0 });
+    EXPECT_TRUE(h.erase_branch(4));
+    EXPECT_FALSE(h.contains(5));
+    EXPECT_FALSE(h.contains(1));
+    EXPECT_EQ(h.size(), 3u);
+    expect_consistent(h);
+    EXPECT_EQ(h.propagate(), 1u);
+    expect_worlds(h);
+    EXPECT_FALSE(h.erase_branch(4));
+}
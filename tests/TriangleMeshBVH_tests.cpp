@@ -0,0 +1,233 @@
+#include "TriangleMeshBVH.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Bumpy grid terrain of n x n quads, two triangles each, plus scattered free triangles
+    struct Mesh
+    {
+        std::vector<float> positions;
+        std::vector<uint32_t> indices;
+
+        uint32_t add(float x, float y, float z)
+        {
+            positions.insert(positions.end(), { x, y, z });
+            return uint32_t(positions.size() / 3 - 1);
+        }
+        size_t triangle_count() const { return indices.size() / 3; }
+        const float* vertex(size_t tri, int v) const { return &positions[3 * size_t(indices[3 * tri + v])]; }
+    };
+
+    Mesh make_mesh(std::mt19937& rng, int n)
+    {
+        std::uniform_real_distribution<float> pos(-20.0f, 20.0f), bump(-0.5f, 0.5f), size(-1.5f, 1.5f);
+        Mesh mesh;
+        for (int z = 0; z <= n; z++)
+            for (int x = 0; x <= n; x++)
+                mesh.add(float(x - n / 2), bump(rng), float(z - n / 2));
+        for (int z = 0; z < n; z++)
+            for (int x = 0; x < n; x++)
+            {
+                const uint32_t i = uint32_t(z * (n + 1) + x);
+                mesh.indices.insert(mesh.indices.end(), { i, i + n + 1, i + 1, i + 1, i + n + 1, i + n + 2 });
+            }
+        for (int t = 0; t < 200; t++)
+        {
+            const float c[3]{ pos(rng), pos(rng) * 0.25f + 3.0f, pos(rng) };
+            for (int v = 0; v < 3; v++)
+                mesh.indices.push_back(mesh.add(c[0] + size(rng), c[1] + size(rng), c[2] + size(rng)));
+        }
+        return mesh;
+    }
+
+    // Brute-force closest hit, same two-sided Moller-Trumbore as the tree
+    bool brute_raycast(const Mesh& mesh, const float o[3], const float d[3], float t_max, float& best)
+    {
+        bool found = false;
+        best = t_max;
+        for (size_t k = 0; k < mesh.triangle_count(); k++)
+        {
+            const float* a = mesh.vertex(k, 0);
+            const float* b = mesh.vertex(k, 1);
+            const float* c = mesh.vertex(k, 2);
+            const float e1[3]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] }, e2[3]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            const float p[3]{ d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+            const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+            if (std::abs(det) < 1e-12f) continue;
+            const float s[3]{ o[0] - a[0], o[1] - a[1], o[2] - a[2] };
+            const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+            const float q[3]{ s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+            const float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+            const float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+            if (u >= 0 && v >= 0 && u + v <= 1 && t >= 0 && t <= best)
+            {
+                best = t;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // Squared distance from p to triangle k, by sampling its barycentric grid finely
+    float sampled_distance2(const Mesh& mesh, size_t k, const float p[3])
+    {
+        const float* a = mesh.vertex(k, 0);
+        const float* b = mesh.vertex(k, 1);
+        const float* c = mesh.vertex(k, 2);
+        float best = INFINITY;
+        const int n = 40;
+        for (int i = 0; i <= n; i++)
+            for (int j = 0; i + j <= n; j++)
+            {
+                const float u = float(i) / n, v = float(j) / n;
+                float d2 = 0;
+                for (int x = 0; x < 3; x++)
+                {
+                    const float q = a[x] + u * (b[x] - a[x]) + v * (c[x] - a[x]) - p[x];
+                    d2 += q * q;
+                }
+                best = std::min(best, d2);
+            }
+        return best;
+    }
+}
+
+TEST(TriangleMeshBVHTest, EmptyMeshReportsNothing) {
+    eeng::TriangleMeshBVH bvh;
+    bvh.build(nullptr, nullptr, 0);
+    EXPECT_TRUE(bvh.empty());
+    const float o[3]{ 0, 1, 0 }, d[3]{ 0, -1, 0 };
+    eeng::TriangleHit hit;
+    EXPECT_FALSE(bvh.raycast(o, d, 10.0f, hit));
+    EXPECT_FALSE(bvh.any_hit(o, d, 10.0f));
+    EXPECT_FALSE(bvh.overlaps_sphere(o, 5.0f));
+}
+
+TEST(TriangleMeshBVHTest, RaycastMatchesBruteForce) {
+    std::mt19937 rng(11);
+    const Mesh mesh = make_mesh(rng, 40);
+    std::uniform_real_distribution<float> pos(-25.0f, 25.0f), dir(-1.0f, 1.0f);
+
+    for (bool quantized : { false, true })
+    {
+        eeng::TriangleMeshBVH bvh;
+        bvh.build(mesh.positions.data(), mesh.indices.data(), mesh.triangle_count(), quantized);
+        EXPECT_EQ(bvh.quantized(), quantized);
+        EXPECT_EQ(bvh.triangle_count(), mesh.triangle_count());
+
+        for (int r = 0; r < 300; r++)
+        {
+            const float o[3]{ pos(rng), pos(rng) * 0.3f + 2.0f, pos(rng) };
+            float d[3]{ dir(rng), dir(rng), dir(rng) };
+            const float len = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            for (float& x : d) x /= len;
+
+            float expected_t;
+            const bool expected = brute_raycast(mesh, o, d, 60.0f, expected_t);
+            eeng::TriangleHit hit;
+            ASSERT_EQ(bvh.raycast(o, d, 60.0f, hit), expected) << "ray " << r;
+            EXPECT_EQ(bvh.any_hit(o, d, 60.0f), expected);
+            if (!expected) continue;
+            EXPECT_NEAR(hit.t, expected_t, 1e-4f);
+
+            // The normal is a unit vector facing the ray
+            EXPECT_NEAR(hit.normal[0] * hit.normal[0] + hit.normal[1] * hit.normal[1] + hit.normal[2] * hit.normal[2], 1.0f, 1e-4f);
+            EXPECT_LE(hit.normal[0] * d[0] + hit.normal[1] * d[1] + hit.normal[2] * d[2], 0.0f);
+        }
+    }
+}
+
+TEST(TriangleMeshBVHTest, DownwardRayFindsGroundHeight) {
+    // Two triangles spanning [-1, 1]^2 on a slope y = x
+    const float positions[]{ -1, -1, -1,  1, 1, -1,  1, 1, 1,  -1, -1, 1 };
+    const uint32_t indices[]{ 0, 1, 2,  0, 2, 3 };
+    eeng::TriangleMeshBVH bvh;
+    bvh.build(positions, indices, 2);
+
+    const float o[3]{ 0.5f, 5.0f, 0.25f }, down[3]{ 0, -1, 0 };
+    eeng::TriangleHit hit;
+    ASSERT_TRUE(bvh.raycast(o, down, 10.0f, hit));
+    EXPECT_NEAR(o[1] - hit.t, 0.5f, 1e-5f);
+    EXPECT_GT(hit.normal[1], 0.0f);
+
+    // A ray that stops short of the surface does not hit it
+    EXPECT_FALSE(bvh.any_hit(o, down, 4.0f));
+}
+
+TEST(TriangleMeshBVHTest, SphereQueryMatchesBruteForce) {
+    std::mt19937 rng(5);
+    const Mesh mesh = make_mesh(rng, 16);
+    std::uniform_real_distribution<float> pos(-15.0f, 15.0f), radius(0.2f, 2.0f);
+
+    for (bool quantized : { false, true })
+    {
+        eeng::TriangleMeshBVH bvh;
+        bvh.build(mesh.positions.data(), mesh.indices.data(), mesh.triangle_count(), quantized);
+
+        for (int q = 0; q < 30; q++)
+        {
+            const float c[3]{ pos(rng), pos(rng) * 0.2f + 1.0f, pos(rng) };
+            const float r = radius(rng);
+
+            std::vector<uint32_t> found;
+            bvh.query_sphere(c, r, [&](uint32_t tri, const float closest[3]) {
+                found.push_back(tri);
+                const float d2 = (closest[0] - c[0]) * (closest[0] - c[0]) + (closest[1] - c[1]) * (closest[1] - c[1]) + (closest[2] - c[2]) * (closest[2] - c[2]);
+                EXPECT_NEAR(d2, sampled_distance2(mesh, tri, c), 0.01f);
+            });
+            EXPECT_EQ(bvh.overlaps_sphere(c, r), !found.empty());
+
+            // Triangles clearly inside or outside the sphere must be classified the same way
+            std::sort(found.begin(), found.end());
+            for (size_t k = 0; k < mesh.triangle_count(); k++)
+            {
+                const float d = std::sqrt(sampled_distance2(mesh, k, c));
+                const bool reported = std::binary_search(found.begin(), found.end(), uint32_t(k));
+                if (d < r - 0.05f) { EXPECT_TRUE(reported) << "triangle " << k; }
+                if (d > r + 0.05f) { EXPECT_FALSE(reported) << "triangle " << k; }
+            }
+        }
+    }
+}
+
+TEST(TriangleMeshBVHTest, AABBQueryUsesExactTriangleTest) {
+    // A triangle whose bounds overlap the box while the triangle itself passes beside it
+    const float positions[]{ 0, 0, 0,  4, 0, 0,  0, 4, 0 };
+    const uint32_t indices[]{ 0, 1, 2 };
+    eeng::TriangleMeshBVH bvh;
+    bvh.build(positions, indices, 1);
+
+    const float corner_min[3]{ 3, 3, -1 }, corner_max[3]{ 4, 4, 1 };
+    EXPECT_FALSE(bvh.overlaps_aabb(corner_min, corner_max));
+
+    const float inner_min[3]{ 0.5f, 0.5f, -1 }, inner_max[3]{ 1, 1, 1 };
+    EXPECT_TRUE(bvh.overlaps_aabb(inner_min, inner_max));
+
+    const float above_min[3]{ 0.5f, 0.5f, 0.1f }, above_max[3]{ 1, 1, 1 };
+    EXPECT_FALSE(bvh.overlaps_aabb(above_min, above_max));
+}
+
+TEST(TriangleMeshBVHTest, QuantizedNodesAreHalfTheSize) {
+    std::mt19937 rng(3);
+    const Mesh mesh = make_mesh(rng, 32);
+    eeng::TriangleMeshBVH full, quantized;
+    full.build(mesh.positions.data(), mesh.indices.data(), mesh.triangle_count(), false);
+    quantized.build(mesh.positions.data(), mesh.indices.data(), mesh.triangle_count(), true);
+
+    EXPECT_EQ(full.node_count(), quantized.node_count());
+    const size_t triangle_bytes = mesh.triangle_count() * (9 * sizeof(float) + sizeof(uint32_t));
+    EXPECT_EQ(full.memory_usage() - triangle_bytes, 2 * (quantized.memory_usage() - triangle_bytes));
+
+    // Every triangle ends up in exactly one leaf
+    for (uint32_t k = 0; k < mesh.triangle_count(); k += 97)
+    {
+        const float* v = quantized.triangle_vertices(k);
+        ASSERT_NE(v, nullptr);
+        EXPECT_EQ(v[0], mesh.vertex(k, 0)[0]);
+        EXPECT_EQ(v[8], mesh.vertex(k, 2)[2]);
+    }
+}